@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+
+## =================================================================
+## PAGE SIZE BENCHMARK
+##
+## The page size is fixed at build time through BUSTUB_PAGE_SIZE.
+## This script builds the benchmarks once per supported page size
+## and runs the page size benchmark with each build.
+##
+## Usage: build_support/bench_page_sizes.sh [BUILD_ROOT]
+## =================================================================
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_ROOT=${1:-"$ROOT/build-page-sizes"}
+
+for PAGE_SIZE in 4096 8192 16384 32768; do
+  BUILD_DIR="$BUILD_ROOT/$PAGE_SIZE"
+  cmake -S "$ROOT" -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release -DBUSTUB_PAGE_SIZE="$PAGE_SIZE" > /dev/null
+  cmake --build "$BUILD_DIR" --target buffer_pool_manager_bench_test -j"$(nproc)" > /dev/null
+  (cd "$BUILD_DIR/test" && ./buffer_pool_manager_bench_test --gtest_also_run_disabled_tests \
+    --gtest_filter='BufferPoolManagerBenchTest.DISABLED_PageSizeTest' | grep -v '^\[\|^Running\|^Note\|^$')
+done
@@ -12,53 +12,71 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+
 #include "common/macros.h"
 
 #include "common/logger.h"
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, ReplacerPolicy policy)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, policy) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerPolicy policy, size_t max_borrowed_frames)
     : pool_size_(pool_size),
       num_instances_(num_instances),
       instance_index_(instance_index),
-      next_page_id_(instance_index),
       disk_manager_(disk_manager),
       log_manager_(log_manager) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  // We allocate a consecutive memory space for the buffer pool. The instances of a parallel BPM spread their frames
+  // over the NUMA nodes.
+  int numa_node = num_instances_ > 1 ? static_cast<int>(instance_index_) % FrameArena::NumNumaNodes() : -1;
+  // The frames that may be borrowed are mapped up front, they only take memory once they are used.
+  arena_ = std::make_unique<FrameArena>(pool_size_ + max_borrowed_frames, numa_node);
+  pages_ = arena_->GetPages();
+  replacer_ = Replacer::Create(policy, pool_size + max_borrowed_frames);
+  // a reopened database file keeps its pages; new ids start after every block that holds one of them, and the free
+  // pages among them are reused through the free space map
+  const page_id_t num_pages = disk_manager_->GetNumPages();
+  next_block_ = (num_pages + static_cast<page_id_t>(num_instances_) - 1) / static_cast<page_id_t>(num_instances_);
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
     free_list_.emplace_back(static_cast<int>(i));
   }
+  for (size_t i = pool_size_ + max_borrowed_frames; i > pool_size_; --i) {
+    reserve_frames_.emplace_back(static_cast<int>(i - 1));
+  }
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
-  delete replacer_;
+  StopPageCleaner();
+  // prefetch reads still write into the frames
+  for (auto &[page_id, prefetch] : prefetching_) {
+    prefetch.read_.wait();
+  }
 }
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
   // Make sure you call DiskManager::WritePage!
-  std::unique_lock lck(latch_);
+  auto lck = LockLatch();
   // page in buffer pool
-  if (page_table_.find(page_id) == page_table_.end()) {
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
     return false;
   }
-  auto &page = pages_[page_table_[page_id]];
+  auto &page = pages_[frame_id];
   // flush if page is dirty;
   if (page.is_dirty_) {
     // LOG_DEBUG("# Instance %d, Pages: %d, data(write_back):%s\n",instance_index_, page.page_id_,page.data_);
+    WaitForCleaning(page_id);
     disk_manager_->WritePage(page_id, page.data_);
     page.is_dirty_ = false;
   }
@@ -66,49 +84,88 @@ auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  // You can do it!
-  std::unique_lock lck(latch_);
-  for (auto [page_id, frame_id] : page_table_) {
-    auto &page = pages_[frame_id];
-    if (page.is_dirty_) {
-      // LOG_DEBUG("# Instance %d, Pages: %d, data(write_back):%s\n",instance_index_, page.page_id_,page.data_);
-      disk_manager_->WritePage(page_id, page.data_);
+  std::vector<DirtyPage> dirty_pages;
+  CollectDirtyPages(&dirty_pages);
+  std::sort(dirty_pages.begin(), dirty_pages.end(),
+            [](const DirtyPage &a, const DirtyPage &b) { return a.page_id_ < b.page_id_; });
+  WriteDirtyPages(disk_manager_, dirty_pages.data(), dirty_pages.size());
+  ReleaseDirtyPages(dirty_pages);
+  disk_manager_->Sync();
+}
+
+void BufferPoolManagerInstance::CollectDirtyPages(std::vector<DirtyPage> *dirty_pages) {
+  std::vector<std::shared_future<bool>> cleaning;
+  {
+    auto lck = LockLatch();
+    // the shard latch held by ForEach keeps the frames from being evicted until they are pinned
+    page_table_.ForEach([&](page_id_t page_id, frame_id_t frame_id) {
+      auto &page = pages_[frame_id];
+      if (!page.is_dirty_) {
+        return;
+      }
+      PinFrame(frame_id);
       page.is_dirty_ = false;
+      dirty_pages->push_back({page_id, frame_id, &page});
+      // an older image the cleaner is still writing must not overtake ours
+      if (auto it = cleaning_.find(page_id); it != cleaning_.end()) {
+        cleaning.push_back(it->second);
+      }
+    });
+  }
+  for (auto &write : cleaning) {
+    write.wait();
+  }
+}
+
+void BufferPoolManagerInstance::ReleaseDirtyPages(const std::vector<DirtyPage> &dirty_pages) {
+  for (const auto &dirty_page : dirty_pages) {
+    if (dirty_page.page_->pin_count_.fetch_sub(1) == 1) {
+      replacer_->Unpin(dirty_page.frame_id_);
+    }
+  }
+}
+
+void BufferPoolManagerInstance::WriteDirtyPages(DiskManager *disk_manager, const DirtyPage *dirty_pages,
+                                                size_t num_pages) {
+  std::vector<const char *> run;
+  for (size_t first = 0; first < num_pages;) {
+    size_t last = first;
+    run.clear();
+    do {
+      run.push_back(dirty_pages[last].page_->data_);
+      last++;
+    } while (last < num_pages && dirty_pages[last].page_id_ == dirty_pages[last - 1].page_id_ + 1);
+    if (!disk_manager->WritePages(dirty_pages[first].page_id_, run.data(), run.size())) {
+      for (size_t i = first; i < last; i++) {
+        dirty_pages[i].page_->is_dirty_ = true;
+      }
     }
+    first = last;
   }
 }
 
-auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
+auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * { return NewPgInRingImp(page_id, nullptr); }
+
+auto BufferPoolManagerInstance::NewPgInRingImp(page_id_t *page_id, BufferRing *ring) -> Page * {
   // 0.   Make sure you call AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  std::unique_lock lck(latch_);
-  // Try to fetch
+  auto lck = LockLatch();
   frame_id_t frame_id;
-  if (!free_list_.empty()) {
-    frame_id = free_list_.back();
-    free_list_.pop_back();
-    // LOG_DEBUG("# Instance %d, Get Frame: %d in free_list", instance_index_,frame_id);
-  } else {
-    if (!replacer_->Victim(&frame_id)) {
-      *page_id = INVALID_PAGE_ID;
-      return nullptr;
-    }
-    auto victim_page_id = pages_[frame_id].page_id_;
-    // LOG_DEBUG("# Instance %d, Victim Frame: %d (Page %d) in replacer",instance_index_, frame_id, victim_page_id);
-    page_table_.erase(victim_page_id);
+  if (!GetVictimFrame(&frame_id, ring)) {
+    new_page_failures_.Add();
+    *page_id = INVALID_PAGE_ID;
+    return nullptr;
   }
   // reset P's metadata, zero out memory, dirty is true(can be write-back later);
-  // Allocate (if return nullptr, )
   page_id_t new_page_id = AllocatePage();
   *page_id = new_page_id;
-  auto &page = pages_[frame_id];
-  if (page.is_dirty_) {
-    // LOG_DEBUG("# Instance %d, Old Page: %d, data(write-back): %s",instance_index_, page.page_id_,page.data_);
-    disk_manager_->WritePage(page.page_id_, page.data_);
+  if (ring != nullptr) {
+    ring->GetInstanceRing(this).Fill(new_page_id, frame_id);
   }
+  auto &page = pages_[frame_id];
   // Different with FetchPgImp(read from disk)
   page.ResetMemory();
   page.page_id_ = new_page_id;
@@ -116,13 +173,14 @@ auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
   // set pinned, since it a new page, no need to call replacer_->Pin()
   page.pin_count_ = 1;
   page.is_dirty_ = false;
-  // Add P to the page table;
-  // lck.lock();
-  page_table_[new_page_id] = frame_id;
+  // Add P to the page table, only now it becomes visible to the fast path
+  page_table_.Insert(new_page_id, frame_id);
   return &page;
 }
 
-auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
+auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * { return FetchPgInRingImp(page_id, nullptr); }
+
+auto BufferPoolManagerInstance::FetchPgInRingImp(page_id_t page_id, BufferRing *ring) -> Page * {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -130,45 +188,87 @@ auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  std::unique_lock lck(latch_);
-  // in buffer bool, directly return
-  if (page_table_.find(page_id) != page_table_.end()) {
-    // LOG_DEBUG("# Instance %d, Page %d in buffer pool",instance_index_, page_id);
-    frame_id_t frame_id = page_table_[page_id];
-    pages_[frame_id].pin_count_++;
-    replacer_->Pin(frame_id);
+  frame_id_t frame_id;
+  // fast path: in buffer pool, pin it under the shard latch only
+  auto pin = [this, &frame_id](frame_id_t fid) {
+    frame_id = fid;
+    PinFrame(fid);
+    return true;
+  };
+  if (page_table_.FindAndApply(page_id, pin)) {
+    hits_.Add();
     return &pages_[frame_id];
   }
-  frame_id_t frame_id;
-  // find in free_list first
-  if (!free_list_.empty()) {
-    frame_id = free_list_.back();
-    free_list_.pop_back();
-    // LOG_DEBUG("# Instance %d, Get Frame %d from free_list",instance_index_, frame_id);
-  } else {
-    // all pages in buffer pool are pinned
-    if (!replacer_->Victim(&frame_id)) {
-      return nullptr;
+  auto lck = LockLatch();
+  ReapPrefetches();
+  while (true) {
+    // someone else may have read P in while we were waiting for the latch
+    if (page_table_.FindAndApply(page_id, pin)) {
+      hits_.Add();
+      return &pages_[frame_id];
+    }
+    // someone else is reading P in right now, share its read instead of issuing another one
+    if (auto it = loading_.find(page_id); it != loading_.end()) {
+      hits_.Add();
+      frame_id = it->second.first;
+      // the loader holds a pin, so the frame cannot go away under us
+      pages_[frame_id].pin_count_++;
+      // nobody waits for a prefetch, so we install P ourselves
+      if (auto prefetch_it = prefetching_.find(page_id); prefetch_it != prefetching_.end()) {
+        Prefetch prefetch = std::move(prefetch_it->second);
+        prefetching_.erase(prefetch_it);
+        lck.unlock();
+        prefetch.read_.wait();
+        lck.lock();
+        InstallPage(page_id, frame_id);
+        lck.unlock();
+        prefetch.installed_.set_value();
+        // drop the pin of the prefetch, ours keeps the frame pinned
+        pages_[frame_id].pin_count_--;
+        return &pages_[frame_id];
+      }
+      auto installed = it->second.second;
+      lck.unlock();
+      installed.wait();
+      return &pages_[frame_id];
     }
-    auto victim_page_id = pages_[frame_id].page_id_;
-    // LOG_DEBUG("# Instance %d, Victim Frame %d(Page  %d) from replacer",instance_index_, frame_id,victim_page_id);
-    page_table_.erase(victim_page_id);
+    // P was evicted while the cleaner was writing it out, wait for that write to land before reading P back in
+    auto it = cleaning_.find(page_id);
+    if (it == cleaning_.end()) {
+      break;
+    }
+    auto written = it->second;
+    lck.unlock();
+    written.wait();
+    lck.lock();
   }
-  auto &page = pages_[frame_id];
-  // if R is dirty(from the replacer), write out
-  if (page.is_dirty_) {
-    //  LOG_DEBUG("#Instance %d, Page: %d, data(write_back): %s",instance_index_,page.page_id_,page.data_);
-    disk_manager_->WritePage(page.page_id_, page.data_);
+  // find in free_list first, then the replacer; R is written back if dirty
+  if (!GetVictimFrame(&frame_id, ring)) {
+    fetch_failures_.Add();
+    return nullptr;
   }
-  // Update P
-  disk_manager_->ReadPage(page_id, page.data_);
-  // LOG_DEBUG("# Instance %d, Page %d, data(read_from): %s",instance_index_,page_id,page.data_);
+  misses_.Add();
+  if (ring != nullptr) {
+    ring->GetInstanceRing(this).Fill(page_id, frame_id);
+  }
+  auto &page = pages_[frame_id];
+  // Update P. The frame is pinned but not in the page table yet, so nobody else can touch it while we wait for the
+  // disk without holding the latch.
   page.page_id_ = page_id;
   // set pinned, since its new, no need to call replacer_.Pin()
   page.pin_count_ = 1;
   page.is_dirty_ = false;
-  // update page_table_
-  page_table_[page_id] = frame_id;
+  std::future<bool> read = disk_manager_->ReadPageAsync(page_id, page.data_);
+  std::promise<void> installed;
+  loading_.emplace(page_id, std::make_pair(frame_id, installed.get_future().share()));
+  lck.unlock();
+  read.wait();
+  // LOG_DEBUG("# Instance %d, Page %d, data(read_from): %s",instance_index_,page_id,page.data_);
+  lck.lock();
+  InstallPage(page_id, frame_id);
+  lck.unlock();
+  // waiters may only return P once it can be found in the page table, otherwise their unpin would be lost
+  installed.set_value();
   return &page;
 }
 
@@ -178,58 +278,393 @@ auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  std::unique_lock lck(latch_);
+  auto lck = LockLatch();
+  ReapPrefetches();
+  // still being read in, so it is pinned
+  if (loading_.count(page_id) != 0) {
+    return false;
+  }
+  frame_id_t frame_id;
   // not in buffer pool, just deallocate
-  if (page_table_.find(page_id) == page_table_.end()) {
+  if (!page_table_.Find(page_id, &frame_id)) {
     DeallocatePage(page_id);
     return true;
   }
-  auto frame_id = page_table_[page_id];
-  // lck.unlock();
-  auto &page = pages_[frame_id];
-  if (page.pin_count_ > 0) {
+  // erase only if nobody pinned it through the fast path in the meantime
+  if (!page_table_.EraseIf(page_id, [this](frame_id_t fid) { return pages_[fid].pin_count_ == 0; })) {
     return false;
   }
+  auto &page = pages_[frame_id];
+  replacer_->Remove(frame_id);
   page.ResetMemory();
   page.page_id_ = INVALID_PAGE_ID;
   page.is_dirty_ = false;
-  // TODO(jiyuanz) check if race condition(delete,new,fetch)
-  page_table_.erase(page_id);
   DeallocatePage(page_id);
   free_list_.emplace_back(frame_id);
   return true;
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  std::unique_lock lck(latch_);
-  if (page_table_.find(page_id) == page_table_.end()) {
-    return false;
+  frame_id_t frame_id;
+  bool unpinned_last = false;
+  bool found = page_table_.FindAndApply(page_id, [&](frame_id_t fid) {
+    frame_id = fid;
+    auto &page = pages_[fid];
+    int pin_count = page.pin_count_;
+    do {
+      if (pin_count <= 0) {
+        // LOG_DEBUG("#Instance %d, Cannot unpin Page: %d",instance_index_, page_id);
+        return false;
+      }
+      // mark dirty before dropping the pin, so that an evictor never sees a clean unpinned frame we wrote to
+      if (is_dirty) {
+        page.is_dirty_ = true;
+      }
+    } while (!page.pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+    unpinned_last = pin_count == 1;
+    return true;
+  });
+  if (found && unpinned_last) {
+    // LOG_DEBUG("#Instance %d,  Unpin Page: %d in replacer",instance_index_, page_id);
+    replacer_->Unpin(frame_id);
   }
-  frame_id_t frame_id = page_table_[page_id];
+  return found;
+}
+
+void BufferPoolManagerInstance::PinFrame(frame_id_t frame_id) {
+  // The replacer calls happen outside of any latch that orders them with concurrent pins and unpins, so the replacer
+  // may briefly hold a pinned frame. GetVictimFrame re-checks the pin count before it evicts anything.
   auto &page = pages_[frame_id];
-  if (pages_[frame_id].pin_count_ <= 0) {
-    // LOG_DEBUG("#Instance %d, Cannot unpin Page: %d",instance_index_, page_id);
-    return false;
+  if (page.pin_count_.fetch_add(1) == 0) {
+    replacer_->Pin(frame_id);
+    // The pin may have been dropped again, and the last unpin may have handed the frame back to the replacer before
+    // the Pin above took it out. Put it back, or the frame is never evicted again. Any unpin that reaches zero later
+    // than this read calls Unpin itself.
+    if (page.pin_count_ == 0) {
+      replacer_->Unpin(frame_id);
+    }
   }
-  page.is_dirty_ |= is_dirty;
-  page.pin_count_--;
-  if (page.pin_count_ == 0) {
-    // LOG_DEBUG("#Instance %d,  Unpin Page: %d in replacer",instance_index_, page_id);
-    replacer_->Unpin(frame_id);
+}
+
+auto BufferPoolManagerInstance::GetVictimFrame(frame_id_t *frame_id, BufferRing *ring) -> bool {
+  if (ring != nullptr) {
+    auto &slot = ring->GetInstanceRing(this).Current();
+    auto &page = pages_[slot.frame_id_];
+    // recycle the frame only if it still holds the page the ring brought in, and nobody else is using it
+    if (slot.page_id_ != INVALID_PAGE_ID && page_table_.EraseIf(slot.page_id_, [&slot, &page](frame_id_t fid) {
+          return fid == slot.frame_id_ && page.pin_count_ == 0;
+        })) {
+      replacer_->Remove(slot.frame_id_);
+      evictions_.Add();
+      if (page.is_dirty_) {
+        dirty_evictions_.Add();
+        WaitForCleaning(slot.page_id_);
+        disk_manager_->WritePage(slot.page_id_, page.data_);
+        page.is_dirty_ = false;
+      }
+      *frame_id = slot.frame_id_;
+      return true;
+    }
   }
-  // LOG_DEBUG("#Instance %d, page_table size: %lu",instance_index_, page_table_.size());
-  return true;
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.back();
+    free_list_.pop_back();
+    // LOG_DEBUG("# Instance %d, Get Frame: %d in free_list", instance_index_,*frame_id);
+    return true;
+  }
+  ReapPrefetches();
+  while (true) {
+    if (!replacer_->Victim(frame_id)) {
+      if (prefetching_.empty()) {
+        // every frame is pinned, take one out of the reserve if a neighbour has a free frame to spare
+        if (reserve_frames_.empty() || !frame_lender_ || !frame_lender_()) {
+          return false;
+        }
+        *frame_id = reserve_frames_.back();
+        reserve_frames_.pop_back();
+        frames_borrowed_.Add();
+        return true;
+      }
+      // every other frame is pinned, the frames of the prefetches come free once their reads are done
+      for (auto &[page_id, prefetch] : prefetching_) {
+        prefetch.read_.wait();
+      }
+      ReapPrefetches();
+      continue;
+    }
+    auto &page = pages_[*frame_id];
+    auto victim_frame_id = *frame_id;
+    // skip frames that were pinned through the fast path or already left the page table
+    if (!page_table_.EraseIf(page.page_id_, [&page, victim_frame_id](frame_id_t fid) {
+          return fid == victim_frame_id && page.pin_count_ == 0;
+        })) {
+      continue;
+    }
+    // LOG_DEBUG("# Instance %d, Victim Frame: %d (Page %d) in replacer",instance_index_, *frame_id, page.page_id_);
+    // if R is dirty(from the replacer), write out. This is what the page cleaner tries to avoid.
+    evictions_.Add();
+    if (page.is_dirty_) {
+      dirty_evictions_.Add();
+      cleaner_cv_.notify_one();
+      WaitForCleaning(page.page_id_);
+      disk_manager_->WritePage(page.page_id_, page.data_);
+      page.is_dirty_ = false;
+    }
+    return true;
+  }
+}
+
+void BufferPoolManagerInstance::PrefetchPgsImp(const std::vector<page_id_t> &page_ids, BufferRing *ring) {
+  // filter out resident pages without latch_, read-ahead mostly asks for pages that are already there
+  std::vector<page_id_t> missing;
+  frame_id_t frame_id;
+  for (auto page_id : page_ids) {
+    if (page_id != INVALID_PAGE_ID && static_cast<page_id_t>(page_id / num_instances_) < next_block_ &&
+        !page_table_.Find(page_id, &frame_id)) {
+      missing.emplace_back(page_id);
+    }
+  }
+  if (missing.empty()) {
+    return;
+  }
+  auto lck = LockLatch();
+  ReapPrefetches();
+  // in-flight prefetches pin their frames, leave most of the pool to the foreground
+  const size_t max_prefetching = std::max<size_t>(1, pool_size_ / 4);
+  // GetVictimFrame reaps finished reads, count against the prefetches in flight when the call started
+  size_t budget = max_prefetching - std::min(prefetching_.size(), max_prefetching);
+  for (auto page_id : missing) {
+    if (budget == 0) {
+      break;
+    }
+    if (page_table_.Find(page_id, &frame_id) || loading_.count(page_id) != 0 || cleaning_.count(page_id) != 0) {
+      continue;
+    }
+    if (!GetVictimFrame(&frame_id, ring)) {
+      break;
+    }
+    if (ring != nullptr) {
+      ring->GetInstanceRing(this).Fill(page_id, frame_id);
+    }
+    auto &page = pages_[frame_id];
+    page.page_id_ = page_id;
+    // the read holds a pin until the page is installed, like a miss does
+    page.pin_count_ = 1;
+    page.is_dirty_ = false;
+    prefetches_.Add();
+    Prefetch prefetch{disk_manager_->ReadPageAsync(page_id, page.data_), {}};
+    loading_.emplace(page_id, std::make_pair(frame_id, prefetch.installed_.get_future().share()));
+    prefetching_.emplace(page_id, std::move(prefetch));
+    budget--;
+  }
+}
+
+void BufferPoolManagerInstance::InstallPage(page_id_t page_id, frame_id_t frame_id) {
+  loading_.erase(page_id);
+  page_table_.Insert(page_id, frame_id);
+}
+
+void BufferPoolManagerInstance::ReapPrefetches() {
+  for (auto it = prefetching_.begin(); it != prefetching_.end();) {
+    if (it->second.read_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      ++it;
+      continue;
+    }
+    page_id_t page_id = it->first;
+    frame_id_t frame_id = loading_.at(page_id).first;
+    InstallPage(page_id, frame_id);
+    it->second.installed_.set_value();
+    it = prefetching_.erase(it);
+    // fetches may have pinned the page through the page table already
+    if (pages_[frame_id].pin_count_.fetch_sub(1) == 1) {
+      replacer_->Unpin(frame_id);
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  stats.hits_ = hits_.Get();
+  stats.misses_ = misses_.Get();
+  stats.fetch_failures_ = fetch_failures_.Get();
+  stats.new_page_failures_ = new_page_failures_.Get();
+  stats.evictions_ = evictions_.Get();
+  stats.dirty_evictions_ = dirty_evictions_.Get();
+  stats.cleaner_flushes_ = cleaner_flushes_.Get();
+  stats.prefetches_ = prefetches_.Get();
+  stats.frames_borrowed_ = frames_borrowed_.Get();
+  stats.frames_lent_ = frames_lent_.Get();
+  stats.latch_wait_ = latch_wait_.Snapshot();
+  return stats;
+}
+
+auto BufferPoolManagerInstance::LockLatch() -> std::unique_lock<std::mutex> {
+  // an uncontended latch costs no clock reads
+  std::unique_lock lck(latch_, std::try_to_lock);
+  if (lck.owns_lock()) {
+    latch_wait_.Record(std::chrono::steady_clock::duration::zero());
+    return lck;
+  }
+  LatencyHistogram::Timer timer(&latch_wait_);
+  lck.lock();
+  return lck;
+}
+
+void BufferPoolManagerInstance::WaitForCleaning(page_id_t page_id) {
+  if (auto it = cleaning_.find(page_id); it != cleaning_.end()) {
+    it->second.wait();
+  }
+}
+
+void BufferPoolManagerInstance::StartPageCleaner(size_t low_watermark, size_t high_watermark,
+                                                 std::chrono::milliseconds interval) {
+  if (cleaner_.joinable()) {
+    return;
+  }
+  cleaner_low_watermark_ = low_watermark;
+  cleaner_high_watermark_ = high_watermark;
+  cleaner_interval_ = interval;
+  cleaner_stop_ = false;
+  cleaner_ = std::thread([this] { PageCleanerLoop(); });
+}
+
+void BufferPoolManagerInstance::StopPageCleaner() {
+  if (!cleaner_.joinable()) {
+    return;
+  }
+  {
+    std::scoped_lock lck(cleaner_latch_);
+    cleaner_stop_ = true;
+  }
+  cleaner_cv_.notify_one();
+  cleaner_.join();
+}
+
+void BufferPoolManagerInstance::PageCleanerLoop() {
+  std::unique_lock lck(cleaner_latch_);
+  while (!cleaner_stop_) {
+    cleaner_cv_.wait_for(lck, cleaner_interval_);
+    if (cleaner_stop_) {
+      break;
+    }
+    lck.unlock();
+    if (NeedsCleaning()) {
+      CleanPages(cleaner_high_watermark_);
+    }
+    lck.lock();
+  }
+}
+
+auto BufferPoolManagerInstance::NeedsCleaning() -> bool {
+  std::vector<frame_id_t> candidates;
+  replacer_->PeekVictims(cleaner_high_watermark_, &candidates);
+  auto lck = LockLatch();
+  size_t clean = free_list_.size();
+  for (auto frame_id : candidates) {
+    if (!pages_[frame_id].is_dirty_) {
+      clean++;
+    }
+  }
+  return clean < cleaner_low_watermark_;
+}
+
+auto BufferPoolManagerInstance::CleanPages(size_t max_pages) -> size_t {
+  std::vector<frame_id_t> candidates;
+  replacer_->PeekVictims(max_pages, &candidates);
+  // The pages are written from private copies, so the frames can be pinned, modified or evicted while the writes are
+  // in flight. A frame modified in the meantime is simply dirty again.
+  std::vector<char> copies(candidates.size() * PAGE_SIZE);
+  std::vector<std::pair<page_id_t, std::shared_future<bool>>> writes;
+  {
+    auto lck = LockLatch();
+    for (auto frame_id : candidates) {
+      auto &page = pages_[frame_id];
+      page_id_t page_id = page.page_id_;
+      if (cleaning_.count(page_id) != 0) {
+        continue;
+      }
+      char *copy = copies.data() + writes.size() * PAGE_SIZE;
+      // an unpinned page is not latched by anyone, and the exclusive shard latch keeps the fast path from pinning it
+      // while we copy it
+      bool copied = page_table_.FindAndApplyExclusive(page_id, [&page, frame_id, copy](frame_id_t fid) {
+        if (fid != frame_id || page.pin_count_ != 0 || !page.is_dirty_) {
+          return false;
+        }
+        memcpy(copy, page.data_, PAGE_SIZE);
+        page.is_dirty_ = false;
+        return true;
+      });
+      if (!copied) {
+        continue;
+      }
+      auto written = disk_manager_->WritePageAsync(page_id, copy).share();
+      cleaning_.emplace(page_id, written);
+      writes.emplace_back(page_id, written);
+    }
+  }
+  for (auto &write : writes) {
+    write.second.wait();
+  }
+  {
+    auto lck = LockLatch();
+    for (auto &write : writes) {
+      cleaning_.erase(write.first);
+    }
+  }
+  cleaner_flushes_.Add(writes.size());
+  return writes.size();
 }
 
 auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
-  const page_id_t next_page_id = next_page_id_;
-  next_page_id_ += num_instances_;
+  // reuse the lowest free page first, which keeps the database file compact and its pages in ascending runs
+  auto *free_space_map = disk_manager_->GetFreeSpaceMap();
+  const auto allocated_end = static_cast<page_id_t>(next_block_ * num_instances_);
+  page_id_t page_id = reuse_from_;
+  while ((page_id = free_space_map->FindFree(page_id, allocated_end)) != INVALID_PAGE_ID) {
+    // pages of other instances are skipped, they are only reused by their own instance
+    if (InstanceOf(page_id, num_instances_) == instance_index_ && free_space_map->Claim(page_id)) {
+      reuse_from_ = page_id + 1;
+      return page_id;
+    }
+    page_id++;
+  }
+  reuse_from_ = allocated_end;
+
+  const auto block = static_cast<uint32_t>(next_block_.fetch_add(1));
+  // the id of the block that InstanceOf maps to this instance
+  const uint32_t rotation = BlockRotation(block) % num_instances_;
+  const auto next_page_id =
+      static_cast<page_id_t>(block * num_instances_ + (instance_index_ + num_instances_ - rotation) % num_instances_);
   ValidatePageId(next_page_id);
   return next_page_id;
 }
 
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  // ids this instance never handed out must not come out of AllocatePage twice
+  if (page_id == INVALID_PAGE_ID || page_id / static_cast<page_id_t>(num_instances_) >= next_block_) {
+    return;
+  }
+  ValidatePageId(page_id);
+  disk_manager_->DeallocatePage(page_id);
+  reuse_from_ = std::min(reuse_from_, page_id);
+}
+
+auto BufferPoolManagerInstance::LendFrame() -> bool {
+  std::unique_lock lck(latch_, std::try_to_lock);
+  if (!lck.owns_lock() || free_list_.empty()) {
+    return false;
+  }
+  frame_id_t frame_id = free_list_.back();
+  free_list_.pop_back();
+  arena_->Discard(frame_id);
+  // this instance may take the frame back out of its reserve later, when it is short of frames itself
+  reserve_frames_.emplace_back(frame_id);
+  frames_lent_.Add();
+  return true;
+}
+
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
-  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
+  assert(InstanceOf(page_id, num_instances_) == instance_index_);  // allocated pages map back to this BPI
 }
 
 }  // namespace bustub
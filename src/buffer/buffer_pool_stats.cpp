@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace bustub {
+
+auto BufferPoolStats::HitRatio() const -> double {
+  uint64_t fetches = hits_ + misses_;
+  return fetches == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches);
+}
+
+auto BufferPoolStats::operator+=(const BufferPoolStats &other) -> BufferPoolStats & {
+  hits_ += other.hits_;
+  misses_ += other.misses_;
+  fetch_failures_ += other.fetch_failures_;
+  new_page_failures_ += other.new_page_failures_;
+  evictions_ += other.evictions_;
+  dirty_evictions_ += other.dirty_evictions_;
+  cleaner_flushes_ += other.cleaner_flushes_;
+  prefetches_ += other.prefetches_;
+  frames_borrowed_ += other.frames_borrowed_;
+  frames_lent_ += other.frames_lent_;
+  latch_wait_ += other.latch_wait_;
+  return *this;
+}
+
+auto BufferPoolStats::ToString() const -> std::string {
+  std::ostringstream os;
+  os << "hits: " << hits_ << "\n"
+     << "misses: " << misses_ << "\n"
+     << "hit ratio: " << std::fixed << std::setprecision(4) << HitRatio() << "\n"
+     << "fetch failures: " << fetch_failures_ << "\n"
+     << "new page failures: " << new_page_failures_ << "\n"
+     << "evictions: " << evictions_ << "\n"
+     << "dirty evictions: " << dirty_evictions_ << "\n"
+     << "cleaner flushes: " << cleaner_flushes_ << "\n"
+     << "prefetches: " << prefetches_ << "\n"
+     << "frames borrowed: " << frames_borrowed_ << "\n"
+     << "frames lent: " << frames_lent_ << "\n"
+     << "latch wait: " << latch_wait_.ToString() << "\n";
+  return os.str();
+}
+
+auto BufferPoolStats::ToJson() const -> std::string {
+  std::ostringstream os;
+  os << "{\"hits\": " << hits_ << ", \"misses\": " << misses_ << ", \"fetch_failures\": " << fetch_failures_
+     << ", \"new_page_failures\": " << new_page_failures_ << ", \"evictions\": " << evictions_
+     << ", \"dirty_evictions\": " << dirty_evictions_ << ", \"cleaner_flushes\": " << cleaner_flushes_
+     << ", \"prefetches\": " << prefetches_ << ", \"frames_borrowed\": " << frames_borrowed_
+     << ", \"frames_lent\": " << frames_lent_ << ", \"latch_wait\": " << latch_wait_.ToJson() << "}";
+  return os.str();
+}
+
+}  // namespace bustub
@@ -14,16 +14,67 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_pages_(num_pages), states_(std::make_unique<std::atomic<uint8_t>[]>(num_pages)) {
+  for (size_t i = 0; i < num_pages_; i++) {
+    states_[i].store(0, std::memory_order_relaxed);
+  }
+}
 
 ClockReplacer::~ClockReplacer() = default;
 
-auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool {
+  while (size_.load(std::memory_order_acquire) > 0) {
+    auto frame = static_cast<frame_id_t>(hand_.fetch_add(1, std::memory_order_relaxed) % num_pages_);
+    auto &state = states_[frame];
+    uint8_t current = state.load(std::memory_order_acquire);
+    if ((current & EVICTABLE) == 0) {
+      continue;
+    }
+    if ((current & REFERENCED) != 0) {
+      // second chance; if the CAS loses against a concurrent pin, the hand comes back later anyway
+      state.compare_exchange_strong(current, current & ~REFERENCED, std::memory_order_acq_rel);
+      continue;
+    }
+    if (state.compare_exchange_strong(current, 0, std::memory_order_acq_rel)) {
+      size_.fetch_sub(1, std::memory_order_acq_rel);
+      *frame_id = frame;
+      return true;
+    }
+  }
+  return false;
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  uint8_t old = states_[frame_id].fetch_and(static_cast<uint8_t>(~EVICTABLE), std::memory_order_acq_rel);
+  if ((old & EVICTABLE) != 0) {
+    size_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  uint8_t old = states_[frame_id].fetch_or(EVICTABLE | REFERENCED, std::memory_order_acq_rel);
+  if ((old & EVICTABLE) == 0) {
+    size_.fetch_add(1, std::memory_order_acq_rel);
+  }
+}
 
-auto ClockReplacer::Size() -> size_t { return 0; }
+auto ClockReplacer::Size() -> size_t {
+  int64_t size = size_.load(std::memory_order_acquire);
+  return size < 0 ? 0 : static_cast<size_t>(size);
+}
+
+void ClockReplacer::PeekVictims(size_t max_frames, std::vector<frame_id_t> *frames) {
+  // approximate: unreferenced frames in clock order from the hand, then the referenced ones
+  size_t start = hand_.load(std::memory_order_relaxed) % num_pages_;
+  for (uint8_t wanted : {EVICTABLE, static_cast<uint8_t>(EVICTABLE | REFERENCED)}) {
+    for (size_t i = 0; i < num_pages_ && frames->size() < max_frames; i++) {
+      size_t frame = (start + i) % num_pages_;
+      if (states_[frame].load(std::memory_order_relaxed) == wanted) {
+        frames->emplace_back(static_cast<frame_id_t>(frame));
+      }
+    }
+  }
+}
 
 }  // namespace bustub
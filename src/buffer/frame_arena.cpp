@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <new>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames, int numa_node) : num_frames_(num_frames), numa_node_(numa_node) {
+  data_ = static_cast<char *>(Map(num_frames_ * PAGE_SIZE, true, &data_size_, &huge_tlb_));
+  bool unused;
+  void *pages = Map(num_frames_ * sizeof(Page), false, &pages_size_, &unused);
+  if (data_ == nullptr || pages == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't map the buffer pool frames");
+  }
+  pages_ = static_cast<Page *>(pages);
+  for (size_t i = 0; i < num_frames_; i++) {
+    new (pages_ + i) Page(data_ + i * PAGE_SIZE);
+  }
+}
+
+FrameArena::~FrameArena() {
+  for (size_t i = 0; i < num_frames_; i++) {
+    pages_[i].~Page();
+  }
+  munmap(pages_, pages_size_);
+  munmap(data_, data_size_);
+}
+
+void FrameArena::Discard(size_t frame_id) {
+  if (!huge_tlb_) {
+    madvise(data_ + frame_id * PAGE_SIZE, PAGE_SIZE, MADV_DONTNEED);
+  }
+}
+
+auto FrameArena::Map(size_t size, bool huge, size_t *mapped_size, bool *huge_tlb) -> void * {
+  size = std::max<size_t>(size, 1);
+  *huge_tlb = false;
+  // only pools of at least one huge page are worth it, smaller ones would waste most of it
+  if (huge && size >= HUGE_PAGE_SIZE) {
+    *mapped_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *addr = mmap(nullptr, *mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED) {
+      *huge_tlb = true;
+      Bind(addr, *mapped_size);
+      return addr;
+    }
+    // no huge pages reserved, ask for transparent ones instead
+  }
+  auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  *mapped_size = (size + page_size - 1) / page_size * page_size;
+  void *addr = mmap(nullptr, *mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+  if (huge && size >= HUGE_PAGE_SIZE) {
+    madvise(addr, *mapped_size, MADV_HUGEPAGE);
+  }
+  Bind(addr, *mapped_size);
+  return addr;
+}
+
+void FrameArena::Bind(void *addr, size_t size) {
+  if (numa_node_ < 0) {
+    return;
+  }
+  // preferred rather than bound, so that a full node spills over instead of failing the allocation
+  unsigned long nodemask = 1UL << numa_node_;  // NOLINT
+  if (syscall(SYS_mbind, addr, size, MPOL_PREFERRED, &nodemask, sizeof(nodemask) * 8, 0) != 0) {
+    LOG_DEBUG("can't bind the buffer pool frames to NUMA node %d", numa_node_);
+  }
+}
+
+auto FrameArena::NumNumaNodes() -> int {
+  // the online nodes, e.g. "0" or "0-3"
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string nodes;
+  if (!(online >> nodes)) {
+    return 1;
+  }
+  auto dash = nodes.find_last_of("-,");
+  if (dash == std::string::npos) {
+    return 1;
+  }
+  return std::stoi(nodes.substr(dash + 1)) + 1;
+}
+
+}  // namespace bustub
@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : k_(k) { frames_.reserve(num_pages); }
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+auto LRUKReplacer::QueueOf(const FrameHistory &history) -> std::set<std::pair<uint64_t, frame_id_t>> & {
+  return history.accesses_.size() < k_ ? history_queue_ : cache_queue_;
+}
+
+auto LRUKReplacer::Victim(frame_id_t *frame_id) -> bool {
+  std::scoped_lock lck(latch_);
+  // infinite backward k-distance first
+  auto &queue = history_queue_.empty() ? cache_queue_ : history_queue_;
+  if (queue.empty()) {
+    return false;
+  }
+  *frame_id = queue.begin()->second;
+  queue.erase(queue.begin());
+  frames_.erase(*frame_id);
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lck(latch_);
+  auto it = frames_.find(frame_id);
+  if (it == frames_.end()) {
+    return;
+  }
+  auto &history = it->second;
+  if (history.evictable_) {
+    QueueOf(history).erase({history.accesses_.front(), frame_id});
+    history.evictable_ = false;
+  }
+  // pinning a resident frame again is an access
+  history.accesses_.emplace_back(current_timestamp_++);
+  if (history.accesses_.size() > k_) {
+    history.accesses_.pop_front();
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lck(latch_);
+  auto &history = frames_[frame_id];
+  if (history.evictable_) {
+    return;
+  }
+  // a frame we have never seen holds a page that was just brought in, which is its first access
+  if (history.accesses_.empty()) {
+    history.accesses_.emplace_back(current_timestamp_++);
+  }
+  history.evictable_ = true;
+  QueueOf(history).emplace(history.accesses_.front(), frame_id);
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock lck(latch_);
+  auto it = frames_.find(frame_id);
+  if (it == frames_.end()) {
+    return;
+  }
+  if (it->second.evictable_) {
+    QueueOf(it->second).erase({it->second.accesses_.front(), frame_id});
+  }
+  frames_.erase(it);
+}
+
+auto LRUKReplacer::Size() -> size_t {
+  std::scoped_lock lck(latch_);
+  return history_queue_.size() + cache_queue_.size();
+}
+
+void LRUKReplacer::PeekVictims(size_t max_frames, std::vector<frame_id_t> *frames) {
+  std::scoped_lock lck(latch_);
+  for (auto *queue : {&history_queue_, &cache_queue_}) {
+    for (auto it = queue->begin(); it != queue->end() && frames->size() < max_frames; ++it) {
+      frames->emplace_back(it->second);
+    }
+  }
+}
+
+}  // namespace bustub
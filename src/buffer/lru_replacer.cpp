@@ -60,4 +60,12 @@ size_t LRUReplacer::Size() {
   return cache_map_.size();
 }
 
+void LRUReplacer::PeekVictims(size_t max_frames, std::vector<frame_id_t> *frames) {
+  std::scoped_lock lck(latch_);
+  // victims are taken from the back
+  for (auto it = cache_list_.rbegin(); it != cache_list_.rend() && frames->size() < max_frames; ++it) {
+    frames->emplace_back(*it);
+  }
+}
+
 }  // namespace bustub
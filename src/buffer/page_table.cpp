@@ -0,0 +1,58 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t num_shards) {
+  // at least two shards, so that the hash shift below stays smaller than the word size
+  uint32_t bits = 1;
+  while ((static_cast<size_t>(1) << bits) < num_shards && bits < 16) {
+    bits++;
+  }
+  shard_shift_ = 32 - bits;
+  shards_ = std::vector<Shard>(static_cast<size_t>(1) << bits);
+}
+
+auto PageTable::Find(page_id_t page_id, frame_id_t *frame_id) -> bool {
+  return FindAndApply(page_id, [frame_id](frame_id_t fid) {
+    *frame_id = fid;
+    return true;
+  });
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  auto &shard = GetShard(page_id);
+  std::unique_lock lck(shard.latch_);
+  shard.map_[page_id] = frame_id;
+}
+
+void PageTable::ForEach(const std::function<void(page_id_t, frame_id_t)> &fn) {
+  for (auto &shard : shards_) {
+    std::shared_lock lck(shard.latch_);
+    for (auto [page_id, frame_id] : shard.map_) {
+      fn(page_id, frame_id);
+    }
+  }
+}
+
+auto PageTable::Size() -> size_t {
+  size_t size = 0;
+  for (auto &shard : shards_) {
+    std::shared_lock lck(shard.latch_);
+    size += shard.map_.size();
+  }
+  return size;
+}
+
+}  // namespace bustub
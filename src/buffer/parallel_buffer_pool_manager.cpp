@@ -12,18 +12,36 @@
 
 #include "buffer/parallel_buffer_pool_manager.h"
 
+#include <algorithm>
+#include <thread>  // NOLINT
+
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : num_instances_(num_instances), pool_size_(num_instances * pool_size) {
+                                                     LogManager *log_manager, ReplacerPolicy policy,
+                                                     size_t max_borrowed_frames)
+    : num_instances_(num_instances), pool_size_(num_instances * pool_size), disk_manager_(disk_manager) {
   // Allocate and create individual BufferPoolManagerInstances
   // operator new
   buffer_pools_ =
       static_cast<BufferPoolManagerInstance *>(operator new[](sizeof(BufferPoolManagerInstance) * num_instances));
   // placement new
   for (size_t i = 0; i < num_instances; i++) {
-    new (buffer_pools_ + i) BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, log_manager);
+    new (buffer_pools_ + i)
+        BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, log_manager, policy, max_borrowed_frames);
+  }
+  if (max_borrowed_frames > 0) {
+    for (size_t i = 0; i < num_instances; i++) {
+      // ask the neighbours in turn, starting with the next one
+      buffer_pools_[i].SetFrameLender([this, i] {
+        for (size_t j = 1; j < num_instances_; j++) {
+          if (buffer_pools_[(i + j) % num_instances_].LendFrame()) {
+            return true;
+          }
+        }
+        return false;
+      });
+    }
   }
 }
 
@@ -40,9 +58,22 @@ auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
   return pool_size_;
 }
 
+void ParallelBufferPoolManager::StartPageCleaner(size_t low_watermark, size_t high_watermark,
+                                                 std::chrono::milliseconds interval) {
+  for (size_t i = 0; i < num_instances_; i++) {
+    buffer_pools_[i].StartPageCleaner(low_watermark, high_watermark, interval);
+  }
+}
+
+void ParallelBufferPoolManager::StopPageCleaner() {
+  for (size_t i = 0; i < num_instances_; i++) {
+    buffer_pools_[i].StopPageCleaner();
+  }
+}
+
 auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManager * {
   // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
-  return &buffer_pools_[page_id % num_instances_];
+  return &buffer_pools_[BufferPoolManagerInstance::InstanceOf(page_id, num_instances_)];
 }
 
 auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
@@ -51,6 +82,10 @@ auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
   return buffer_pool->FetchPage(page_id);
 }
 
+auto ParallelBufferPoolManager::FetchPgInRingImp(page_id_t page_id, BufferRing *ring) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPageInRing(page_id, ring);
+}
+
 auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
   // Unpin page_id from responsible BufferPoolManagerInstance
   BufferPoolManager *buffer_pool = GetBufferPoolManager(page_id);
@@ -70,16 +105,40 @@ auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
   // starting index and return nullptr
   // 2.   Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
   // is called
-  size_t i = start_index_;
+  size_t start = next_instance_.fetch_add(1, std::memory_order_relaxed) % num_instances_;
+  size_t i = start;
   Page *p = nullptr;
   do {
     p = buffer_pools_[i].NewPage(page_id);
     i = (i + 1) % num_instances_;
-  } while (p == nullptr && i != start_index_);
-  start_index_ = (start_index_ + 1) % num_instances_;
+  } while (p == nullptr && i != start);
+  return p;
+}
+
+auto ParallelBufferPoolManager::NewPgInRingImp(page_id_t *page_id, BufferRing *ring) -> Page * {
+  // same round robin as NewPgImp, every instance recycles its own part of the ring
+  size_t start = next_instance_.fetch_add(1, std::memory_order_relaxed) % num_instances_;
+  size_t i = start;
+  Page *p = nullptr;
+  do {
+    p = buffer_pools_[i].NewPageInRing(page_id, ring);
+    i = (i + 1) % num_instances_;
+  } while (p == nullptr && i != start);
   return p;
 }
 
+auto ParallelBufferPoolManager::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  for (size_t i = 0; i < num_instances_; i++) {
+    stats += buffer_pools_[i].GetStats();
+  }
+  return stats;
+}
+
+auto ParallelBufferPoolManager::GetInstanceStats(size_t instance_index) -> BufferPoolStats {
+  return buffer_pools_[instance_index].GetStats();
+}
+
 auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
   // Delete page_id from responsible BufferPoolManagerInstance
   BufferPoolManager *buffer_pool = GetBufferPoolManager(page_id);
@@ -87,9 +146,54 @@ auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
 }
 
 void ParallelBufferPoolManager::FlushAllPgsImp() {
-  // flush all pages from all BufferPoolManagerInstances
+  // Page ids are striped over the instances, so runs of consecutive pages only show up once the dirty pages of all
+  // instances are sorted together.
+  using DirtyPage = BufferPoolManagerInstance::DirtyPage;
+  std::vector<std::vector<DirtyPage>> collected(num_instances_);
+  RunOnInstances([&](size_t i) { buffer_pools_[i].CollectDirtyPages(&collected[i]); });
+  std::vector<DirtyPage> dirty_pages;
+  for (auto &pages : collected) {
+    dirty_pages.insert(dirty_pages.end(), pages.begin(), pages.end());
+  }
+  std::sort(dirty_pages.begin(), dirty_pages.end(),
+            [](const DirtyPage &a, const DirtyPage &b) { return a.page_id_ < b.page_id_; });
+
+  // one thread per instance writes a contiguous slice of the sorted pages
+  size_t slice = (dirty_pages.size() + num_instances_ - 1) / num_instances_;
+  RunOnInstances([&](size_t i) {
+    size_t begin = std::min(i * slice, dirty_pages.size());
+    size_t end = std::min(begin + slice, dirty_pages.size());
+    BufferPoolManagerInstance::WriteDirtyPages(disk_manager_, dirty_pages.data() + begin, end - begin);
+  });
+  for (size_t i = 0; i < num_instances_; i++) {
+    buffer_pools_[i].ReleaseDirtyPages(collected[i]);
+  }
+  disk_manager_->Sync();
+}
+
+void ParallelBufferPoolManager::RunOnInstances(const std::function<void(size_t)> &fn) {
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_instances_; i++) {
+    threads.emplace_back(fn, i);
+  }
+  fn(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void ParallelBufferPoolManager::PrefetchPgsImp(const std::vector<page_id_t> &page_ids, BufferRing *ring) {
+  // hand every instance its share of the pages in one call
+  std::vector<std::vector<page_id_t>> per_instance(num_instances_);
+  for (auto page_id : page_ids) {
+    if (page_id != INVALID_PAGE_ID) {
+      per_instance[BufferPoolManagerInstance::InstanceOf(page_id, num_instances_)].emplace_back(page_id);
+    }
+  }
   for (size_t i = 0; i < num_instances_; i++) {
-    buffer_pools_[i].FlushAllPages();
+    if (!per_instance[i].empty()) {
+      buffer_pools_[i].PrefetchPages(per_instance[i], ring);
+    }
   }
 }
 
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead.cpp
+//
+// Identification: src/buffer/read_ahead.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/read_ahead.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace bustub {
+
+void ReadAhead::OnPage(page_id_t page_id, page_id_t next_page_id) {
+  if (bpm_ == nullptr || page_id == last_page_id_) {
+    return;
+  }
+  if (last_page_id_ != INVALID_PAGE_ID && page_id - last_page_id_ == stride_) {
+    run_++;
+  } else {
+    stride_ = last_page_id_ == INVALID_PAGE_ID ? 0 : page_id - last_page_id_;
+    run_ = 1;
+    prefetched_until_ = INVALID_PAGE_ID;
+  }
+  last_page_id_ = page_id;
+
+  std::vector<page_id_t> page_ids;
+  if (next_page_id != INVALID_PAGE_ID) {
+    page_ids.emplace_back(next_page_id);
+  }
+  // the chain continues a sequential run: keep a window of pages ahead in flight, extending it once half of it is used
+  // up so that the prefetches go out in batches
+  if (stride_ > 0 && run_ >= SEQUENTIAL_THRESHOLD && next_page_id == page_id + stride_) {
+    page_id_t window_end = page_id + static_cast<page_id_t>(window_) * stride_;
+    page_id_t from = page_id + 2 * stride_;
+    if (prefetched_until_ != INVALID_PAGE_ID) {
+      from = std::max(from, prefetched_until_ + stride_);
+    }
+    if (window_end - from >= static_cast<page_id_t>(window_ / 2) * stride_) {
+      for (page_id_t p = from; p <= window_end; p += stride_) {
+        page_ids.emplace_back(p);
+      }
+      prefetched_until_ = window_end;
+    }
+  }
+  if (!page_ids.empty()) {
+    bpm_->PrefetchPages(page_ids, ring_);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,37 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer.cpp
+//
+// Identification: src/buffer/replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/replacer.h"
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/two_q_replacer.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+auto Replacer::Create(ReplacerPolicy policy, size_t num_pages) -> std::unique_ptr<Replacer> {
+  switch (policy) {
+    case ReplacerPolicy::LRU:
+      return std::make_unique<LRUReplacer>(num_pages);
+    case ReplacerPolicy::LRU_K:
+      return std::make_unique<LRUKReplacer>(num_pages);
+    case ReplacerPolicy::TWO_Q:
+      return std::make_unique<TwoQReplacer>(num_pages);
+    case ReplacerPolicy::CLOCK:
+      return std::make_unique<ClockReplacer>(num_pages);
+  }
+  UNREACHABLE("unknown replacer policy");
+}
+
+}  // namespace bustub
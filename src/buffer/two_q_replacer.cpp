@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.cpp
+//
+// Identification: src/buffer/two_q_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_q_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+TwoQReplacer::TwoQReplacer(size_t num_pages, size_t a1_percent)
+    : a1_max_(std::max<size_t>(1, num_pages * a1_percent / 100)) {
+  frames_.reserve(num_pages);
+}
+
+TwoQReplacer::~TwoQReplacer() = default;
+
+auto TwoQReplacer::VictimFromA1() const -> bool { return !a1_.empty() && (a1_.size() >= a1_max_ || am_.empty()); }
+
+auto TwoQReplacer::Victim(frame_id_t *frame_id) -> bool {
+  std::scoped_lock lck(latch_);
+  auto &queue = VictimFromA1() ? a1_ : am_;
+  if (queue.empty()) {
+    return false;
+  }
+  *frame_id = queue.front();
+  queue.pop_front();
+  frames_.erase(*frame_id);
+  return true;
+}
+
+void TwoQReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lck(latch_);
+  auto it = frames_.find(frame_id);
+  if (it == frames_.end()) {
+    return;
+  }
+  auto &entry = it->second;
+  if (entry.evictable_) {
+    (entry.hot_ ? am_ : a1_).erase(entry.pos_);
+    entry.evictable_ = false;
+  }
+  // referenced again while resident
+  entry.hot_ = true;
+}
+
+void TwoQReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lck(latch_);
+  // a frame we have never seen holds a page that was just brought in, it starts out in A1
+  auto &entry = frames_[frame_id];
+  if (entry.evictable_) {
+    return;
+  }
+  auto &queue = entry.hot_ ? am_ : a1_;
+  entry.pos_ = queue.emplace(queue.end(), frame_id);
+  entry.evictable_ = true;
+}
+
+void TwoQReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock lck(latch_);
+  auto it = frames_.find(frame_id);
+  if (it == frames_.end()) {
+    return;
+  }
+  if (it->second.evictable_) {
+    (it->second.hot_ ? am_ : a1_).erase(it->second.pos_);
+  }
+  frames_.erase(it);
+}
+
+auto TwoQReplacer::Size() -> size_t {
+  std::scoped_lock lck(latch_);
+  return a1_.size() + am_.size();
+}
+
+void TwoQReplacer::PeekVictims(size_t max_frames, std::vector<frame_id_t> *frames) {
+  std::scoped_lock lck(latch_);
+  // approximate: the queue the next victim comes from first, then the other one
+  bool a1_first = VictimFromA1();
+  for (auto *queue : {a1_first ? &a1_ : &am_, a1_first ? &am_ : &a1_}) {
+    for (auto it = queue->begin(); it != queue->end() && frames->size() < max_frames; ++it) {
+      frames->emplace_back(*it);
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics.cpp
+//
+// Identification: src/common/util/metrics.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/metrics.h"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace bustub {
+
+auto HistogramSnapshot::MeanNanos() const -> double {
+  return count_ == 0 ? 0 : static_cast<double>(sum_nanos_) / static_cast<double>(count_);
+}
+
+auto HistogramSnapshot::PercentileNanos(double quantile) const -> uint64_t {
+  if (count_ == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count_)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    seen += buckets_[i];
+    if (seen >= rank && buckets_[i] != 0) {
+      return i == 0 ? 0 : static_cast<uint64_t>(1) << i;
+    }
+  }
+  return static_cast<uint64_t>(1) << (NUM_BUCKETS - 1);
+}
+
+auto HistogramSnapshot::operator+=(const HistogramSnapshot &other) -> HistogramSnapshot & {
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sum_nanos_ += other.sum_nanos_;
+  return *this;
+}
+
+auto HistogramSnapshot::ToString() const -> std::string {
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(1) << "count=" << count_ << " mean=" << MeanNanos() / 1000
+     << "us p50<=" << PercentileNanos(0.5) / 1000.0 << "us p99<=" << PercentileNanos(0.99) / 1000.0
+     << "us p99.9<=" << PercentileNanos(0.999) / 1000.0 << "us";
+  return os.str();
+}
+
+auto HistogramSnapshot::ToJson() const -> std::string {
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(1) << "{\"count\": " << count_ << ", \"mean_ns\": " << MeanNanos()
+     << ", \"p50_ns\": " << PercentileNanos(0.5) << ", \"p99_ns\": " << PercentileNanos(0.99)
+     << ", \"p999_ns\": " << PercentileNanos(0.999) << ", \"buckets\": [";
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    os << (i == 0 ? "" : ", ") << buckets_[i];
+  }
+  os << "]}";
+  return os.str();
+}
+
+auto LatencyHistogram::Snapshot() const -> HistogramSnapshot {
+  HistogramSnapshot snapshot;
+  for (size_t i = 0; i < HistogramSnapshot::NUM_BUCKETS; i++) {
+    snapshot.buckets_[i] = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.count_ += snapshot.buckets_[i];
+  }
+  snapshot.sum_nanos_ = sum_nanos_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+}  // namespace bustub
@@ -10,8 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -38,8 +40,8 @@ HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager
   Page *bucket_page = buffer_pool_manager_->NewPage(&bucket_page_id);
   assert(bucket_page != nullptr);
   dir_page->SetBucketPageId(0, bucket_page_id);
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true));
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true));
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
 }
 
 /*****************************************************************************
@@ -89,22 +91,54 @@ auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BU
   return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_page->GetData());
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::LatchBucket(const KeyType &key, Page *dir_page, bool exclusive) -> Page * {
+  auto dir = reinterpret_cast<HashTableDirectoryPage *>(dir_page->GetData());
+  while (true) {
+    uint64_t version = dir_page->GetVersion();
+    if (version % 2 == 0) {
+      page_id_t bucket_page_id = KeyToPageId(key, dir);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      // the page id read during a split may be garbage, only a page id read from an unchanged directory is fetched
+      if (dir_page->GetVersion() == version) {
+        Page *bucket_page = buffer_pool_manager_->FetchPage(bucket_page_id);
+        assert(bucket_page != nullptr);
+        if (exclusive) {
+          bucket_page->WLatch();
+        } else {
+          bucket_page->RLatch();
+        }
+        if (dir_page->GetVersion() == version) {
+          return bucket_page;
+        }
+        // a split moved the key to another bucket before the latch was taken
+        if (exclusive) {
+          bucket_page->WUnlatch();
+        } else {
+          bucket_page->RUnlatch();
+        }
+        buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+        continue;
+      }
+    }
+    std::this_thread::yield();
+  }
+}
+
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
   table_latch_.RLock();
-  auto dir_page = FetchDirectoryPage();
-  auto bucket_page_id = KeyToPageId(key, dir_page);
-  Page *bucket_page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  bucket_page->RLatch();
+  Page *dir_page = buffer_pool_manager_->FetchPage(directory_page_id_);
+  assert(dir_page != nullptr);
+  Page *bucket_page = LatchBucket(key, dir_page, false);
   auto bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_page->GetData());
   bool succeed = bucket->GetValue(key, comparator_, result);
   bucket_page->RUnlatch();
-  // auto bucket_page = FetchBucketPage(bucket_page_id);
-  assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false));
+  buffer_pool_manager_->UnpinPage(bucket_page->GetPageId(), false);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
   table_latch_.RUnlock();
   return succeed;
 }
@@ -115,43 +149,52 @@ auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   table_latch_.RLock();
-  auto dir_page = FetchDirectoryPage();
-  auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
-  page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
-  Page *bucket_page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  bucket_page->WLatch();
+  Page *dir_page = buffer_pool_manager_->FetchPage(directory_page_id_);
+  assert(dir_page != nullptr);
+  Page *bucket_page = LatchBucket(key, dir_page, true);
   auto bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_page->GetData());
-  // auto bucket_page = FetchBucketPage(bucket_page_id);
-  if (!bucket->IsFull()) {
-    bool succeed = bucket->Insert(key, value, comparator_);
-    bucket_page->WUnlatch();
-    if (succeed) {
-      buffer_pool_manager_->UnpinPage(bucket_page_id, true);
-    } else {
-      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
-    }
-    buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false);
-    table_latch_.RUnlock();
-    return succeed;
-  }
+  bool full = bucket->IsFull();
+  bool succeed = !full && bucket->Insert(key, value, comparator_);
   bucket_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false);
-  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  buffer_pool_manager_->UnpinPage(bucket_page->GetPageId(), succeed);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
   table_latch_.RUnlock();
+  if (!full) {
+    return succeed;
+  }
   return SplitInsert(transaction, key, value);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  // this bucket is full, should split
-  table_latch_.WLock();
-  auto dir_page = FetchDirectoryPage();
+  // only merges are excluded; lookups, inserts and splits of other buckets go on
+  table_latch_.RLock();
+  Page *dir_raw_page = buffer_pool_manager_->FetchPage(directory_page_id_);
+  assert(dir_raw_page != nullptr);
+  auto dir_page = reinterpret_cast<HashTableDirectoryPage *>(dir_raw_page->GetData());
+  Page *split_bucket_page = LatchBucket(key, dir_raw_page, true);
+  page_id_t split_bucket_page_id = split_bucket_page->GetPageId();
+  auto split_bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(split_bucket_page->GetData());
+  // another thread may have split the bucket since it was found full
+  if (!split_bucket->IsFull()) {
+    bool succeed = split_bucket->Insert(key, value, comparator_);
+    split_bucket_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(split_bucket_page_id, succeed);
+    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+    table_latch_.RUnlock();
+    return succeed;
+  }
+
+  // the latched bucket stays the one the key maps to, and the directory is changed under its latch only here
+  dir_raw_page->WLatch();
   auto split_bucket_idx = KeyToDirectoryIndex(key, dir_page);
-  page_id_t split_bucket_page_id = dir_page->GetBucketPageId(split_bucket_idx);
   // if reach max_depth, return false
   if ((1 << dir_page->GetLocalDepth(split_bucket_idx)) == DIRECTORY_ARRAY_SIZE) {
-    assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
-    table_latch_.WUnlock();
+    dir_raw_page->WUnlatch();
+    split_bucket_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(split_bucket_page_id, false);
+    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+    table_latch_.RUnlock();
     return false;
   }
   // if reach global_depth, increase it
@@ -174,7 +217,7 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
   auto buddy_bucket_idx = dir_page->GetSplitImageIndex(split_bucket_idx);
   page_id_t buddy_bucket_page_id;
   Page *buddy_bucket_page = buffer_pool_manager_->NewPage(&buddy_bucket_page_id);
-  // assert(buffer_pool_manager_->UnpinPage(buddy_bucket_page_id, true));
+  assert(buddy_bucket_page != nullptr);
   // modify information of all slots in directory that points to the buddy bucket
   for (int i = buddy_bucket_idx; i >= 0; i -= stride) {
     dir_page->SetBucketPageId(i, buddy_bucket_page_id);
@@ -184,30 +227,27 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
     dir_page->SetBucketPageId(i, buddy_bucket_page_id);
     dir_page->SetLocalDepth(i, dir_page->GetLocalDepth(split_bucket_idx));
   }
-  // redistribute the key-value pair in old bucket
-  Page *split_bucket_page = buffer_pool_manager_->FetchPage(split_bucket_page_id);
-  split_bucket_page->WLatch();
-  auto split_bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(split_bucket_page->GetData());
-  // Page *buddy_bucket_page = buffer_pool_manager_->FetchPage(buddy_bucket_page_id);
-  buddy_bucket_page->WLatch();
+  // redistribute the key-value pair in old bucket; no other thread reaches the buddy bucket before the directory is
+  // unlatched
   auto buddy_bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buddy_bucket_page->GetData());
-  // ! Don't assume it's still full now, just split!
   for (size_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
     if (split_bucket->IsReadable(i)) {
       auto key_at_i = split_bucket->KeyAt(i);
       auto target_bucket_page_id = KeyToPageId(key_at_i, dir_page);
       if (split_bucket_page_id != target_bucket_page_id) {
-        assert(buddy_bucket->Insert(key_at_i, split_bucket->ValueAt(i), comparator_));
+        bool moved = buddy_bucket->Insert(key_at_i, split_bucket->ValueAt(i), comparator_);
+        assert(moved);
+        (void)moved;
         split_bucket->RemoveAt(i);
       }
     }
   }
+  dir_raw_page->WUnlatch();
   split_bucket_page->WUnlatch();
-  buddy_bucket_page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), true));
-  assert(buffer_pool_manager_->UnpinPage(split_bucket_page_id, true));
-  assert(buffer_pool_manager_->UnpinPage(buddy_bucket_page_id, true));
-  table_latch_.WUnlock();
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
+  buffer_pool_manager_->UnpinPage(split_bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(buddy_bucket_page_id, true);
+  table_latch_.RUnlock();
   return Insert(transaction, key, value);
 }
 
@@ -217,22 +257,17 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   table_latch_.RLock();
-  auto dir_page = FetchDirectoryPage();
-  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
-  Page *bucket_page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  bucket_page->WLatch();
+  Page *dir_page = buffer_pool_manager_->FetchPage(directory_page_id_);
+  assert(dir_page != nullptr);
+  Page *bucket_page = LatchBucket(key, dir_page, true);
   auto bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket_page->GetData());
-  // HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(bucket_page_id);
   bool succeed = bucket->Remove(key, value, comparator_);
+  bool empty = bucket->IsEmpty();
   bucket_page->WUnlatch();
-  if (succeed) {
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true));
-  } else {
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false));
-  }
-  assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
+  buffer_pool_manager_->UnpinPage(bucket_page->GetPageId(), succeed);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
   table_latch_.RUnlock();
-  if (bucket->IsEmpty()) {
+  if (empty) {
     Merge(transaction, key, value);
   }
   return succeed;
@@ -243,20 +278,31 @@ auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  // no other operation of the table runs meanwhile, but the buffer pool may still pin the empty bucket for a while,
+  // e.g. to flush it
   table_latch_.WLock();
-  auto dir_page = FetchDirectoryPage();
+  std::vector<page_id_t> pending;
+  pending.swap(deferred_deletes_);
+  for (page_id_t page_id : pending) {
+    if (!buffer_pool_manager_->DeletePage(page_id)) {
+      deferred_deletes_.push_back(page_id);
+    }
+  }
+  Page *dir_raw_page = buffer_pool_manager_->FetchPage(directory_page_id_);
+  assert(dir_raw_page != nullptr);
+  auto dir_page = reinterpret_cast<HashTableDirectoryPage *>(dir_raw_page->GetData());
   auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
   // check if local_depth is greater than 0;
   auto local_depth = dir_page->GetLocalDepth(bucket_idx);
   if (local_depth == 0) {
-    assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
+    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
     table_latch_.WUnlock();
     return;
   }
   // check if local_depth is same as the buddy_bucket's
   auto buddy_bucket_idx = dir_page->GetSplitImageIndex(bucket_idx);
   if (local_depth != dir_page->GetLocalDepth(buddy_bucket_idx)) {
-    assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
+    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
     table_latch_.WUnlock();
     return;
   }
@@ -267,16 +313,20 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
   // check if empty now
   if (!bucket->IsEmpty()) {
     bucket_page->RUnlatch();
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false));
-    assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
     table_latch_.WUnlock();
     return;
   }
   bucket_page->RUnlatch();
   // delete the empty page
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false));
-  assert(buffer_pool_manager_->DeletePage(bucket_page_id));
-  // modify the corresponding slots in dir_page
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  if (!buffer_pool_manager_->DeletePage(bucket_page_id)) {
+    // no directory slot points to the bucket once the merge is done, so it is deleted later
+    deferred_deletes_.push_back(bucket_page_id);
+  }
+  // modify the corresponding slots in dir_page, latched so that the version of the directory goes up with every change
+  dir_raw_page->WLatch();
   page_id_t buddy_bucket_page_id = dir_page->GetBucketPageId(buddy_bucket_idx);
   auto stride = 1 << (local_depth - 1);
   for (int i = bucket_idx; i >= 0; i -= stride) {
@@ -290,7 +340,8 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
   while (dir_page->CanShrink()) {
     dir_page->DecrGlobalDepth();
   }
-  assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), true));
+  dir_raw_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
   table_latch_.WUnlock();
 }
 
@@ -302,7 +353,7 @@ auto HASH_TABLE_TYPE::GetGlobalDepth() -> uint32_t {
   table_latch_.RLock();
   HashTableDirectoryPage *dir_page = FetchDirectoryPage();
   uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr);
   table_latch_.RUnlock();
   return global_depth;
 }
@@ -315,7 +366,7 @@ void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
   HashTableDirectoryPage *dir_page = FetchDirectoryPage();
   dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr);
   table_latch_.RUnlock();
 }
 
@@ -11,12 +11,96 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
 
+#include <algorithm>
+#include <numeric>
+
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  auto *catalog = exec_ctx_->GetCatalog();
+  IndexInfo *index_info = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(index_info->table_name_);
+  scan_ = index_info->index_->ScanRange(plan_->GetLowKey(), plan_->GetHighKey(), plan_->IsDescending(),
+                                        exec_ctx_->GetTransaction());
+  rids_.clear();
+  chunk_start_ = 0;
+  chunk_size_ = 0;
+  tuples_.clear();
+  cursor_ = 0;
+}
+
+auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  const auto *output_schema = plan_->OutputSchema();
+  while (true) {
+    for (; cursor_ < tuples_.size(); cursor_++) {
+      Tuple &source = tuples_[cursor_];
+      if (!source.IsAllocated()) {
+        continue;
+      }
+      // do projection
+      std::vector<Value> values;
+      values.reserve(output_schema->GetColumnCount());
+      for (auto &col : output_schema->GetColumns()) {
+        values.emplace_back(col.GetExpr()->Evaluate(&source, &table_info_->schema_));
+      }
+      *tuple = Tuple(values, output_schema);
+      *rid = source.GetRid();
+      cursor_++;
+      return true;
+    }
+    if (!FetchChunk()) {
+      return false;
+    }
+  }
+}
 
-void IndexScanExecutor::Init() {}
+auto IndexScanExecutor::FetchChunk() -> bool {
+  chunk_start_ += chunk_size_;
+  if (chunk_start_ == rids_.size()) {
+    if (!scan_->NextBatch(&rids_)) {
+      return false;
+    }
+    chunk_start_ = 0;
+  }
+  chunk_size_ = std::min(rids_.size() - chunk_start_, chunk_size_ == 0 ? FIRST_CHUNK_SIZE : 2 * chunk_size_);
+  rid_order_.resize(chunk_size_);
+  std::iota(rid_order_.begin(), rid_order_.end(), chunk_start_);
+  std::sort(rid_order_.begin(), rid_order_.end(),
+            [this](size_t a, size_t b) { return rids_[a].Get() < rids_[b].Get(); });
+  std::vector<page_id_t> page_ids;
+  for (size_t i : rid_order_) {
+    if (page_ids.empty() || page_ids.back() != rids_[i].GetPageId()) {
+      page_ids.push_back(rids_[i].GetPageId());
+    }
+  }
+  exec_ctx_->GetBufferPoolManager()->PrefetchPages(page_ids);
 
-auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+  auto *txn = exec_ctx_->GetTransaction();
+  const auto *predicate = plan_->GetPredicate();
+  tuples_.assign(chunk_size_, Tuple());
+  cursor_ = 0;
+  for (size_t i : rid_order_) {
+    switch (txn->GetIsolationLevel()) {
+      case IsolationLevel::READ_UNCOMMITTED:
+        // no shared lock
+        break;
+      case IsolationLevel::READ_COMMITTED:
+      case IsolationLevel::REPEATABLE_READ:
+        exec_ctx_->GetLockManager()->LockShared(txn, rids_[i]);
+    }
+    Tuple source;
+    if (table_info_->table_->GetTuple(rids_[i], &source, txn) &&
+        (predicate == nullptr || predicate->Evaluate(&source, &table_info_->schema_).GetAs<bool>())) {
+      tuples_[i - chunk_start_] = source;
+    }
+    // READ_COMMITTED release ShareLock after use
+    if (txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
+      exec_ctx_->GetLockManager()->Unlock(txn, rids_[i]);
+    }
+  }
+  return true;
+}
 
 }  // namespace bustub
@@ -24,9 +24,9 @@ void InsertExecutor::Init() {
   table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->TableOid());
   table_heap_ = table_info_->table_.get();
 }
-void InsertExecutor::InsertIntoTableAndUpdateIndex(Tuple tuple) {
+void InsertExecutor::InsertIntoTableAndUpdateIndex(Tuple tuple, BufferRing *ring) {
   RID inserted_rid;
-  if (!table_heap_->InsertTuple(tuple, &inserted_rid, exec_ctx_->GetTransaction())) {
+  if (!table_heap_->InsertTuple(tuple, &inserted_rid, exec_ctx_->GetTransaction(), ring)) {
     throw Exception(ExceptionType::OUT_OF_MEMORY, "InsertExecutor: no enough space");
   }
   // TableWriteSet already get updated in TableHeap::InsertTuple
@@ -51,7 +51,7 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
     Tuple tuple;
     RID rid;
     while (child_executor_->Next(&tuple, &rid)) {
-      InsertIntoTableAndUpdateIndex(tuple);
+      InsertIntoTableAndUpdateIndex(tuple, &ring_);
     }
   }
   return false;
@@ -19,7 +19,7 @@ SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNod
 
 void SeqScanExecutor::Init() {
   table_heap_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid())->table_.get();
-  table_iter_ = table_heap_->Begin(exec_ctx_->GetTransaction());
+  table_iter_ = table_heap_->Begin(exec_ctx_->GetTransaction(), &ring_);
 }
 
 auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
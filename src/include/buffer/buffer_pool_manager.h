@@ -15,7 +15,10 @@
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/buffer_ring.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
@@ -84,9 +87,43 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch a page like FetchPage, but on a miss read it into a frame of the ring instead of evicting a page of the
+   * shared working set.
+   * @param page_id id of page to be fetched
+   * @param ring the buffer ring of the calling operation, nullptr to fetch like FetchPage
+   * @return nullptr if the page could not be fetched, otherwise the pinned page
+   */
+  auto FetchPageInRing(page_id_t page_id, BufferRing *ring) -> Page * {
+    return ring == nullptr ? FetchPgImp(page_id) : FetchPgInRingImp(page_id, ring);
+  }
+
+  /**
+   * Create a page like NewPage, but in a frame of the ring instead of evicting a page of the shared working set.
+   * @param[out] page_id id of created page
+   * @param ring the buffer ring of the calling operation, nullptr to create like NewPage
+   * @return nullptr if no new pages could be created, otherwise the pinned page
+   */
+  auto NewPageInRing(page_id_t *page_id, BufferRing *ring) -> Page * {
+    return ring == nullptr ? NewPgImp(page_id) : NewPgInRingImp(page_id, ring);
+  }
+
+  /**
+   * Start reading pages into the buffer pool without pinning them, so that later fetches find them resident or
+   * already on their way. Pages that are resident or being read in are skipped. This does not wait for the reads.
+   * @param page_ids ids of the pages to read ahead
+   * @param ring the buffer ring to read the pages into, nullptr to read them into the shared pool
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids, BufferRing *ring = nullptr) {
+    PrefetchPgsImp(page_ids, ring);
+  }
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /** @return a snapshot of the hit, miss, eviction and latch wait counters, all zero if they are not kept */
+  virtual auto GetStats() -> BufferPoolStats { return {}; }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -141,5 +178,29 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Fetch the requested page, reading it into a frame of the ring on a miss. Buffer pools without rings fetch it
+   * like FetchPgImp.
+   * @param page_id id of page to be fetched
+   * @param ring the buffer ring of the calling operation
+   * @return the requested page
+   */
+  virtual auto FetchPgInRingImp(page_id_t page_id, BufferRing *ring) -> Page * { return FetchPgImp(page_id); }
+
+  /**
+   * Creates a new page in a frame of the ring. Buffer pools without rings create it like NewPgImp.
+   * @param[out] page_id id of created page
+   * @param ring the buffer ring of the calling operation
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual auto NewPgInRingImp(page_id_t *page_id, BufferRing *ring) -> Page * { return NewPgImp(page_id); }
+
+  /**
+   * Start reading pages into the buffer pool without pinning them. Buffer pools that cannot read ahead ignore this.
+   * @param page_ids ids of the pages to read ahead
+   * @param ring the buffer ring to read the pages into, or nullptr
+   */
+  virtual void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, BufferRing *ring) {}
 };
 }  // namespace bustub
@@ -12,12 +12,23 @@
 
 #pragma once
 
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <future>              // NOLINT
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/replacer.h"
+#include "buffer/page_table.h"
+#include "common/util/metrics.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -34,8 +45,10 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param policy the page replacement policy
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerPolicy policy = ReplacerPolicy::LRU);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +56,12 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param policy the page replacement policy
+   * @param max_borrowed_frames how many frames beyond pool_size this instance may borrow, see SetFrameLender
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerPolicy policy = ReplacerPolicy::LRU, size_t max_borrowed_frames = 0);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -58,6 +74,92 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return pointer to all the pages in the buffer pool */
   auto GetPages() -> Page * { return pages_; }
 
+  /**
+   * The instance of a parallel BPM that owns a page. Page ids are handed out in blocks of num_instances consecutive
+   * ids, each instance owns one id of every block, and a hash of the block rotates which one. Hot pages whose ids are
+   * equal modulo num_instances thus spread over all instances instead of piling up on one.
+   * @param page_id id of the page
+   * @param num_instances number of instances of the parallel BPM
+   * @return index of the owning instance
+   */
+  static inline auto InstanceOf(page_id_t page_id, uint32_t num_instances) -> uint32_t {
+    auto id = static_cast<uint32_t>(page_id);
+    return (id % num_instances + BlockRotation(id / num_instances) % num_instances) % num_instances;
+  }
+
+  /**
+   * Let this instance borrow frames from its neighbours once all of its own frames are pinned. A borrowed frame comes
+   * out of this instance's reserve and costs the lender one of its free frames, so the total number of frames in use
+   * stays the same.
+   * @param lender called with latch_ held, returns true if a neighbour gave up one of its free frames
+   */
+  void SetFrameLender(std::function<bool()> lender) { frame_lender_ = std::move(lender); }
+
+  /**
+   * Give one free frame to a neighbour, see SetFrameLender. Does nothing if latch_ is busy, since the neighbour is
+   * holding its own latch.
+   * @return true if a free frame was given up
+   */
+  auto LendFrame() -> bool;
+
+  /**
+   * Start a background thread that writes out dirty pages at the cold end of the replacer before they are evicted,
+   * so that foreground misses find clean victims. Does nothing if the cleaner is already running.
+   * @param low_watermark the cleaner runs once fewer frames than this are free or clean eviction candidates
+   * @param high_watermark the number of eviction candidates the cleaner makes clean when it runs
+   * @param interval how often the cleaner checks the watermarks, it is also woken by dirty evictions
+   */
+  void StartPageCleaner(size_t low_watermark, size_t high_watermark,
+                        std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+  /** Stop the background page cleaner, if it is running. */
+  void StopPageCleaner();
+
+  /**
+   * Write out the dirty unpinned pages among the next eviction candidates. This is one pass of the page cleaner.
+   * @param max_pages the number of eviction candidates to look at
+   * @return the number of pages written
+   */
+  auto CleanPages(size_t max_pages) -> size_t;
+
+  /** @return the number of pages written by the page cleaner */
+  auto GetCleanerFlushCount() const -> uint64_t { return cleaner_flushes_.Get(); }
+
+  /** @return the number of dirty victims that had to be written on the foreground path */
+  auto GetSyncFlushCount() const -> uint64_t { return dirty_evictions_.Get(); }
+
+  /** @return a snapshot of the counters of this instance */
+  auto GetStats() -> BufferPoolStats override;
+
+  /** A dirty page pinned by a checkpoint, see CollectDirtyPages. */
+  struct DirtyPage {
+    page_id_t page_id_;
+    frame_id_t frame_id_;
+    Page *page_;
+  };
+
+  /**
+   * First step of a checkpoint: pin every dirty page and mark it clean, so that it can be written out from its frame
+   * without holding latch_. A page modified while it is written is simply dirty again afterwards.
+   * @param[out] dirty_pages receives the pinned pages, in no particular order
+   */
+  void CollectDirtyPages(std::vector<DirtyPage> *dirty_pages);
+
+  /**
+   * Last step of a checkpoint: drop the pins taken by CollectDirtyPages.
+   * @param dirty_pages the pages collected from this instance
+   */
+  void ReleaseDirtyPages(const std::vector<DirtyPage> &dirty_pages);
+
+  /**
+   * Write out collected pages with one vectored write per run of consecutive page ids. Pages whose write failed are
+   * marked dirty again.
+   * @param disk_manager the disk manager of the pages
+   * @param dirty_pages the pages, sorted by page id
+   * @param num_pages number of pages
+   */
+  static void WriteDirtyPages(DiskManager *disk_manager, const DirtyPage *dirty_pages, size_t num_pages);
+
  protected:
   /**
    * Fetch the requested page from the buffer pool.
@@ -66,6 +168,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * Fetch the requested page, reading it into a frame of the ring on a miss.
+   * @param page_id id of page to be fetched
+   * @param ring the buffer ring of the calling operation, or nullptr
+   * @return the requested page
+   */
+  auto FetchPgInRingImp(page_id_t page_id, BufferRing *ring) -> Page * override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -88,6 +198,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto NewPgImp(page_id_t *page_id) -> Page * override;
 
+  /**
+   * Creates a new page in a frame of the ring.
+   * @param[out] page_id id of created page
+   * @param ring the buffer ring of the calling operation, or nullptr
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgInRingImp(page_id_t *page_id, BufferRing *ring) -> Page * override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -96,22 +214,88 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the pages in the buffer pool to disk, in page id order and with coalesced writes, followed by a sync.
    */
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Start reading pages into the buffer pool without pinning them. Each read holds a pin on its frame until it is
+   * installed, so prefetching stops once a share of the pool is in flight. Pages that were never allocated are
+   * skipped, since reading one would install a page that NewPage hands out later.
+   * @param page_ids ids of the pages to read ahead
+   * @param ring the buffer ring to read the pages into, or nullptr
+   */
+  void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, BufferRing *ring) override;
+
+  /**
+   * Allocate a page on disk. The lowest page of this instance in the disk manager's free space map is reused first,
+   * a new page id is only handed out once there is none. Must be called with latch_ held.
    * @return the id of the allocated page
    */
   auto AllocatePage() -> page_id_t;
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that AllocatePage may reuse it. Must be called with latch_ held.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
+  void DeallocatePage(page_id_t page_id);
+
+  /**
+   * Pin a resident frame. Only the first pin of an unpinned frame has to tell the replacer.
+   * @param frame_id id of the frame, which must be looked up through page_table_
+   */
+  void PinFrame(frame_id_t frame_id);
+
+  /**
+   * Find a frame to hold a new page, from the free list first and then from the replacer. A dirty victim is written
+   * back and its page table entry is removed. If only prefetched frames are left, their reads are waited for. Must be
+   * called with latch_ held.
+   *
+   * With a ring, the frame of the ring's current slot is recycled if it still holds the page the ring put there and
+   * nobody has it pinned. The caller records the new page in the ring with BufferRing::InstanceRing::Fill.
+   * @param[out] frame_id id of the frame found
+   * @param ring the buffer ring of the calling operation, or nullptr
+   * @return false if every frame is pinned, true otherwise
+   */
+  auto GetVictimFrame(frame_id_t *frame_id, BufferRing *ring = nullptr) -> bool;
+
+  /**
+   * Make a page whose read has completed visible: put it in the page table and wake the fetches waiting for it. Must
+   * be called with latch_ held.
+   * @param page_id id of the page
+   * @param frame_id frame the page was read into
+   */
+  void InstallPage(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Install the prefetched pages whose reads have completed and drop the pins their reads held. Must be called with
+   * latch_ held.
+   */
+  void ReapPrefetches();
+
+  /**
+   * Wait until a write of the page issued by the page cleaner has completed, so that a newer image written or read
+   * afterwards is not overtaken by it. Must be called with latch_ held.
+   * @param page_id id of the page
+   */
+  void WaitForCleaning(page_id_t page_id);
+
+  /** @return true if fewer frames than the low watermark are free or clean eviction candidates */
+  auto NeedsCleaning() -> bool;
+
+  /** @return latch_, acquired; the time spent waiting for it goes into latch_wait_ */
+  auto LockLatch() -> std::unique_lock<std::mutex>;
+  /** Body of the page cleaner thread. */
+  void PageCleanerLoop();
+
+  /** @return a murmur3 mix of a block of page ids, 0 for block 0 */
+  static inline auto BlockRotation(uint32_t block) -> uint32_t {
+    block ^= block >> 16;
+    block *= 0x85ebca6b;
+    block ^= block >> 13;
+    block *= 0xc2b2ae35;
+    block ^= block >> 16;
+    return block;
   }
 
   /**
@@ -127,23 +311,74 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   const uint32_t num_instances_ = 1;
   /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
   const uint32_t instance_index_ = 0;
-  /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
-  std::atomic<page_id_t> next_page_id_ = instance_index_;
+  /**
+   * Each BPI hands out one page id of every block of num_instances_ ids, this is the next block, see InstanceOf. It
+   * starts after the pages the database file holds already, see DiskManager::GetNumPages.
+   */
+  std::atomic<page_id_t> next_block_ = 0;
+  /** No free page of this instance lies below this id, so AllocatePage starts looking for one here. */
+  page_id_t reuse_from_ = 0;
 
-  /** Array of buffer pool pages. */
+  /** The frames, bound to a NUMA node when this instance is part of a parallel BPM. */
+  std::unique_ptr<FrameArena> arena_;
+  /** Array of buffer pool pages, the frame headers of arena_. */
   Page *pages_;
   /** Pointer to the disk manager. */
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  /** Page table for keeping track of buffer pool pages. Sharded, so buffer hits are served without latch_. */
+  PageTable page_table_;
   /** Replacer to find unpinned pages for replacement. */
-  Replacer *replacer_;
+  std::unique_ptr<Replacer> replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  // protects free_list_ and page_table_
+  /** Frames this instance may take once a neighbour lends it one, and frames it lent away. */
+  std::vector<frame_id_t> reserve_frames_;
+  /** Finds a neighbour to lend this instance a frame, see SetFrameLender. */
+  std::function<bool()> frame_lender_;
+  /**
+   * Pages whose read is in flight, with the frame they are read into. Fetches of such a page wait on the future,
+   * which is ready once the page is in the page table.
+   */
+  std::unordered_map<page_id_t, std::pair<frame_id_t, std::shared_future<void>>> loading_;
+  /**
+   * Prefetched pages whose read is in flight and that no fetch has claimed yet. They are in loading_ as well; the
+   * first fetch of such a page takes the entry over and installs the page itself.
+   */
+  struct Prefetch {
+    std::future<bool> read_;
+    std::promise<void> installed_;
+  };
+  std::unordered_map<page_id_t, Prefetch> prefetching_;
+  /** Pages the cleaner is writing out from a private copy. A read or write of such a page waits for the copy first. */
+  std::unordered_map<page_id_t, std::shared_future<bool>> cleaning_;
+  /**
+   * Serializes the slow path (misses, prefetches, NewPage, DeletePage and flushes) and protects free_list_, loading_,
+   * prefetching_ and cleaning_. It is not held while a miss waits for its read. Buffer hits and unpins only latch
+   * their page table shard and update the frame's atomic pin count. Acquire it through LockLatch.
+   */
   std::mutex latch_;
+
+  /** Background page cleaner, see StartPageCleaner. cleaner_latch_ protects cleaner_stop_. */
+  std::thread cleaner_;
+  std::mutex cleaner_latch_;
+  std::condition_variable cleaner_cv_;
+  bool cleaner_stop_{false};
+  size_t cleaner_low_watermark_{0};
+  size_t cleaner_high_watermark_{0};
+  std::chrono::milliseconds cleaner_interval_{0};
+  /** Statistics, see GetStats. */
+  StripedCounter hits_;
+  StripedCounter misses_;
+  StripedCounter fetch_failures_;
+  StripedCounter new_page_failures_;
+  StripedCounter evictions_;
+  StripedCounter dirty_evictions_;
+  StripedCounter cleaner_flushes_;
+  StripedCounter prefetches_;
+  StripedCounter frames_borrowed_;
+  StripedCounter frames_lent_;
+  LatencyHistogram latch_wait_;
 };
 }  // namespace bustub
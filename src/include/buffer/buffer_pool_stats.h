@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "common/util/metrics.h"
+
+namespace bustub {
+
+/**
+ * A snapshot of the counters of a buffer pool, see BufferPoolManager::GetStats. The counters of a parallel buffer pool
+ * are the sums over its instances.
+ */
+struct BufferPoolStats {
+  /** Fetches served without a read of their own, including fetches that shared a read already in flight. */
+  uint64_t hits_{0};
+  /** Fetches that read the page from disk. */
+  uint64_t misses_{0};
+  /** Fetches that failed because every frame was pinned. */
+  uint64_t fetch_failures_{0};
+  /** NewPage calls that failed because every frame was pinned. */
+  uint64_t new_page_failures_{0};
+  /** Pages evicted to make room, through the replacer or a buffer ring. */
+  uint64_t evictions_{0};
+  /** Evicted pages that had to be written out on the foreground path first. */
+  uint64_t dirty_evictions_{0};
+  /** Pages written out by the page cleaner. */
+  uint64_t cleaner_flushes_{0};
+  /** Pages read by PrefetchPages. */
+  uint64_t prefetches_{0};
+  /** Frames borrowed from and lent to other instances of a parallel buffer pool. */
+  uint64_t frames_borrowed_{0};
+  uint64_t frames_lent_{0};
+  /** Time spent waiting to acquire the instance latch on the slow path. */
+  HistogramSnapshot latch_wait_;
+
+  /** @return the share of fetches that were hits, 0 if there were none */
+  auto HitRatio() const -> double;
+
+  /** Add the counters of another instance. */
+  auto operator+=(const BufferPoolStats &other) -> BufferPoolStats &;
+
+  /** @return one counter per line */
+  auto ToString() const -> std::string;
+
+  /** @return the counters as a JSON object */
+  auto ToJson() const -> std::string;
+};
+
+}  // namespace bustub
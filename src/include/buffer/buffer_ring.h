@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_ring.h
+//
+// Identification: src/include/buffer/buffer_ring.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class BufferPoolManagerInstance;
+
+/**
+ * BufferRing is a buffer access strategy for large sequential scans and bulk loads. Pages such an operation reads in
+ * or creates are put into a small private ring of frames, and once the ring is full every further miss recycles the
+ * frame of the ring that was filled longest ago, instead of evicting a page of the shared working set through the
+ * replacer. Pages that are already resident are used as they are, and a ring frame that somebody else has pinned is
+ * left alone and replaced in the ring by a regular victim.
+ *
+ * A ring belongs to one operation and is not thread-safe. With a parallel buffer pool, every instance recycles its own
+ * ring of the given size.
+ */
+class BufferRing {
+ public:
+  /** Default number of frames in a ring. */
+  static constexpr size_t DEFAULT_RING_SIZE = 32;
+
+  /**
+   * Creates a new BufferRing.
+   * @param ring_size the number of frames in the ring
+   */
+  explicit BufferRing(size_t ring_size = DEFAULT_RING_SIZE) : ring_size_(std::max<size_t>(1, ring_size)) {}
+
+  DISALLOW_COPY_AND_MOVE(BufferRing);
+
+  /** @return the number of frames in the ring */
+  auto GetRingSize() const -> size_t { return ring_size_; }
+
+ private:
+  friend class BufferPoolManagerInstance;
+
+  /** A page this ring brought into a frame. */
+  struct Slot {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    frame_id_t frame_id_{-1};
+  };
+
+  /** The slots of one buffer pool instance, filled and recycled in order. */
+  struct InstanceRing {
+    /** @return the slot whose frame is recycled next */
+    auto Current() -> Slot & { return slots_[next_]; }
+
+    /** Put a page into the current slot and move on to the next one. */
+    void Fill(page_id_t page_id, frame_id_t frame_id) {
+      slots_[next_] = {page_id, frame_id};
+      next_ = (next_ + 1) % slots_.size();
+    }
+
+    std::vector<Slot> slots_;
+    size_t next_{0};
+  };
+
+  /** @return the ring of a buffer pool instance, created on first use */
+  auto GetInstanceRing(const BufferPoolManagerInstance *bpm) -> InstanceRing & {
+    auto &ring = rings_[bpm];
+    if (ring.slots_.empty()) {
+      ring.slots_.resize(ring_size_);
+    }
+    return ring;
+  }
+
+  size_t ring_size_;
+  std::unordered_map<const BufferPoolManagerInstance *, InstanceRing> rings_;
+};
+
+}  // namespace bustub
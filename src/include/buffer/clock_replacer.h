@@ -12,8 +12,8 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,6 +23,10 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * The replacer is lock-free. Every frame has an atomic state word holding its evictable and reference bits, so Pin and
+ * Unpin are a single atomic read-modify-write on the frame. Victim advances a shared atomic clock hand and claims a
+ * frame with a compare-and-swap, so concurrent victim searches never wait on each other.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -45,8 +49,19 @@ class ClockReplacer : public Replacer {
 
   auto Size() -> size_t override;
 
+  void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frames) override;
+
  private:
-  // TODO(student): implement me!
+  /** The frame may be victimized. */
+  static constexpr uint8_t EVICTABLE = 1;
+  /** The frame was used since the clock hand last passed it. */
+  static constexpr uint8_t REFERENCED = 2;
+
+  size_t num_pages_;
+  std::unique_ptr<std::atomic<uint8_t>[]> states_;
+  std::atomic<uint64_t> hand_{0};
+  // may briefly be off by the operations in flight, hence signed
+  std::atomic<int64_t> size_{0};
 };
 
 }  // namespace bustub
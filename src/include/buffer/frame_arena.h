@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the frames of a buffer pool instance. The page data of all frames lives in one page-aligned region,
+ * backed by 2 MiB huge pages when the system has them reserved (and advised for transparent huge pages otherwise), so
+ * that a scan over the pool touches few TLB entries and every frame can be the target of O_DIRECT I/O. The frame
+ * headers (Page objects) live in a separate dense array, so that the pin counts and page ids the buffer pool checks
+ * share cache lines with each other instead of with page data.
+ *
+ * Both regions can be bound to a NUMA node.
+ */
+class FrameArena {
+ public:
+  /** Size of a huge page. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+  /**
+   * Creates a new FrameArena.
+   * @param num_frames the number of frames
+   * @param numa_node the NUMA node to place the memory on, or -1 to leave it to the OS
+   */
+  explicit FrameArena(size_t num_frames, int numa_node = -1);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the frame headers, one per frame */
+  auto GetPages() -> Page * { return pages_; }
+
+  /** @return true if the page data is backed by reserved huge pages */
+  auto IsHugeTlb() const -> bool { return huge_tlb_; }
+
+  /**
+   * Give the memory of an unused frame back to the OS. It reads as zeroes when it is touched again. Frames on
+   * reserved huge pages cannot be given back piecemeal and are left alone.
+   * @param frame_id index of the frame
+   */
+  void Discard(size_t frame_id);
+
+  /** @return the NUMA node the arena is bound to, or -1 */
+  auto GetNumaNode() const -> int { return numa_node_; }
+
+  /** @return the number of NUMA nodes of this machine, at least 1 */
+  static auto NumNumaNodes() -> int;
+
+ private:
+  /**
+   * Map an anonymous region.
+   * @param size the size of the region, rounded up to the huge page size if huge is true
+   * @param huge try to back the region with reserved huge pages
+   * @param[out] mapped_size the size actually mapped
+   * @param[out] huge_tlb true if the region is backed by reserved huge pages
+   * @return the region, or nullptr if it could not be mapped
+   */
+  auto Map(size_t size, bool huge, size_t *mapped_size, bool *huge_tlb) -> void *;
+
+  /** Prefer the NUMA node for a region that has not been touched yet. */
+  void Bind(void *addr, size_t size);
+
+  size_t num_frames_;
+  int numa_node_;
+  char *data_{nullptr};
+  size_t data_size_{0};
+  bool huge_tlb_{false};
+  Page *pages_{nullptr};
+  size_t pages_size_{0};
+};
+
+}  // namespace bustub
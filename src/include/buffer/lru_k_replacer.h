@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy. It evicts the frame whose K-th most recent access lies
+ * furthest in the past. Frames with fewer than K accesses have an infinite backward K-distance and are evicted first,
+ * oldest access first, so pages touched once by a sequential scan do not push out pages that are used repeatedly.
+ *
+ * An access is the frame being unpinned for the first time (the page was just brought in) or being pinned again.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of accesses remembered per frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = 2);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frames) override;
+
+ private:
+  struct FrameHistory {
+    /** The timestamps of the last k accesses, oldest first. */
+    std::deque<uint64_t> accesses_;
+    bool evictable_{false};
+  };
+
+  /** @return the queue an evictable frame with this history belongs to */
+  auto QueueOf(const FrameHistory &history) -> std::set<std::pair<uint64_t, frame_id_t>> &;
+
+  size_t k_;
+  std::mutex latch_;
+  uint64_t current_timestamp_{0};
+  std::unordered_map<frame_id_t, FrameHistory> frames_;
+  // evictable frames with fewer than k accesses, ordered by their oldest access
+  std::set<std::pair<uint64_t, frame_id_t>> history_queue_;
+  // evictable frames with k accesses, ordered by their k-th most recent access
+  std::set<std::pair<uint64_t, frame_id_t>> cache_queue_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <mutex>         // NOLINT
+#include <shared_mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps resident page ids to the frames holding them. The map is split into independently latched shards so
+ * that lookups of different pages never contend on a single mutex; lookups of the same page only take a shared latch.
+ */
+class PageTable {
+ public:
+  /** Default number of shards, must be a power of two. */
+  static constexpr size_t DEFAULT_NUM_SHARDS = 16;
+
+  /**
+   * Creates a new PageTable.
+   * @param num_shards the number of shards, rounded up to a power of two
+   */
+  explicit PageTable(size_t num_shards = DEFAULT_NUM_SHARDS);
+
+  ~PageTable() = default;
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * Look up the frame holding a page.
+   * @param page_id id of the page
+   * @param[out] frame_id frame holding the page, if found
+   * @return true if the page is resident, false otherwise
+   */
+  auto Find(page_id_t page_id, frame_id_t *frame_id) -> bool;
+
+  /**
+   * Look up the frame holding a page and invoke fn on it while the shard is latched in shared mode. Entries cannot be
+   * erased while fn runs, so fn may safely take a pin on the frame.
+   * @param page_id id of the page
+   * @param fn callback invoked with the frame id; its return value is returned
+   * @return false if the page is not resident, otherwise the result of fn
+   */
+  template <typename Fn>
+  auto FindAndApply(page_id_t page_id, Fn &&fn) -> bool {
+    auto &shard = GetShard(page_id);
+    std::shared_lock lck(shard.latch_);
+    auto it = shard.map_.find(page_id);
+    if (it == shard.map_.end()) {
+      return false;
+    }
+    return fn(it->second);
+  }
+
+  /**
+   * Like FindAndApply, but latches the shard exclusively, so that no other thread can pin the frame while fn runs.
+   * @param page_id id of the page
+   * @param fn callback invoked with the frame id; its return value is returned
+   * @return false if the page is not resident, otherwise the result of fn
+   */
+  template <typename Fn>
+  auto FindAndApplyExclusive(page_id_t page_id, Fn &&fn) -> bool {
+    auto &shard = GetShard(page_id);
+    std::unique_lock lck(shard.latch_);
+    auto it = shard.map_.find(page_id);
+    if (it == shard.map_.end()) {
+      return false;
+    }
+    return fn(it->second);
+  }
+
+  /**
+   * Insert or overwrite the mapping for a page.
+   * @param page_id id of the page
+   * @param frame_id frame holding the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Erase the mapping for a page if pred holds for its frame. The shard is latched exclusively while pred runs, so no
+   * concurrent FindAndApply can observe the frame in between.
+   * @param page_id id of the page
+   * @param pred predicate invoked with the frame id
+   * @return true if the mapping was erased, false if it was absent or pred rejected it
+   */
+  template <typename Pred>
+  auto EraseIf(page_id_t page_id, Pred &&pred) -> bool {
+    auto &shard = GetShard(page_id);
+    std::unique_lock lck(shard.latch_);
+    auto it = shard.map_.find(page_id);
+    if (it == shard.map_.end() || !pred(it->second)) {
+      return false;
+    }
+    shard.map_.erase(it);
+    return true;
+  }
+
+  /**
+   * Invoke fn on every (page id, frame id) pair. Each shard is latched in shared mode while it is visited.
+   * @param fn callback invoked with each page id and frame id
+   */
+  void ForEach(const std::function<void(page_id_t, frame_id_t)> &fn);
+
+  /** @return number of resident pages */
+  auto Size() -> size_t;
+
+ private:
+  struct alignas(64) Shard {
+    std::shared_mutex latch_;
+    std::unordered_map<page_id_t, frame_id_t> map_;
+  };
+
+  /** Fibonacci hashing spreads the strided page ids of a parallel BPM instance across shards. */
+  inline auto GetShard(page_id_t page_id) -> Shard & {
+    return shards_[(static_cast<uint32_t>(page_id) * 2654435769U) >> shard_shift_];
+  }
+
+  std::vector<Shard> shards_;
+  uint32_t shard_shift_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
@@ -30,9 +32,13 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param pool_size the pool size of each BufferPoolManagerInstance
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param policy the page replacement policy of every BufferPoolManagerInstance
+   * @param max_borrowed_frames how many frames an instance whose frames are all pinned may borrow from the free frames
+   * of the other instances, 0 to keep every instance to its own frames
    */
   ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerPolicy policy = ReplacerPolicy::LRU,
+                            size_t max_borrowed_frames = 0);
 
   /**
    * Destroys an existing ParallelBufferPoolManager.
@@ -42,6 +48,27 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   auto GetPoolSize() -> size_t override;
 
+  /** @return the counters summed over all instances */
+  auto GetStats() -> BufferPoolStats override;
+
+  /**
+   * @param instance_index index of a BufferPoolManagerInstance
+   * @return the counters of that instance, to spot skew between instances
+   */
+  auto GetInstanceStats(size_t instance_index) -> BufferPoolStats;
+
+  /**
+   * Start the background page cleaner of every BufferPoolManagerInstance.
+   * @param low_watermark the cleaner of an instance runs once fewer of its frames are free or clean eviction candidates
+   * @param high_watermark the number of eviction candidates of an instance its cleaner makes clean when it runs
+   * @param interval how often the cleaners check the watermarks
+   */
+  void StartPageCleaner(size_t low_watermark, size_t high_watermark,
+                        std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+  /** Stop the background page cleaner of every BufferPoolManagerInstance. */
+  void StopPageCleaner();
+
  protected:
   /**
    * @param page_id id of page
@@ -56,6 +83,14 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * Fetch the requested page, reading it into a frame of the ring on a miss.
+   * @param page_id id of page to be fetched
+   * @param ring the buffer ring of the calling operation
+   * @return the requested page
+   */
+  auto FetchPgInRingImp(page_id_t page_id, BufferRing *ring) -> Page * override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -78,6 +113,14 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   auto NewPgImp(page_id_t *page_id) -> Page * override;
 
+  /**
+   * Creates a new page in a frame of the ring.
+   * @param[out] page_id id of created page
+   * @param ring the buffer ring of the calling operation
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgInRingImp(page_id_t *page_id, BufferRing *ring) -> Page * override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -86,15 +129,31 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the pages in the buffer pool to disk. The dirty pages of all instances are written in page id order
+   * with coalesced writes, split over one thread per instance, followed by a single sync.
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * Invoke fn with every instance index, each on its own thread, and wait for all of them.
+   * @param fn callback invoked with an instance index
+   */
+  void RunOnInstances(const std::function<void(size_t)> &fn);
+
+  /**
+   * Start reading pages into the responsible BufferPoolManagerInstances without pinning them.
+   * @param page_ids ids of the pages to read ahead
+   * @param ring the buffer ring to read the pages into, or nullptr
+   */
+  void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, BufferRing *ring) override;
+
   //
   size_t num_instances_;
   // all pool_size
   size_t pool_size_;
-  size_t start_index_ = 0;
+  // instance NewPage tries first, advanced round robin
+  std::atomic<size_t> next_instance_{0};
+  DiskManager *disk_manager_;
   // num_instances buffer_pool
   // std::vector<BufferPoolManagerInstance> buffer_pools_;
   BufferPoolManagerInstance *buffer_pools_;
@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead.h
+//
+// Identification: src/include/buffer/read_ahead.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * ReadAhead follows a scan along a chain of pages (a table heap's next-page chain, a leaf sibling chain) and prefetches
+ * the pages it will reach next. The page after the current one is known from the page itself and always prefetched.
+ * Once the scan has stepped through page ids with the same stride a few times, the chain is assumed to continue that
+ * way and a whole window of pages is prefetched ahead, so that reads stay in flight while earlier pages are processed.
+ */
+class ReadAhead {
+ public:
+  /** Default number of pages prefetched ahead of a sequential scan. */
+  static constexpr size_t DEFAULT_WINDOW = 16;
+  /** Number of steps with the same stride after which a scan counts as sequential. */
+  static constexpr size_t SEQUENTIAL_THRESHOLD = 2;
+
+  /**
+   * Creates a new ReadAhead.
+   * @param bpm the buffer pool to prefetch into, nullptr disables read-ahead
+   * @param ring the buffer ring of the scan, or nullptr. The window is kept to half the ring, so that prefetched pages
+   * are not recycled before the scan gets to them.
+   * @param window the number of pages to prefetch ahead of a sequential scan
+   */
+  explicit ReadAhead(BufferPoolManager *bpm, BufferRing *ring = nullptr, size_t window = DEFAULT_WINDOW)
+      : bpm_(bpm), ring_(ring), window_(ring == nullptr ? window : std::min(window, ring->GetRingSize() / 2)) {}
+
+  /**
+   * Tell the read-ahead that the scan is on a page. Calling this again for the same page does nothing.
+   * @param page_id id of the page the scan is on
+   * @param next_page_id id of the page after it, or INVALID_PAGE_ID if this is the last one or it is unknown
+   */
+  void OnPage(page_id_t page_id, page_id_t next_page_id);
+
+ private:
+  BufferPoolManager *bpm_;
+  BufferRing *ring_;
+  size_t window_;
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+  page_id_t stride_{0};
+  size_t run_{0};
+  /** The furthest page prefetched along the current run. */
+  page_id_t prefetched_until_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
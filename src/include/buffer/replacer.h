@@ -12,10 +12,16 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** The replacement policies a buffer pool can be built with. */
+enum class ReplacerPolicy { LRU, LRU_K, TWO_Q, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -24,6 +30,14 @@ class Replacer {
   Replacer() = default;
   virtual ~Replacer() = default;
 
+  /**
+   * Create a replacer.
+   * @param policy the replacement policy
+   * @param num_pages the maximum number of pages the replacer will be required to store
+   * @return the replacer
+   */
+  static auto Create(ReplacerPolicy policy, size_t num_pages) -> std::unique_ptr<Replacer>;
+
   /**
    * Remove the victim frame as defined by the replacement policy.
    * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
@@ -43,8 +57,22 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Forget a frame entirely, e.g. because its page was deleted. Policies that keep an access history drop it here.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual auto Size() -> size_t = 0;
+
+  /**
+   * Peek at the frames that would be victimized next, without removing them. Replacers that cannot predict their
+   * victims report none.
+   * @param max_frames the maximum number of frames to report
+   * @param[out] frames the frames, in the order they would be victimized
+   */
+  virtual void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frames) {}
 };
 
 }  // namespace bustub
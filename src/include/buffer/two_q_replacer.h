@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.h
+//
+// Identification: src/include/buffer/two_q_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * TwoQReplacer implements the simplified 2Q replacement policy. Frames referenced once sit in a FIFO queue (A1); a
+ * frame referenced again while resident moves to an LRU queue (Am). Victims come from A1 as long as it holds more
+ * than its share of the frames, so a sequential scan only churns A1 and leaves the hot pages in Am alone.
+ *
+ * The replacer only knows frames, not page ids, so there is no ghost queue of recently evicted pages (A1out) as in
+ * full 2Q.
+ */
+class TwoQReplacer : public Replacer {
+ public:
+  /** Default share of the frames kept in A1, in percent. */
+  static constexpr size_t DEFAULT_A1_PERCENT = 25;
+
+  /**
+   * Create a new TwoQReplacer.
+   * @param num_pages the maximum number of pages the TwoQReplacer will be required to store
+   * @param a1_percent the share of the frames A1 may hold before victims are taken from it first, in percent
+   */
+  explicit TwoQReplacer(size_t num_pages, size_t a1_percent = DEFAULT_A1_PERCENT);
+
+  /**
+   * Destroys the TwoQReplacer.
+   */
+  ~TwoQReplacer() override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frames) override;
+
+ private:
+  struct FrameEntry {
+    /** True once the frame was referenced again, i.e. it belongs to Am. */
+    bool hot_{false};
+    bool evictable_{false};
+    /** Position in a1_ or am_, valid while evictable_. */
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  /** @return true if the next victim comes from A1 */
+  auto VictimFromA1() const -> bool;
+
+  size_t a1_max_;
+  std::mutex latch_;
+  std::unordered_map<frame_id_t, FrameEntry> frames_;
+  // evictable frames referenced once, oldest first
+  std::list<frame_id_t> a1_;
+  // evictable frames referenced again, least recently used first
+  std::list<frame_id_t> am_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics.h
+//
+// Identification: src/include/common/util/metrics.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <string>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * StripedCounter is an event counter cheap enough to stay on in hot paths. Increments are relaxed and go to one of a
+ * few cache line sized stripes picked per thread, so that threads counting the same event rarely share a cache line.
+ */
+class StripedCounter {
+ public:
+  /** Number of stripes, threads beyond this share stripes. */
+  static constexpr size_t NUM_STRIPES = 16;
+
+  StripedCounter() = default;
+  DISALLOW_COPY_AND_MOVE(StripedCounter);
+
+  /** Count n events. */
+  inline void Add(uint64_t n = 1) { stripes_[StripeIndex()].value_.fetch_add(n, std::memory_order_relaxed); }
+
+  /** @return the number of events counted so far, not a consistent snapshot while others count */
+  auto Get() const -> uint64_t {
+    uint64_t sum = 0;
+    for (const auto &stripe : stripes_) {
+      sum += stripe.value_.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  struct alignas(64) Stripe {
+    std::atomic<uint64_t> value_{0};
+  };
+
+  static auto StripeIndex() -> size_t {
+    static std::atomic<size_t> next_stripe{0};
+    thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % NUM_STRIPES;
+    return stripe;
+  }
+
+  std::array<Stripe, NUM_STRIPES> stripes_;
+};
+
+/**
+ * A point in time copy of a LatencyHistogram. Bucket 0 counts zero durations, bucket i > 0 counts durations in
+ * [2^(i-1), 2^i) nanoseconds; the last bucket also takes everything longer.
+ */
+struct HistogramSnapshot {
+  static constexpr size_t NUM_BUCKETS = 40;
+
+  std::array<uint64_t, NUM_BUCKETS> buckets_{};
+  uint64_t count_{0};
+  uint64_t sum_nanos_{0};
+
+  /** @return the mean duration in nanoseconds, 0 if nothing was recorded */
+  auto MeanNanos() const -> double;
+
+  /**
+   * @param quantile a quantile in [0, 1], e.g. 0.99
+   * @return an upper bound of the quantile in nanoseconds, the end of the bucket it falls into
+   */
+  auto PercentileNanos(double quantile) const -> uint64_t;
+
+  /** Add the samples of another snapshot, e.g. of another instance. */
+  auto operator+=(const HistogramSnapshot &other) -> HistogramSnapshot &;
+
+  /** @return count, mean and percentiles on one line */
+  auto ToString() const -> std::string;
+
+  /** @return count, mean and percentiles as a JSON object */
+  auto ToJson() const -> std::string;
+};
+
+/**
+ * LatencyHistogram records durations into power of two buckets with relaxed atomics, so recording is a few
+ * instructions and never blocks.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram() = default;
+  DISALLOW_COPY_AND_MOVE(LatencyHistogram);
+
+  /** Record one duration. */
+  inline void Record(std::chrono::steady_clock::duration duration) {
+    auto nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    size_t bucket = nanos == 0 ? 0 : 64 - __builtin_clzll(nanos);
+    if (bucket >= HistogramSnapshot::NUM_BUCKETS) {
+      bucket = HistogramSnapshot::NUM_BUCKETS - 1;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum_nanos_.fetch_add(nanos, std::memory_order_relaxed);
+  }
+
+  /** @return a copy of the buckets, not a consistent snapshot while others record */
+  auto Snapshot() const -> HistogramSnapshot;
+
+  /** Records the lifetime of the timer into a histogram. */
+  class Timer {
+   public:
+    explicit Timer(LatencyHistogram *histogram) : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~Timer() { histogram_->Record(std::chrono::steady_clock::now() - start_); }
+    DISALLOW_COPY_AND_MOVE(Timer);
+
+   private:
+    LatencyHistogram *histogram_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+ private:
+  std::array<std::atomic<uint64_t>, HistogramSnapshot::NUM_BUCKETS> buckets_{};
+  std::atomic<uint64_t> sum_nanos_{0};
+};
+
+}  // namespace bustub
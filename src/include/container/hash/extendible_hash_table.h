@@ -30,6 +30,11 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * Lookups, inserts and removes read the directory without latching it and latch only the bucket of the key. A split
+ * write latches the full bucket and then the directory page, whose version (see Page::GetVersion) thus goes up with
+ * every change of the directory; a reader that finds the version changed by the time it has latched its bucket
+ * retries. Only merges, which delete buckets, exclude all other operations.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTable {
@@ -137,7 +142,20 @@ class ExtendibleHashTable {
   auto FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE *;
 
   /**
-   * Performs insertion with an optional bucket splitting.
+   * Latch the bucket a key maps to. The directory is read without a latch, and the bucket is only returned if the
+   * directory version is still the one read once the bucket is latched: a split latches the bucket it splits before it
+   * changes the directory, so the bucket is then the one the key maps to until it is unlatched.
+   *
+   * @param key the key for lookup
+   * @param dir_page the pinned directory page
+   * @param exclusive whether to write latch the bucket instead of read latching it
+   * @return the pinned and latched bucket page
+   */
+  auto LatchBucket(const KeyType &key, Page *dir_page, bool exclusive) -> Page *;
+
+  /**
+   * Performs insertion with an optional bucket splitting. The split holds the latches of the full bucket and the
+   * directory page, not the table latch, so operations on other buckets go on meanwhile.
    *
    * @param transaction a pointer to the current transaction
    * @param key the key to insert
@@ -166,9 +184,12 @@ class ExtendibleHashTable {
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
+  // Readers includes inserts, removes and splits, writers are merges
   ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
+  // merged away buckets that were still pinned, e.g. by a concurrent FlushAllPages, when they were deleted; retried by
+  // the next merge, guarded by table_latch_
+  std::vector<page_id_t> deferred_deletes_;
 };
 
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "common/rid.h"
@@ -23,7 +24,10 @@
 namespace bustub {
 
 /**
- * IndexScanExecutor executes an index scan over a table.
+ * IndexScanExecutor executes an index scan over a table, returning the tuples whose keys lie in the range of the plan
+ * in key order, or in descending key order. It takes the RIDs from the index a leaf at a time and fetches their tuples
+ * in chunks in the order of their RIDs, so that every heap page of a chunk is read once, in page order and ahead of
+ * time. The chunks start small and double in size, so that a scan cut short by a LIMIT of k reads about k tuples.
  */
 
 class IndexScanExecutor : public AbstractExecutor {
@@ -42,7 +46,26 @@ class IndexScanExecutor : public AbstractExecutor {
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
  private:
+  /** Fetch the tuples of the next chunk of RIDs, @return false once the index has no more */
+  auto FetchChunk() -> bool;
+
+  /** The number of tuples in the first chunk. */
+  static constexpr size_t FIRST_CHUNK_SIZE = 16;
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  TableInfo *table_info_{nullptr};
+  std::unique_ptr<IndexRangeScan> scan_;
+  /** RIDs of the current batch from the index in key order. */
+  std::vector<RID> rids_;
+  /** Position in rids_ of the first RID of the current chunk, and the number of RIDs in it. */
+  size_t chunk_start_{0};
+  size_t chunk_size_{0};
+  /** Positions in rids_ of the current chunk in the order of the RIDs. */
+  std::vector<size_t> rid_order_;
+  /** Tuples of the current chunk in key order; those that are gone or fail the predicate are left unallocated. */
+  std::vector<Tuple> tuples_;
+  /** Position of the next tuple to return. */
+  size_t cursor_{0};
 };
 }  // namespace bustub
@@ -54,7 +54,12 @@ class InsertExecutor : public AbstractExecutor {
   /** @return The output schema for the insert */
   auto GetOutputSchema() -> const Schema * override { return plan_->OutputSchema(); };
 
-  void InsertIntoTableAndUpdateIndex(Tuple tuple);
+  /**
+   * Insert a tuple into the table and all of its indexes.
+   * @param tuple the tuple to insert
+   * @param ring the buffer ring of a bulk insert, or nullptr
+   */
+  void InsertIntoTableAndUpdateIndex(Tuple tuple, BufferRing *ring = nullptr);
 
  private:
   /** The insert plan node to be executed*/
@@ -62,6 +67,8 @@ class InsertExecutor : public AbstractExecutor {
   TableInfo *table_info_{nullptr};
   TableHeap *table_heap_{nullptr};
   std::unique_ptr<AbstractExecutor> child_executor_;
+  /** Inserts pulled from a child executor are bulk loads, they recycle their own frames */
+  BufferRing ring_;
 };
 
 }  // namespace bustub
@@ -51,6 +51,8 @@ class SeqScanExecutor : public AbstractExecutor {
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   TableHeap *table_heap_{nullptr};
+  /** The scan recycles its own frames, so that it does not push the working set out of the buffer pool */
+  BufferRing ring_;
   TableIterator table_iter_{nullptr, RID{}, nullptr};
 };
 }  // namespace bustub
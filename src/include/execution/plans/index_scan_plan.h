@@ -12,13 +12,19 @@
 
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "catalog/catalog.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
 
 namespace bustub {
 /**
- * IndexScanPlanNode identifies a table that should be scanned with an optional predicate.
+ * IndexScanPlanNode identifies a table that should be scanned through an index, over a range of keys and with an
+ * optional predicate. The range is given by values of the leading key columns, so that a bound on a prefix of the key
+ * leaves the other columns open; a scan for a key prefix passes the prefix as both bounds. The tuples come in key
+ * order, or in descending key order, so that the scan can satisfy an ORDER BY on the key.
  */
 class IndexScanPlanNode : public AbstractPlanNode {
  public:
@@ -27,24 +33,49 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * @param output the output format of this scan plan node
    * @param predicate the predicate to scan with, tuples are returned if predicate(tuple) == true or predicate ==
    * nullptr
-   * @param table_oid the identifier of table to be scanned
+   * @param index_oid the identifier of the index to scan the table through
+   * @param low_key values of the leading key columns that the keys of the scanned tuples are at least, empty to scan
+   * from the first key
+   * @param high_key values of the leading key columns that the keys of the scanned tuples are at most, empty to scan
+   * to the last key
+   * @param descending whether to return the tuples in descending key order, from the high key down
    */
-  IndexScanPlanNode(const Schema *output, const AbstractExpression *predicate, index_oid_t index_oid)
-      : AbstractPlanNode(output, {}), predicate_{predicate}, index_oid_(index_oid) {}
+  IndexScanPlanNode(const Schema *output, const AbstractExpression *predicate, index_oid_t index_oid,
+                    std::vector<Value> low_key = {}, std::vector<Value> high_key = {}, bool descending = false)
+      : AbstractPlanNode(output, {}),
+        predicate_{predicate},
+        index_oid_(index_oid),
+        low_key_(std::move(low_key)),
+        high_key_(std::move(high_key)),
+        descending_(descending) {}
 
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
   /** @return the predicate to test tuples against; tuples should only be returned if they evaluate to true */
   auto GetPredicate() const -> const AbstractExpression * { return predicate_; }
 
-  /** @return the identifier of the table that should be scanned */
+  /** @return the identifier of the index to scan the table through */
   auto GetIndexOid() const -> index_oid_t { return index_oid_; }
 
+  /** @return the values of the leading key columns that the scanned keys are at least */
+  auto GetLowKey() const -> const std::vector<Value> & { return low_key_; }
+
+  /** @return the values of the leading key columns that the scanned keys are at most */
+  auto GetHighKey() const -> const std::vector<Value> & { return high_key_; }
+
+  /** @return whether the tuples are returned in descending key order */
+  auto IsDescending() const -> bool { return descending_; }
+
  private:
   /** The predicate that all returned tuples must satisfy. */
   const AbstractExpression *predicate_;
-  /** The table whose tuples should be scanned. */
+  /** The index to scan the table through. */
   index_oid_t index_oid_;
+  /** The bounds of the scanned keys, both inclusive. */
+  std::vector<Value> low_key_;
+  std::vector<Value> high_key_;
+  /** Whether the scan runs in descending key order. */
+  bool descending_;
 };
 
 }  // namespace bustub
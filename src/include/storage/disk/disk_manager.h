@@ -12,29 +12,73 @@
 
 #pragma once
 
+#include <sys/types.h>
+
 #include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <string>
 
 #include "common/config.h"
+#include "common/util/metrics.h"
+#include "storage/disk/free_space_map.h"
+#include "storage/disk/page_map.h"
 
 namespace bustub {
 
+class DiskScheduler;
+
+/**
+ * A snapshot of the I/O counters of a DiskManager, see DiskManager::GetStats.
+ */
+struct DiskStats {
+  /** Pages written, as counted by GetNumWrites. */
+  uint64_t pages_written_{0};
+  /** Bytes read from and written to the database file; less than a page per page when pages are compressed. */
+  uint64_t bytes_read_{0};
+  uint64_t bytes_written_{0};
+  /** Latency of page reads, one sample per page. */
+  HistogramSnapshot read_latency_;
+  /** Latency of writes, one sample per write call; a vectored write of a run of pages is one sample. */
+  HistogramSnapshot write_latency_;
+  /** Latency of Sync calls. */
+  HistogramSnapshot sync_latency_;
+
+  /** @return one histogram per line */
+  auto ToString() const -> std::string;
+
+  /** @return the counters as a JSON object */
+  auto ToJson() const -> std::string;
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
  */
 class DiskManager {
+  // The asynchronous backends issue their I/O against the database file descriptor directly.
+  friend class DiskScheduler;
+
  public:
+  /** Alignment of buffers, offsets and sizes that O_DIRECT I/O requires. */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+  static_assert(PAGE_SIZE % DIRECT_IO_ALIGNMENT == 0);
+
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io true to bypass the OS page cache with O_DIRECT, so that pages are only cached by the buffer pool.
+   * Falls back to buffered I/O if the file system does not support it.
+   * @param compress_pages true to store pages compressed, in slots of a page map saved next to the database file. A
+   * database must always be opened the same way. Compressed pages are not aligned, so this implies buffered I/O.
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false, bool compress_pages = false);
 
-  ~DiskManager() = default;
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -55,6 +99,60 @@ class DiskManager {
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Write a run of consecutive pages to the database file with as few vectored writes as possible.
+   * @param page_id id of the first page of the run
+   * @param pages raw page data of page_id, page_id + 1, ...
+   * @param num_pages number of pages in the run
+   * @return false on an I/O error
+   */
+  auto WritePages(page_id_t page_id, const char *const *pages, size_t num_pages) -> bool;
+
+  /**
+   * Asynchronously write a page to the database file. page_data must stay valid until the future is ready.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @return a future that becomes true once the page is written, false on an I/O error
+   */
+  auto WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<bool>;
+
+  /**
+   * Asynchronously read a page from the database file. page_data must stay valid until the future is ready.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   * @return a future that becomes true once the page is read, false on an I/O error
+   */
+  auto ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<bool>;
+
+  /**
+   * Make all page writes so far durable. Page writes are not synced individually, callers sync at their own
+   * checkpoints, e.g. the end of a buffer pool flush.
+   * @return false on an I/O error
+   */
+  auto Sync() -> bool;
+
+  /**
+   * Deallocate a page, so that its id and its space in the database file can be handed out again. The free space map
+   * is saved next to the database file on Sync and ShutDown.
+   * @param page_id id of the page to deallocate
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /**
+   * @return one past the highest page id the database file holds or the free space map lists. A buffer pool reopened
+   * on the file hands out new ids from here on, so that the pages that are still in use are not handed out again.
+   */
+  auto GetNumPages() -> page_id_t;
+
+  /** @return the pages deallocated so far and not reused yet */
+  auto GetFreeSpaceMap() -> FreeSpaceMap * { return &free_space_map_; }
+
+  /** @return true if the database file is accessed with O_DIRECT */
+  auto IsDirectIO() const -> bool { return direct_io_; }
+
+  /** @return true if pages are stored compressed */
+  auto IsCompressed() const -> bool { return compress_pages_; }
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -80,6 +178,9 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return a snapshot of the page I/O latency histograms */
+  auto GetStats() const -> DiskStats;
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -91,18 +192,57 @@ class DiskManager {
 
  private:
   auto GetFileSize(const std::string &file_name) -> int;
+  /** pwrite a page without touching the counters. @return false on an I/O error */
+  auto WritePageImp(page_id_t page_id, const char *page_data) -> bool;
+  /** pread a page, zero filling whatever lies past the end of the file. @return false on an I/O error */
+  auto ReadPageImp(page_id_t page_id, char *page_data) -> bool;
+  /** Compress a page into the slots the page map picks for it. @return false on an I/O error */
+  auto WriteCompressedPage(page_id_t page_id, const char *page_data) -> bool;
+  /** Read and decompress a page, a page never written reads as zeros. @return false on an I/O error */
+  auto ReadCompressedPage(page_id_t page_id, char *page_data) -> bool;
+  /** pwrite all of a buffer. @return false on an I/O error */
+  auto WriteAt(const char *data, size_t size, off_t offset) -> bool;
+  /** pread up to size bytes, fewer at the end of the file. @return the number of bytes read, -1 on an I/O error */
+  auto ReadAt(char *data, size_t size, off_t offset) -> ssize_t;
+  /** @return the asynchronous I/O backend, started on first use */
+  auto GetScheduler() -> DiskScheduler *;
+  /** @return true if a buffer may be used for I/O on the database file as it is */
+  inline auto IsUsableBuffer(const char *page_data) const -> bool {
+    return !direct_io_ || reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT == 0;
+  }
+
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // db file, accessed with positional reads and writes so that concurrent page I/Os need no latch
+  int db_fd_{-1};
+  bool direct_io_{false};
   std::string file_name_;
+  // deallocated pages, saved to fsm_name_
+  FreeSpaceMap free_space_map_;
+  std::string fsm_name_;
+  // where the compressed pages are, saved to page_map_name_
+  bool compress_pages_{false};
+  PageMap page_map_;
+  std::string page_map_name_;
+  // held shared by a compressed page write from placing its image until it is written, and exclusively by Sync to take
+  // a snapshot of the page map that only points at written images
+  std::shared_mutex place_latch_;
+  // one Sync at a time, so that the saved maps follow each other in order
+  std::mutex sync_latch_;
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<uint64_t> bytes_read_{0};
+  std::atomic<uint64_t> bytes_written_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
+  // page I/O latencies, see GetStats
+  LatencyHistogram read_latency_;
+  LatencyHistogram write_latency_;
+  LatencyHistogram sync_latency_;
+  // backend for ReadPageAsync/WritePageAsync
+  std::once_flag scheduler_init_;
+  std::unique_ptr<DiskScheduler> scheduler_;
 };
 
 }  // namespace bustub
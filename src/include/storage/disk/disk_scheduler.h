@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.h
+//
+// Identification: src/include/storage/disk/disk_scheduler.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
+#include <memory>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * A single page read or write handed to a DiskScheduler.
+ */
+struct DiskRequest {
+  /** True for a write, false for a read. */
+  bool is_write_;
+  /** Page buffer to read into or write from, must stay valid until the request completes. */
+  char *data_;
+  /** Page to read or write. */
+  page_id_t page_id_;
+  /** Fulfilled with true once the I/O is done, false on an I/O error. */
+  std::promise<bool> callback_;
+};
+
+/**
+ * DiskScheduler keeps many page I/Os of a DiskManager in flight at once and completes them through futures. It is
+ * backed by io_uring when the kernel supports it, and by a pool of pread/pwrite workers otherwise.
+ */
+class DiskScheduler {
+ public:
+  /** Number of I/Os the io_uring backend keeps in flight, and the number of workers of the fallback pool. */
+  static constexpr size_t DEFAULT_QUEUE_DEPTH = 64;
+  static constexpr size_t DEFAULT_NUM_WORKERS = 4;
+
+  /**
+   * Creates the best available scheduler for a disk manager.
+   * @param disk_manager the disk manager whose database file is read and written
+   * @param try_io_uring false to always use the thread pool
+   * @return an io_uring scheduler if io_uring can be set up, a thread pool scheduler otherwise
+   */
+  static auto Create(DiskManager *disk_manager, bool try_io_uring = true) -> std::unique_ptr<DiskScheduler>;
+
+  explicit DiskScheduler(DiskManager *disk_manager) : disk_manager_(disk_manager) {}
+
+  /** Waits for all outstanding requests and stops the backend. */
+  virtual ~DiskScheduler() = default;
+
+  /**
+   * Submit a request. Its callback is fulfilled once the I/O completes, possibly on another thread.
+   * @param request the request to submit
+   */
+  virtual void Schedule(std::unique_ptr<DiskRequest> request) = 0;
+
+  /** @return true if this scheduler uses io_uring */
+  virtual auto IsIoUring() const -> bool { return false; }
+
+ protected:
+  /** @return the database file descriptor */
+  auto DbFd() const -> int { return disk_manager_->db_fd_; }
+
+  /** Record the latency and size of a request the backend performed without going through the DiskManager. */
+  void RecordCompletion(const DiskRequest &request, std::chrono::steady_clock::time_point start, size_t bytes) {
+    (request.is_write_ ? disk_manager_->write_latency_ : disk_manager_->read_latency_)
+        .Record(std::chrono::steady_clock::now() - start);
+    (request.is_write_ ? disk_manager_->bytes_written_ : disk_manager_->bytes_read_) += bytes;
+  }
+
+  /** Synchronously perform a request on the calling thread. @return false on an I/O error */
+  auto Perform(const DiskRequest &request) -> bool {
+    return request.is_write_ ? disk_manager_->WritePageImp(request.page_id_, request.data_)
+                             : disk_manager_->ReadPageImp(request.page_id_, request.data_);
+  }
+
+  DiskManager *disk_manager_;
+};
+
+}  // namespace bustub
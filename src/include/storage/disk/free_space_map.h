@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/disk/free_space_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap tracks the pages of a database file that were deallocated and may be handed out again. It is a bitmap
+ * with one bit per page, grouped into extents of EXTENT_SIZE pages that are searched a word at a time, so that the
+ * lowest free pages are found quickly and reused pages come out as ascending runs.
+ *
+ * The map only knows about freed pages; which ids were ever allocated is up to the caller. It can be saved to and
+ * loaded from a small file next to the database file.
+ */
+class FreeSpaceMap {
+ public:
+  /** Number of pages per extent, i.e. per bitmap word. */
+  static constexpr size_t EXTENT_SIZE = 64;
+
+  FreeSpaceMap() = default;
+  DISALLOW_COPY_AND_MOVE(FreeSpaceMap);
+
+  /**
+   * Mark a page as free.
+   * @param page_id id of the page
+   */
+  void Free(page_id_t page_id);
+
+  /**
+   * Mark a page as in use.
+   * @param page_id id of the page
+   * @return true if the page was free
+   */
+  auto Claim(page_id_t page_id) -> bool;
+
+  /**
+   * Find the lowest free page in [from, end), without claiming it.
+   * @param from first page id to consider
+   * @param end first page id not to consider
+   * @return the id of the free page, INVALID_PAGE_ID if there is none
+   */
+  auto FindFree(page_id_t from, page_id_t end) -> page_id_t;
+
+  /** @return true if the page is free */
+  auto IsFree(page_id_t page_id) -> bool;
+
+  /** @return one past the highest free page, 0 if no page is free */
+  auto End() -> page_id_t;
+
+  /** @return the number of free pages */
+  auto NumFree() const -> size_t { return num_free_.load(std::memory_order_relaxed); }
+
+  /**
+   * Save the map if it changed since it was last saved or loaded. An empty map removes the file instead. The file is
+   * replaced atomically, so a crash leaves either the old or the new map behind.
+   * @param file_name the file to save to
+   * @return false on an I/O error
+   */
+  auto Save(const std::string &file_name) -> bool;
+
+  /**
+   * Replace the map with one saved before. A missing or malformed file leaves the map empty.
+   * @param file_name the file to load from
+   * @return true if a map was loaded
+   */
+  auto Load(const std::string &file_name) -> bool;
+
+ private:
+  /** Identifies a saved map, followed by the number of extents and the extents themselves. */
+  static constexpr uint64_t MAGIC = 0x3150414d45455246;  // "FREEMAP1"
+
+  std::mutex latch_;
+  /** Bit i of extent e is set if page e * EXTENT_SIZE + i is free. */
+  std::vector<uint64_t> extents_;
+  /** Lets Claim and FindFree skip the latch while nothing is free, the common case of a growing file. */
+  std::atomic<size_t> num_free_{0};
+  bool dirty_{false};
+};
+
+}  // namespace bustub
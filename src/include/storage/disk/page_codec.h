@@ -0,0 +1,47 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_codec.h
+//
+// Identification: src/include/storage/disk/page_codec.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * PageCodec is a small LZ77 codec in the spirit of LZ4, fast enough to sit on the page I/O path. A compressed block is
+ * a sequence of (literals, match) pairs: a token byte holding both lengths in a nibble each, extra length bytes for
+ * long runs, the literals, and a two byte backwards offset of the match. The last sequence has literals only.
+ */
+class PageCodec {
+ public:
+  /**
+   * Compress a block.
+   * @param src the data to compress
+   * @param src_size size of the data, at most 64 KiB
+   * @param[out] dst buffer for the compressed block
+   * @param dst_capacity size of dst
+   * @return the size of the compressed block, 0 if it does not fit into dst_capacity bytes
+   */
+  static auto Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) -> size_t;
+
+  /**
+   * Decompress a block written by Compress.
+   * @param src the compressed block
+   * @param src_size size of the compressed block
+   * @param[out] dst buffer for the data
+   * @param dst_size size of the data, as passed to Compress
+   * @return false if the block is malformed or does not decompress to exactly dst_size bytes
+   */
+  static auto Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) -> bool;
+};
+
+}  // namespace bustub
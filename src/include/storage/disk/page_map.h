@@ -0,0 +1,140 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_map.h
+//
+// Identification: src/include/storage/disk/page_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageMap records where the compressed image of each page lives in a database file. The file is divided into slots
+ * of SLOT_SIZE bytes and every page occupies a run of consecutive slots, as many as its image needs.
+ *
+ * A page that is rewritten stays in its run if the new image fits, otherwise it moves to a new run. Runs a page left
+ * are only reused once a map taken after they were left is saved, since the saved map may still point at them until
+ * then.
+ */
+class PageMap {
+ public:
+  /** Granularity of the space a page image takes in the file. */
+  static constexpr size_t SLOT_SIZE = 512;
+  static_assert(PAGE_SIZE % SLOT_SIZE == 0);
+
+  PageMap() = default;
+  DISALLOW_COPY_AND_MOVE(PageMap);
+
+  /**
+   * Look up the image of a page.
+   * @param page_id id of the page
+   * @param[out] offset byte offset of the image in the file
+   * @param[out] length length of the image in bytes
+   * @return false if the page was never written
+   */
+  auto Find(page_id_t page_id, uint64_t *offset, uint32_t *length) -> bool;
+
+  /**
+   * Find room for a new image of a page and map the page to it.
+   * @param page_id id of the page
+   * @param length length of the new image in bytes, at most PAGE_SIZE
+   * @return byte offset to write the image at
+   */
+  auto Place(page_id_t page_id, uint32_t length) -> uint64_t;
+
+  /**
+   * Unmap a page and release its slots.
+   * @param page_id id of the page
+   */
+  void Remove(page_id_t page_id);
+
+  /** @return the number of slots up to the end of the last run in use or saved */
+  auto NumSlots() -> uint64_t;
+
+  /** @return one past the highest page id that was ever mapped since the map was created or loaded */
+  auto NumPages() -> page_id_t;
+
+  /** Where the image of a page lives. */
+  struct Entry {
+    uint32_t first_slot_;
+    /** Length of the image in bytes, 0 if the page is not mapped. */
+    uint32_t length_;
+  };
+
+  /** Where each page was at one point in time, and the runs left before then; see TakeSnapshot. */
+  struct Snapshot {
+    /** Whether the map changed since the last snapshot or load, there is nothing to save otherwise. */
+    bool dirty_{false};
+    std::vector<Entry> entries_;
+    std::vector<std::pair<uint32_t, uint32_t>> released_runs_;
+  };
+
+  /**
+   * Copy the map as it is now, to be saved once the images it points to are durable. Pages placed meanwhile do not
+   * change the copy.
+   * @return the copy, without entries if the map did not change since the last snapshot or load
+   */
+  auto TakeSnapshot() -> Snapshot;
+
+  /**
+   * Save a snapshot, then make the runs left before it available. The file is replaced atomically. The images the
+   * snapshot points to must be durable by now. If saving fails the snapshot is discarded.
+   * @param file_name the file to save to
+   * @param snapshot a snapshot taken by TakeSnapshot
+   * @return false on an I/O error
+   */
+  auto Save(const std::string &file_name, Snapshot snapshot) -> bool;
+
+  /**
+   * Give up on saving a snapshot: the map counts as changed again, and the runs left before the snapshot stay held
+   * back until a later snapshot is saved.
+   */
+  void Discard(Snapshot snapshot);
+
+  /**
+   * Replace the map with one saved before. A missing or malformed file leaves the map empty.
+   * @param file_name the file to load from
+   * @return true if a map was loaded
+   */
+  auto Load(const std::string &file_name) -> bool;
+
+ private:
+  /** Identifies a saved map, followed by the number of entries and the entries themselves. */
+  static constexpr uint64_t MAGIC = 0x3150414d45474150;  // "PAGEMAP1"
+
+
+  static auto SlotsFor(uint32_t length) -> uint32_t { return (length + SLOT_SIZE - 1) / SLOT_SIZE; }
+
+  /** First fit in the free runs, or at the end of the file. */
+  auto AllocateSlots(uint32_t count) -> uint32_t;
+  /** Add a run to the free runs, merging it with its neighbours. */
+  void AddFreeRun(uint32_t first_slot, uint32_t count);
+
+  std::mutex latch_;
+  /** Indexed by page id. */
+  std::vector<Entry> entries_;
+  /** Runs that may be handed out, first slot to number of slots. */
+  std::map<uint32_t, uint32_t> free_runs_;
+  /** Runs given up since the last Save. */
+  std::vector<std::pair<uint32_t, uint32_t>> released_runs_;
+  uint32_t end_slot_{0};
+  bool dirty_{false};
+};
+
+}  // namespace bustub
@@ -10,12 +10,17 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
+#include "storage/index/posting_list_store.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
@@ -23,15 +28,34 @@ namespace bustub {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
+/** What a descent to a leaf is for, which decides the latches it takes. */
+enum class BPlusTreeOperation { SEARCH, INSERT, DELETE };
+
 /**
  * Main class providing the API for the Interactive B+ Tree.
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique, or in a non-unique tree each key is stored once with the list of its values, see
+ * PostingListStore; ValueType is RID then
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
- * (4) Implement index iterator for range scan
+ * (4) Implement index iterator for range scan, in both directions
+ *
+ * Pages store their keys without the prefix shared by their key range and without padding, see BPlusTreeLeafPage.
+ * leaf_max_size and internal_max_size only limit the max size of a page, which is otherwise as many entries as fit.
+ *
+ * Every page knows the range of keys it covers, between its low key and high key, and links to its right sibling on
+ * the same level (a B-link tree). Lookups, scans and the first attempt of inserts and removes descend without latching
+ * anything but the leaf (optimistic lock coupling): they read each page from a copy that the version of the page
+ * proves consistent, see Page::GetVersion, and go on to a child only while the page is unchanged since the copy. A
+ * page that split since its parent was read is passed by moving right to the sibling that now covers the key, a page
+ * that was merged away or lost the key to its left sibling sends the descent back to the root. Readers thus never
+ * hold a latch that a writer waits for, and no descent latches the root.
+ * Inserts and removes write latch the leaf they reach, which is enough unless the leaf splits or underflows. Only then
+ * they start over from the root with write latches, taken top down and holding on to the latches of all pages that
+ * may change, from the lowest safe ancestor down, in the page set of the transaction. Since pages only split, merge or
+ * move keys to a sibling under the write latch of their parent, these descents need not move right.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
@@ -40,24 +64,34 @@ class BPlusTree {
 
  public:
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     bool unique = true);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
 
+  // Returns true if a key has at most one value.
+  auto IsUnique() const -> bool { return unique_; }
+
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
 
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
-  // return the value associated with a given key
+  // Remove one value of a key, and the key along with its last one.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *transaction);
+
+  // return the values associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
 
   // index iterator
   auto Begin() -> INDEXITERATOR_TYPE;
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
   auto End() -> INDEXITERATOR_TYPE;
+  // reverse index iterator, from the last key or the last key not greater than key down; it ends at End()
+  auto RBegin() -> INDEXITERATOR_TYPE;
+  auto RBegin(const KeyType &key) -> INDEXITERATOR_TYPE;
 
   // print the B+ tree
   void Print(BufferPoolManager *bpm);
@@ -70,7 +104,19 @@ class BPlusTree {
 
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
-  // expose for test purpose
+
+  /**
+   * Build the tree bottom up from pairs in increasing key order, writing every page once and in order. The tree must
+   * be empty. A pair whose key equals the one before is dropped, unless the tree is non-unique, which adds its value
+   * to the key. BPlusTreeBuilder sorts the pairs first.
+   * @param next produces the next pair, returns false after the last one
+   * @param num_pairs how many pairs next produces at most; the shape of the tree is planned for this many pairs, so
+   * with fewer the pages at the right edge of the tree end up less full
+   * @param fill_factor share of the capacity of a page to fill, leaving room for later inserts
+   * @return the number of pairs loaded
+   */
+  auto BulkLoad(const std::function<bool(MappingType *)> &next, size_t num_pairs, double fill_factor) -> size_t;
+  // expose for test purpose, the leaf is returned pinned but not latched
   auto FindLeafPage(const KeyType &key, bool leftMost = false) -> Page *;
 
  private:
@@ -84,20 +130,125 @@ class BPlusTree {
   template <typename N>
   auto Split(N *node) -> N *;
 
+  /** Remove a value of a key, or the key with all its values if value is nullptr. */
+  void RemoveValue(const KeyType &key, const ValueType *value, Transaction *transaction);
+
+  /**
+   * Remove a value of a key, or the key with all its values if value is nullptr, from the write latched leaf of the
+   * key. Removing a value from a posting list leaves the key in place.
+   * @param safe_only leave the key in place if removing it may underflow the leaf
+   * @param[out] dirty set if the leaf or a posting list changed
+   * @return false if the key was left in place since removing it may underflow the leaf
+   */
+  auto RemoveFromLeaf(LeafPage *leaf, const KeyType &key, const ValueType *value, bool safe_only, bool *dirty) -> bool;
+
+  /**
+   * A leaf whose prev link has to point at a new left neighbour, and that neighbour, both pinned. The link is set by
+   * LinkBack once the latches are released.
+   */
+  struct LeafLink {
+    Page *page_{nullptr};
+    Page *prev_page_{nullptr};
+  };
+
   template <typename N>
-  auto CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr) -> bool;
+  auto CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr, LeafLink *link = nullptr) -> bool;
 
   template <typename N>
   auto Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent,
-                int index, Transaction *transaction = nullptr) -> bool;
+                int index, Transaction *transaction = nullptr, LeafLink *link = nullptr) -> bool;
 
   template <typename N>
-  void Redistribute(N *neighbor_node, N *node, int index);
+  void Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index);
 
   auto AdjustRoot(BPlusTreePage *node) -> bool;
 
   void UpdateRootPageId(int insert_record = 0);
 
+  /**
+   * Descend to the leaf that covers a key without latching, moving right past pages that split since their parent
+   * was read.
+   * @param[out] snapshot a buffer of PAGE_SIZE bytes to copy the leaf into, or nullptr to stop at the leaf without
+   * reading it; only a copied leaf is known to cover the key
+   * @return the pinned leaf, nullptr if the tree is empty
+   */
+  auto FindLeafOptimistic(const KeyType &key, char *snapshot) -> Page *;
+
+  /**
+   * Latch the leaf that covers a key, moving right while the latched leaf turns out to have split.
+   * @param exclusive write latch the leaf instead of read latching it
+   * @return the pinned and latched leaf, nullptr if the tree is empty
+   */
+  auto LatchLeaf(const KeyType &key, bool exclusive) -> Page *;
+
+  /**
+   * Check a page reached by a descent for a key, which may have changed since its parent was read.
+   * @param[out] next_page_id the right sibling to move to if the key lies past the range of the page, INVALID_PAGE_ID
+   * otherwise
+   * @return false if the page was merged away or the key lies before its range, so the descent has to start over
+   */
+  auto CheckRange(const KeyType &key, BPlusTreePage *node, page_id_t *next_page_id) const -> bool;
+
+  /** Copy a page once no writer holds it, @return the version of the page the copy is consistent with */
+  static auto ReadSnapshot(Page *page, char *snapshot) -> uint64_t;
+
+  /**
+   * Write latch down to the leaf that holds a key. The root latch and every page whose latch is still held, the leaf
+   * included, end up in the page set of the transaction; release them with ReleaseLatches.
+   * @return the pinned and latched leaf, nullptr if the tree is empty
+   */
+  auto FindLeafPessimistic(const KeyType &key, BPlusTreeOperation op, Transaction *transaction) -> Page *;
+
+  /** @return true if op cannot change the structure above the node, so the latches above it may be released */
+  auto IsSafe(BPlusTreePage *node, BPlusTreeOperation op) const -> bool;
+
+  /** Release all latches in the page set of the transaction and unpin their pages. */
+  void ReleaseLatches(Transaction *transaction, bool is_dirty);
+
+  /**
+   * Delete the pages in the deleted page set of the transaction; call after their latches are released. A page still
+   * pinned by an iterator cannot be deleted yet, it is kept in deferred_deletes_ and retried by the next call.
+   */
+  void DeletePages(Transaction *transaction);
+
+  /**
+   * Pin the leaf after a write latched leaf, which may sit under another parent, so that its prev link can be pointed
+   * at that leaf by LinkBack. The leaf after cannot go away meanwhile, since it is only ever merged into the latched one.
+   * @return the link to set, with no page if the leaf is the last one
+   */
+  auto PendLinkBack(LeafPage *prev_leaf) -> LeafLink;
+
+  /**
+   * Point the prev link of a leaf back at its new left neighbour and unpin both; call after all latches are released.
+   * Taking the latch of the leaf while holding a latched path deadlocks, since a leaf under another parent is latched
+   * left to right there while internal siblings are latched right to left. Here the leaf latch is the only one held
+   * and the neighbour is read without latching it. The link is only set while the neighbour still links to the leaf;
+   * if the neighbour split since, the leaf is linked to the page the split put before it. A leaf or neighbour merged
+   * away meanwhile is left to the link of that merge. So a prev link may lag behind the leaf chain for a moment,
+   * readers going down the prev links check it against the next link of the page they get to.
+   */
+  void LinkBack(const LeafLink &link);
+
+  /** Fetch a page of the tree, throwing if the buffer pool is out of frames. */
+  auto FetchTreePage(page_id_t page_id) -> Page *;
+
+  /** One level of a bulk loaded tree: how its entries are spread over its pages, and the page being filled. */
+  struct LoadLevel {
+    size_t num_entries_;
+    size_t num_nodes_;
+    /** Index of the page being filled. */
+    size_t node_{0};
+    /** The pinned page being filled, and how many entries it gets. */
+    Page *page_{nullptr};
+    size_t target_{0};
+  };
+
+  /**
+   * @return the page of a bulk load level the next entry goes to, starting a new page once the current one has all
+   * its entries; the first key of a new page becomes its separator key in the level above
+   */
+  auto LoadNodeFor(std::vector<LoadLevel> *levels, size_t level, const KeyType &first_key) -> Page *;
+
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const;
 
@@ -105,11 +256,25 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  /** Changed under root_latch_ only; read without it by IsEmpty and optimistic descents. */
+  std::atomic<page_id_t> root_page_id_;
+  /**
+   * Guards changes of root_page_id_. A pessimistic descent holds it until the root page is latched. In a page set it
+   * shows as nullptr.
+   */
+  ReaderWriterLatch root_latch_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
+  /** Number of leading bytes of a key that decide its order, the pages do not store the rest. */
+  size_t key_size_;
   int leaf_max_size_;
   int internal_max_size_;
+  bool unique_;
+  /** The posting lists of the keys of a non-unique tree with more than one value. */
+  PostingListStore postings_;
+  /** Unreachable pages that were still pinned when their deletion was due, guarded by deferred_latch_. */
+  std::vector<page_id_t> deferred_deletes_;
+  std::mutex deferred_latch_;
 };
 
 }  // namespace bustub
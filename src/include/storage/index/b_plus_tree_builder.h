@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_builder.h
+//
+// Identification: src/include/storage/index/b_plus_tree_builder.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+#include "common/macros.h"
+#include "storage/index/b_plus_tree.h"
+
+namespace bustub {
+
+#define BPLUSTREE_BUILDER_TYPE BPlusTreeBuilder<KeyType, ValueType, KeyComparator>
+
+/**
+ * BPlusTreeBuilder fills an empty B+ tree from pairs in any order. It sorts the pairs and bulk loads the tree bottom
+ * up, instead of descending from the root for every pair. Pairs that do not fit into memory are sorted in runs that
+ * are spilled to temporary files and merged while loading, so that both the spill and the load write sequentially.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeBuilder {
+ public:
+  /** Leave some room in every page, so that the first inserts after the build do not split every page. */
+  static constexpr double DEFAULT_FILL_FACTOR = 0.9;
+  /** Number of pairs sorted in memory at a time. */
+  static constexpr size_t DEFAULT_RUN_SIZE = 1 << 20;
+
+  /**
+   * @param tree the empty tree to fill
+   * @param comparator the comparator of the tree
+   * @param fill_factor share of the capacity of a page to fill
+   * @param run_size number of pairs to sort in memory before spilling a run
+   */
+  BPlusTreeBuilder(BPlusTree<KeyType, ValueType, KeyComparator> *tree, const KeyComparator &comparator,
+                   double fill_factor = DEFAULT_FILL_FACTOR, size_t run_size = DEFAULT_RUN_SIZE);
+  ~BPlusTreeBuilder();
+
+  DISALLOW_COPY_AND_MOVE(BPlusTreeBuilder);
+
+  /** Add a pair to the tree. Of pairs with equal keys only one is kept, unless the tree is non-unique. */
+  void Add(const KeyType &key, const ValueType &value);
+
+  /**
+   * Sort the pairs added so far and load them into the tree.
+   * @return the number of pairs loaded
+   */
+  auto Finish() -> size_t;
+
+  /** @return the number of runs spilled so far */
+  auto NumRuns() const -> size_t { return runs_.size(); }
+
+ private:
+  /** Number of pairs read from a run at a time while merging. */
+  static constexpr size_t MERGE_BLOCK_SIZE = 4096;
+
+  /** A sorted run in a temporary file. */
+  struct Run {
+    std::FILE *file_;
+    size_t size_;
+  };
+
+  /** Reads a run back a block at a time. */
+  class RunReader {
+   public:
+    explicit RunReader(const Run &run) : file_(run.file_), remaining_(run.size_) { Refill(); }
+    auto Head() const -> const MappingType & { return block_[pos_]; }
+    /** @return false once the run is exhausted */
+    auto Next() -> bool { return ++pos_ < block_.size() || Refill(); }
+
+   private:
+    auto Refill() -> bool;
+
+    std::FILE *file_;
+    size_t remaining_;
+    std::vector<MappingType> block_;
+    size_t pos_{0};
+  };
+
+  /** Sort the buffered pairs, dropping duplicate keys, or duplicate pairs for a non-unique tree. */
+  void SortBuffer();
+  void SpillRun();
+  auto MergeRuns() -> size_t;
+
+  BPlusTree<KeyType, ValueType, KeyComparator> *tree_;
+  KeyComparator comparator_;
+  double fill_factor_;
+  size_t run_size_;
+  std::vector<MappingType> buffer_;
+  std::vector<Run> runs_;
+};
+
+}  // namespace bustub
@@ -14,9 +14,11 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_builder.h"
 #include "storage/index/index.h"
 
 namespace bustub {
@@ -34,16 +36,54 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  void BulkInsertEntries(const std::function<bool(Tuple *key, RID *rid)> &next, Transaction *transaction) override;
+
+  auto ScanRange(const std::vector<Value> &low_key, const std::vector<Value> &high_key, bool descending,
+                 Transaction *transaction) -> std::unique_ptr<IndexRangeScan> override;
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
 
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
+  auto GetReverseBeginIterator() -> INDEXITERATOR_TYPE;
+
+  auto GetReverseBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
+
  protected:
+  /**
+   * Scans the leaves from an iterator on, a leaf at a time, until a key is past the bound at the end of the range:
+   * above the high key, or below the low key for a descending scan.
+   */
+  class RangeScan : public IndexRangeScan {
+   public:
+    /**
+     * @param iterator the iterator at the first pair of the range
+     * @param end_key the bound at the end of the range
+     * @param end_length the number of leading bytes of a key that the bound applies to
+     * @param descending whether the iterator is a reverse iterator
+     */
+    RangeScan(INDEXITERATOR_TYPE &&iterator, const KeyType &end_key, size_t end_length, bool descending)
+        : iterator_(std::move(iterator)), end_key_(end_key), end_length_(end_length), descending_(descending) {}
+
+    auto NextBatch(std::vector<RID> *rids) -> bool override;
+
+   private:
+    INDEXITERATOR_TYPE iterator_;
+    KeyType end_key_;
+    size_t end_length_;
+    bool descending_;
+    /** The pairs of the last batch taken from the iterator. */
+    std::vector<MappingType> pairs_;
+  };
+
+  /** @return the values of the leading key columns cast to the types of the columns */
+  auto CastKeyPrefix(const std::vector<Value> &values) const -> std::vector<Value>;
+
   // comparator for key
   KeyComparator comparator_;
-  // container
+  // container, non-unique: a key is stored once with the RIDs of all tuples that have it
   BPlusTree<KeyType, ValueType, KeyComparator> container_;
 };
 
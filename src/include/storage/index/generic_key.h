@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
+#include "storage/index/key_encoding.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -24,43 +27,44 @@ namespace bustub {
  *
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
- * with a template argument.
+ * with a template argument. The key columns are stored in the order
+ * preserving encoding of KeyEncoding, so that keys compare with memcmp.
  */
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
-    // intialize to 0
-    memset(data_, 0, KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+  inline void SetFromKey(const Tuple &tuple, const Schema *key_schema) {
+    KeyEncoding::Encode(tuple, key_schema, data_, KeySize);
+  }
+
+  // the smallest key that starts with the leading key columns, returns the length of their encoding
+  inline auto SetFromPrefix(const std::vector<Value> &values) -> size_t {
+    return KeyEncoding::EncodePrefix(values, data_, KeySize);
   }
 
   // NOTE: for test purpose only
+  // encode as a single BIGINT column
   inline void SetFromInteger(int64_t key) {
+    char encoded[sizeof(int64_t)];
+    KeyEncoding::EncodeBigInt(key, encoded);
     memset(data_, 0, KeySize);
-    memcpy(data_, &key, sizeof(int64_t));
+    memcpy(data_, encoded, std::min(KeySize, sizeof(int64_t)));
   }
 
   inline auto ToValue(Schema *schema, uint32_t column_idx) const -> Value {
-    const char *data_ptr;
-    const auto &col = schema->GetColumn(column_idx);
-    const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
-    }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    return KeyEncoding::Decode(data_, KeySize, schema, column_idx);
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  inline auto ToString() const -> int64_t { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
+  // decode the first 8 bytes as a BIGINT column
+  inline auto ToString() const -> int64_t {
+    char encoded[sizeof(int64_t)] = {};
+    memcpy(encoded, data_, std::min(KeySize, sizeof(int64_t)));
+    return KeyEncoding::DecodeBigInt(encoded);
+  }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
+  // decode the first 8 bytes as a BIGINT column
   friend auto operator<<(std::ostream &os, const GenericKey &key) -> std::ostream & {
     os << key.ToString();
     return os;
@@ -72,35 +76,31 @@ class GenericKey {
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * Encoded keys order like their bytes. Keys of fixed width columns are zero padded past their encoded length, which
+ * does not need to be compared.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
-    uint32_t column_count = key_schema_->GetColumnCount();
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
-        return -1;
-      }
-      if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
-        return 1;
-      }
-    }
-    // equals
-    return 0;
+    int cmp = memcmp(lhs.data_, rhs.data_, compare_size_);
+    return (cmp > 0) - (cmp < 0);
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  GenericComparator(const GenericComparator &other) = default;
 
   // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  explicit GenericComparator(Schema *key_schema) {
+    size_t fixed_length = KeyEncoding::FixedLength(key_schema);
+    compare_size_ = fixed_length == 0 ? KeySize : std::min(fixed_length, KeySize);
+  }
+
+  /** @return the number of leading bytes that decide the order of keys */
+  inline auto CompareSize() const -> size_t { return compare_size_; }
 
  private:
-  Schema *key_schema_;
+  size_t compare_size_;
 };
 
 }  // namespace bustub
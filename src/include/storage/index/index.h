@@ -12,12 +12,15 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/exception.h"
+#include "common/rid.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -100,6 +103,22 @@ class IndexMetadata {
 // Index class definition
 /////////////////////////////////////////////////////////////////////
 
+/**
+ * A scan over a range of keys of an index, which hands out the RIDs of the entries in key order, or in descending key
+ * order, a batch at a time.
+ */
+class IndexRangeScan {
+ public:
+  virtual ~IndexRangeScan() = default;
+
+  /**
+   * Get the next batch of RIDs.
+   * @param[out] rids replaced with the next batch
+   * @return false once the range is exhausted
+   */
+  virtual auto NextBatch(std::vector<RID> *rids) -> bool = 0;
+};
+
 /**
  * class Index - Base class for derived indices of different types
  *
@@ -175,6 +194,35 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Insert many entries into an empty index, e.g. all tuples of a table the index is created on. Index types that
+   * build faster from all entries at once override it, by default the entries are inserted one by one.
+   * @param next Produces the next index key and RID, returns false after the last entry
+   * @param transaction The transaction context
+   */
+  virtual void BulkInsertEntries(const std::function<bool(Tuple *key, RID *rid)> &next, Transaction *transaction) {
+    Tuple key;
+    RID rid;
+    while (next(&key, &rid)) {
+      InsertEntry(key, rid, transaction);
+    }
+  }
+
+  /**
+   * Scan the entries whose keys lie between two bounds, both inclusive, in key order. A bound may give only the
+   * leading columns of the key, it then bounds those columns and leaves the others open; a prefix predicate passes
+   * the prefix as both bounds. Only ordered index types support it.
+   * @param low_key values of the leading key columns that the keys are at least, empty for no lower bound
+   * @param high_key values of the leading key columns that the keys are at most, empty for no upper bound
+   * @param descending whether to scan in descending key order, from the high key down
+   * @param transaction The transaction context
+   * @return the scan, positioned before its first batch
+   */
+  virtual auto ScanRange(const std::vector<Value> &low_key, const std::vector<Value> &high_key, bool descending,
+                         Transaction *transaction) -> std::unique_ptr<IndexRangeScan> {
+    throw NotImplementedException("the index type does not support range scans");
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
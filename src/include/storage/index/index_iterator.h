@@ -13,31 +13,93 @@
  * For range scan of b+ tree
  */
 #pragma once
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * IndexIterator walks the leaf chain of a B+ tree, forwards along the next links or in reverse along the prev links.
+ * It keeps its current leaf pinned but not latched. When it comes to a leaf, it copies out the pairs from its position
+ * to the end of the leaf, or to its start in reverse, as one batch under a brief read latch, and starts reading in the
+ * following leaf, so that a scan neither holds up writers nor waits for the disk on every leaf. A scan that runs
+ * concurrently with writers may miss or repeat pairs that move within or between leaves while it is not latched.
+ * In a non-unique tree, a key with a posting list yields one pair for each of its values, in increasing order of
+ * the values, or decreasing in reverse.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
  public:
-  // you may define your own constructor based on your member variables
+  /** Create the end iterator. */
   IndexIterator();
+  /**
+   * Create an iterator at a position in a leaf, or the first position after it if there is no pair at the index.
+   * @param buffer_pool_manager the buffer pool of the tree
+   * @param page a pinned and read latched leaf page; the iterator takes over the pin and releases the latch
+   * @param index index of the pair in the leaf
+   * @param reverse whether to iterate in descending key order
+   * @param unique whether the tree is unique, otherwise values may refer to posting lists
+   */
+  IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index, bool reverse = false,
+                bool unique = true);
   ~IndexIterator();  // NOLINT
 
+  DISALLOW_COPY(IndexIterator);
+  IndexIterator(IndexIterator &&other) noexcept;
+  auto operator=(IndexIterator &&other) noexcept -> IndexIterator &;
+
   auto IsEnd() -> bool;
 
   auto operator*() -> const MappingType &;
 
   auto operator++() -> IndexIterator &;
 
-  auto operator==(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  /**
+   * Take the rest of the batch the iterator copied out of its leaf, from the pair under the iterator on, and move on to
+   * the first pair after it.
+   * @param[out] batch replaced with the pairs
+   */
+  void TakeBatch(std::vector<MappingType> *batch);
+
+  auto operator==(const IndexIterator &itr) const -> bool {
+    return page_ == itr.page_ && index_ == itr.index_ && batch_pos_ == itr.batch_pos_;
+  }
 
-  auto operator!=(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator!=(const IndexIterator &itr) const -> bool { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  /**
+   * Move to the first pair at or after index_ in the order of the iterator, starting with page_ read latched, copy out
+   * the batch from there and release the latch.
+   */
+  void Settle();
+
+  /**
+   * Leave the read latched current leaf for another one, pinned while the current one is still latched, and read latch
+   * it; the iterator ends if there is no other one.
+   */
+  void MoveTo(page_id_t page_id);
+
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  /** The pinned current leaf, nullptr at the end. */
+  Page *page_{nullptr};
+  /** Index in the current leaf of the pair the next batch starts from, the one after the batch once it is copied. */
+  int index_{0};
+  /** Copies of the pairs of the current leaf, with posting lists expanded, in the order of the iterator. */
+  std::vector<MappingType> batch_;
+  /** Position of the pair under the iterator in the batch. */
+  size_t batch_pos_{0};
+  /** Whether the iterator goes down the prev links in descending key order. */
+  bool reverse_{false};
+  bool unique_{true};
 };
 
 }  // namespace bustub
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_encoding.h
+//
+// Identification: src/include/storage/index/key_encoding.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * KeyEncoding turns index keys into byte strings that memcmp orders like the keys, column by column:
+ *
+ * - integers and booleans: big-endian with the sign bit flipped, so negative values come first
+ * - timestamps: big-endian
+ * - decimals: big-endian IEEE 754 bits, all flipped for negative values and only the sign flipped otherwise
+ * - varchars: the bytes with every 0x00 escaped as 0x00 0xFF, then 0x00 0x01; NULL is 0x00 0x00
+ *
+ * Other NULLs are the minimum value of their type, so they sort first as well. The encoding is truncated to the size
+ * of the buffer, keys that agree up to there compare equal.
+ */
+class KeyEncoding {
+ public:
+  /**
+   * Encode a key, zero filling the rest of the buffer.
+   * @param key tuple of the key columns
+   * @param key_schema schema of the key tuple
+   * @param[out] data buffer of size bytes
+   * @param size size of the buffer
+   */
+  static void Encode(const Tuple &key, const Schema *key_schema, char *data, size_t size);
+
+  /**
+   * Encode the leading columns of a key, zero filling the rest of the buffer. The encoding of every key with these
+   * leading columns starts with the result.
+   * @param values values of the leading key columns, each of the type of its column
+   * @param[out] data buffer of size bytes
+   * @param size size of the buffer
+   * @return the length of the encoding, more than size if it was truncated
+   */
+  static auto EncodePrefix(const std::vector<Value> &values, char *data, size_t size) -> size_t;
+
+  /**
+   * Decode a column of an encoded key.
+   * @param data encoded key of size bytes
+   * @param size size of the encoded key
+   * @param key_schema schema of the key
+   * @param column_idx the column to decode
+   * @return the value of the column, or NULL of its type if the key was truncated before it
+   */
+  static auto Decode(const char *data, size_t size, const Schema *key_schema, uint32_t column_idx) -> Value;
+
+  /** @return the encoded length of a key of the schema, or 0 if it depends on the values */
+  static auto FixedLength(const Schema *key_schema) -> size_t;
+
+  /** Encode and decode a BIGINT on its own, for keys built from integers. */
+  static void EncodeBigInt(int64_t value, char *data);
+  static auto DecodeBigInt(const char *data) -> int64_t;
+
+ private:
+  /** @return the encoded width of a fixed width type */
+  static auto FixedWidth(TypeId type) -> size_t;
+};
+
+}  // namespace bustub
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_search.h
+//
+// Identification: src/include/storage/index/key_search.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+/**
+ * Search kernels for the sorted key slots of B+ tree pages.
+ *
+ * A page stores its keys as byte strings that memcmp orders like the keys, each at the start of a fixed width slot.
+ * The binary search halves the range without branching on the outcome of a comparison, which the CPU cannot predict
+ * for random lookups. Every probe selects the next range with a conditional move instead, so a search over n keys
+ * always takes log2(n) steps without pipeline flushes. Keys of up to 8 bytes, such as a single integer column or
+ * what is left of a longer key once a page drops the prefix all its keys share, are compared as one integer loaded
+ * straight from the slot; longer keys go through memcmp.
+ */
+class KeySearch {
+ public:
+  /**
+   * @return the first of the indexes 0 to size - 1 for which less is false, size if there is none. less must be true
+   * for a prefix of the indexes and false for the rest.
+   */
+  template <typename Less>
+  static auto PartitionPoint(int size, Less less) -> int {
+    if (size == 0) {
+      return 0;
+    }
+    int base = 0;
+    int length = size;
+    while (length > 1) {
+      int half = length / 2;
+      base = less(base + half - 1) ? base + half : base;
+      length -= half;
+    }
+    return base + (less(base) ? 1 : 0);
+  }
+
+  /**
+   * @param slots size slots of slot_width bytes, each starting with a key of key_width bytes, in increasing order
+   * @param key the key_width bytes to search for
+   * @return the index of the first key not less than key, size if there is none
+   */
+  static auto LowerBound(const char *slots, size_t slot_width, int size, const char *key, size_t key_width) -> int {
+    if (key_width <= sizeof(uint64_t) && slot_width >= sizeof(uint64_t)) {
+      uint64_t mask = Mask(key_width);
+      uint64_t bits = Probe(key, key_width);
+      return PartitionPoint(size, [=](int i) { return (Load(slots + i * slot_width) & mask) < bits; });
+    }
+    return PartitionPoint(size, [=](int i) { return memcmp(slots + i * slot_width, key, key_width) < 0; });
+  }
+
+  /** @return the index of the first key greater than key, size if there is none */
+  static auto UpperBound(const char *slots, size_t slot_width, int size, const char *key, size_t key_width) -> int {
+    if (key_width <= sizeof(uint64_t) && slot_width >= sizeof(uint64_t)) {
+      uint64_t mask = Mask(key_width);
+      uint64_t bits = Probe(key, key_width);
+      return PartitionPoint(size, [=](int i) { return (Load(slots + i * slot_width) & mask) <= bits; });
+    }
+    return PartitionPoint(size, [=](int i) { return memcmp(slots + i * slot_width, key, key_width) <= 0; });
+  }
+
+ private:
+  /** @return 8 bytes as a big-endian integer, which orders like the bytes */
+  static auto Load(const char *data) -> uint64_t {
+    uint64_t bits;
+    memcpy(&bits, data, sizeof(bits));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    bits = __builtin_bswap64(bits);
+#endif
+    return bits;
+  }
+
+  /** @return a key of up to 8 bytes as a big-endian integer, zero padded */
+  static auto Probe(const char *key, size_t key_width) -> uint64_t {
+    char padded[sizeof(uint64_t)] = {};
+    memcpy(padded, key, key_width);
+    return Load(padded);
+  }
+
+  /** @return the bits of a loaded integer that belong to a key of key_width bytes */
+  static auto Mask(size_t key_width) -> uint64_t {
+    return key_width == 0 ? 0 : ~uint64_t{0} << (8 * (sizeof(uint64_t) - key_width));
+  }
+};
+
+}  // namespace bustub
@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posting_list_store.h
+//
+// Identification: src/include/storage/index/posting_list_store.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+/**
+ * PostingListStore keeps the RIDs of the keys of a non-unique B+ tree, which stores every key once. The value of a key
+ * with a single RID is that RID. The value of a key with more refers to its posting list instead: its RIDs in
+ * increasing order, delta encoded into a few bytes each (see Encode). A list of up to MAX_SHARED_LENGTH bytes shares
+ * a posting page with the lists of other keys (see BPlusTreePostingPage), a longer one gets a chain of overflow pages
+ * of its own (see BPlusTreeOverflowPage).
+ *
+ * A list belongs to its key and is only read under a latch of the leaf of the key, and only changed under its write
+ * latch. Posting pages are also latched, since they hold the lists of other keys. New lists go to the posting page
+ * filled last, and a page is deleted once its last list is gone.
+ */
+class PostingListStore {
+ public:
+  /** The longest encoded list that shares a posting page. */
+  static constexpr size_t MAX_SHARED_LENGTH = PAGE_SIZE / 8;
+
+  explicit PostingListStore(BufferPoolManager *buffer_pool_manager);
+
+  /** @return whether the value of a key refers to a posting list, rather than being the only RID of the key */
+  static auto IsPostingList(const RID &value) -> bool { return (value.GetSlotNum() & LIST_FLAG) != 0; }
+
+  /**
+   * Read the RIDs of a key.
+   * @param value the value of the key
+   * @param[out] rids the RIDs are appended to it in increasing order
+   */
+  static void Read(BufferPoolManager *buffer_pool_manager, const RID &value, std::vector<RID> *rids);
+
+  /**
+   * Store the RIDs of a key.
+   * @param rids the RIDs, which end up sorted and without duplicates
+   * @return the value of the key
+   */
+  auto Create(std::vector<RID> *rids) -> RID;
+
+  /**
+   * Add a RID to a key.
+   * @param[in,out] value the value of the key, replaced with the new one
+   * @return false if the key has the RID already
+   */
+  auto Add(RID *value, const RID &rid) -> bool;
+
+  /**
+   * Remove a RID from a key with a posting list; the RID left over becomes the value of a key with one left.
+   * @param[in,out] value the value of the key, replaced with the new one
+   * @return false if the key does not have the RID
+   */
+  auto Remove(RID *value, const RID &rid) -> bool;
+
+  /** Free the posting list of a key that is removed, if it has one. */
+  void Free(const RID &value);
+
+  /**
+   * Encode RIDs in increasing order: each is the varint of the difference to the page id of the RID before, then the
+   * varint of its slot number, less the slot number after the one of the RID before if that is on the same page.
+   * @param[out] data the encoding is appended to it
+   */
+  static void Encode(std::vector<RID>::const_iterator begin, std::vector<RID>::const_iterator end,
+                     std::vector<char> *data);
+
+  /** Decode RIDs, appending them to rids. */
+  static void Decode(const char *data, size_t length, std::vector<RID> *rids);
+
+ private:
+  /** Set in the slot number of the value of a key with a posting list, which real slot numbers never are. */
+  static constexpr uint32_t LIST_FLAG = 1U << 31;
+  /** Set as well if the list is in an overflow chain, the page id of the value is the first page of the chain then. */
+  static constexpr uint32_t CHAIN_FLAG = 1U << 30;
+
+  /** Store at least one sorted RID, @return the value of their key */
+  auto Store(const std::vector<RID> &rids) -> RID;
+
+  /**
+   * Change the RIDs of a list in a posting page, moving them to wherever they fit afterwards.
+   * @param change changes the RIDs, which must stay sorted and not empty; returns false to leave them unchanged
+   */
+  template <typename Change>
+  auto UpdateShared(RID *value, Change change) -> bool;
+
+  /** @return the value of a list stored in the posting page filled last, or in a new page if it does not fit */
+  auto StoreShared(const std::vector<char> &data) -> RID;
+  void FreeShared(page_id_t page_id, int slot);
+  /** Delete a posting page if it is empty and new lists do not go to it. */
+  void DropSharedPage(page_id_t page_id);
+
+  /** @return the value of RIDs stored in a new overflow chain, as many in each page as fit */
+  auto CreateChain(const std::vector<RID> &rids) -> RID;
+  auto AddToChain(page_id_t head_page_id, const RID &rid) -> bool;
+  auto RemoveFromChain(page_id_t head_page_id, const RID &rid) -> bool;
+  void FreeChain(page_id_t head_page_id);
+
+  /** Fetch and allocate pages, throwing if the buffer pool is out of frames. */
+  static auto FetchPage(BufferPoolManager *buffer_pool_manager, page_id_t page_id) -> Page *;
+  auto NewPage(page_id_t *page_id) -> Page *;
+
+  BufferPoolManager *buffer_pool_manager_;
+  /** Guards fill_page_id_, and the posting page it names against being deleted. */
+  std::mutex latch_;
+  /** The posting page new lists go to, INVALID_PAGE_ID until the first one is needed. */
+  page_id_t fill_page_id_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
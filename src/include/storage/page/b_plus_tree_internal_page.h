@@ -17,8 +17,9 @@
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_HEADER_SIZE (40 + 2 * sizeof(KeyType))
+// the most children an internal page can hold, once its keys are all prefix
+#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / sizeof(ValueType))
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -27,25 +28,55 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
+ * Separator keys are truncated like the keys of a leaf page, see BPlusTreeLeafPage: the prefix shared by the range of
+ * the page is stored once, and the padding after the key size not at all. The range of a child is bounded by the keys
+ * around it, and by the low key and high key of this page at the edges. The next page id links the page to its right
+ * sibling, which covers the range after its high key.
+ *
  * Internal page format (keys are stored in increasing order):
  *  --------------------------------------------------------------------------
  * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
  *  --------------------------------------------------------------------------
+ *
+ *  Header format (size in byte, 40 + 2 * sizeof(KeyType) in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) | MinSize (4) |
+ *  ---------------------------------------------------------------------
+ *  --------------------------------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) | SizeLimit (4) | KeySize (2) | PrefixSize (2)
+ *  --------------------------------------------------------------------------------------------
+ *  ---------------------
+ * | LowKey | HighKey |
+ *  ---------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
-  // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
+  // must call initialize method after "create" a new node; the page covers all keys until its fences are set
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE,
+            size_t key_size = sizeof(KeyType));
 
+  auto GetNextPageId() const -> page_id_t;
+  void SetNextPageId(page_id_t next_page_id);
   auto KeyAt(int index) const -> KeyType;
   void SetKeyAt(int index, const KeyType &key);
   auto ValueIndex(const ValueType &value) const -> int;
   auto ValueAt(int index) const -> ValueType;
 
+  // key range of the page, all keys of the page but the first must be in the new range, the first becomes its low key
+  auto GetLowKey() const -> const KeyType &;
+  auto GetHighKey() const -> const KeyType &;
+  void SetFences(const KeyType &low_key, const KeyType &high_key);
+  // the max size of a page of this one's key size and size limit that covers the range
+  auto MaxSizeFor(const KeyType &low_key, const KeyType &high_key) const -> int;
+  // how many children fit into a page of slots for keys of key_size bytes with a prefix of prefix_size bytes
+  static auto Capacity(size_t key_size, size_t prefix_size) -> int;
+
   auto Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   auto InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value) -> int;
+  // bulk loading appends children in key order, their parent page id is set by the caller
+  void Append(const KeyType &key, const ValueType &value);
   void Remove(int index);
   auto RemoveAndReturnOnlyChild() -> ValueType;
 
@@ -58,10 +89,20 @@ class BPlusTreeInternalPage : public BPlusTreePage {
                          BufferPoolManager *buffer_pool_manager);
 
  private:
-  void CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
   void CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
   void CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
+  void Adopt(page_id_t child_page_id, BufferPoolManager *buffer_pool_manager);
+  auto SlotWidth() const -> size_t;
+  auto SlotAt(int index) -> char *;
+  auto SlotAt(int index) const -> const char *;
+  void SetValueAt(int index, const ValueType &value);
+  page_id_t next_page_id_;
+  int size_limit_;
+  uint16_t key_size_;
+  uint16_t prefix_size_;
+  KeyType low_key_;
+  KeyType high_key_;
   // Flexible array member for page data.
-  MappingType array_[1];
+  char slots_[1];
 };
 }  // namespace bustub
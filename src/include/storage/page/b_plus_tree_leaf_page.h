@@ -18,44 +18,75 @@
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_HEADER_SIZE (44 + 2 * sizeof(KeyType))
+// the most pairs a leaf page can hold, once its keys are all prefix
+#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(ValueType))
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
- * page. Only support unique key.
+ * page. Each key is stored once. In a non-unique tree the value of a key with
+ * more than one record id refers to its posting list instead, which holds them
+ * all (see PostingListStore::IsPostingList).
+ *
+ * Keys are compressed. A page covers the range of keys between its low key and its high key, which are the separator
+ * keys around it in its parent, or the smallest and the largest key at the edges of the tree. All keys in the range
+ * share the prefix that the low key and the high key have in common, so that prefix is only stored once, in the low
+ * key. Each slot holds the rest of a key up to the key size, the number of leading bytes that decide the order of
+ * keys; the padding of a key after those bytes is not stored at all. Since the range of a page only narrows as it
+ * splits, inserts never shorten its prefix, and the max size of the page follows from the width of its slots. Keys
+ * must order like their first key size bytes, as encoded GenericKeys do.
  *
  * Leaf page format (keys are stored in order):
  *  ----------------------------------------------------------------------
  * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 28 bytes in total):
+ *  Header format (size in byte, 44 + 2 * sizeof(KeyType) in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) | MinSize (4) |
  *  ---------------------------------------------------------------------
- * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
+ *  ------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) | PrevPageId (4) |
+ *  ------------------------------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | SizeLimit (4) | KeySize (2) | PrefixSize (2) | LowKey | HighKey |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
-  // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
+  // method to set default values; the page covers all keys until its fences are set
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE,
+            size_t key_size = sizeof(KeyType));
   // helper methods
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
+  auto GetPrevPageId() const -> page_id_t;
+  void SetPrevPageId(page_id_t prev_page_id);
   auto KeyAt(int index) const -> KeyType;
+  auto ValueAt(int index) const -> ValueType;
+  // replace the value of a key, as a non-unique tree does when the posting list of the key changes
+  void SetValueAt(int index, const ValueType &value);
   auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
-  auto GetItem(int index) -> const MappingType &;
+  auto GetItem(int index) const -> MappingType;
+
+  // key range of the page, all keys of the page must be in the new range
+  auto GetLowKey() const -> const KeyType &;
+  auto GetHighKey() const -> const KeyType &;
+  void SetFences(const KeyType &low_key, const KeyType &high_key);
+  // the max size of a page of this one's key size and size limit that covers the range
+  auto MaxSizeFor(const KeyType &low_key, const KeyType &high_key) const -> int;
+  // how many pairs fit into a page of slots for keys of key_size bytes with a prefix of prefix_size bytes
+  static auto Capacity(size_t key_size, size_t prefix_size) -> int;
 
   // insert and delete methods
   auto Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) -> int;
   auto Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const -> bool;
   auto RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) -> int;
+  // bulk loading appends pairs in key order
+  void Append(const KeyType &key, const ValueType &value);
 
   // Split and Merge utility methods
   void MoveHalfTo(BPlusTreeLeafPage *recipient);
@@ -64,11 +95,20 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
  private:
-  void CopyNFrom(MappingType *items, int size);
   void CopyLastFrom(const MappingType &item);
   void CopyFirstFrom(const MappingType &item);
+  auto SlotWidth() const -> size_t;
+  auto SlotAt(int index) -> char *;
+  auto SlotAt(int index) const -> const char *;
+  void SetItem(int index, const KeyType &key, const ValueType &value);
   page_id_t next_page_id_;
+  page_id_t prev_page_id_;
+  int size_limit_;
+  uint16_t key_size_;
+  uint16_t prefix_size_;
+  KeyType low_key_;
+  KeyType high_key_;
   // Flexible array member for page data.
-  MappingType array_[1];
+  char slots_[1];
 };
 }  // namespace bustub
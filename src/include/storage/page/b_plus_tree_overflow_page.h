@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_overflow_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_overflow_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+#define OVERFLOW_PAGE_HEADER_SIZE 24
+// the most bytes of a posting list an overflow page holds
+#define OVERFLOW_PAGE_CAPACITY (PAGE_SIZE - OVERFLOW_PAGE_HEADER_SIZE)
+
+/**
+ * Store a run of a posting list that is too long to share a posting page, see PostingListStore. The list is split
+ * into runs of consecutive RIDs, each encoded on its own in a page of a chain that follows the order of the RIDs. The
+ * first page of the chain also keeps the id of the last one, so that RIDs past the end of the list, as those of a
+ * growing table mostly are, go straight to the last page.
+ *
+ * Overflow page format:
+ *  --------------------
+ * | HEADER | RUN |
+ *  --------------------
+ *
+ *  Header format (size in byte, 24 in total):
+ *  -----------------------------------------------------------------------
+ * | NextPageId (4) | TailPageId (4) | Length (4) | (4) | LastRid (8) |
+ *  -----------------------------------------------------------------------
+ */
+class BPlusTreeOverflowPage {
+ public:
+  // After creating a new overflow page from buffer pool, must call initialize method to set default values
+  void Init();
+
+  auto GetNextPageId() const -> page_id_t;
+  void SetNextPageId(page_id_t next_page_id);
+  // only meaningful in the first page of a chain
+  auto GetTailPageId() const -> page_id_t;
+  void SetTailPageId(page_id_t tail_page_id);
+
+  /** @return the encoded run */
+  auto GetRun() const -> const char *;
+  auto GetLength() const -> size_t;
+  /** @return the last RID of the run, as RID::Get */
+  auto GetLastRid() const -> int64_t;
+  /** Replace the run, of at most OVERFLOW_PAGE_CAPACITY bytes, that ends with last_rid. */
+  void SetRun(const char *data, size_t length, int64_t last_rid);
+
+ private:
+  page_id_t next_page_id_;
+  page_id_t tail_page_id_;
+  uint32_t length_;
+  uint32_t padding_;
+  int64_t last_rid_;
+  // Flexible array member for page data.
+  char run_[1];
+};
+
+}  // namespace bustub
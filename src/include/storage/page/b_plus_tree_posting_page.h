@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_posting_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_posting_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * Store the posting lists of keys of a non-unique B+ tree, see PostingListStore. The lists of many keys share a page,
+ * so that a key with a few RIDs does not take up a page of its own. A list is referred to by its slot, which stays the
+ * same while the list is rewritten. The slot array grows from the header, the lists are stored from the end of the
+ * page, and the page is compacted when the space between them runs out.
+ *
+ * Posting page format:
+ *  --------------------------------------------------------------------------------
+ * | HEADER | SLOT(1) | SLOT(2) | ... | ... FREE SPACE ... | LIST(n) | ... | LIST(1) |
+ *  --------------------------------------------------------------------------------
+ *
+ *  Header format (size in byte, 8 in total):
+ *  ----------------------------------------------------------------------
+ * | SlotCount (2) | LiveCount (2) | FreeSpacePointer (2) | LiveLength (2) |
+ *  ----------------------------------------------------------------------
+ *
+ *  Slot format (size in byte, 4 in total), a free slot has length 0:
+ *  ---------------------------
+ * | Offset (2) | Length (2) |
+ *  ---------------------------
+ */
+class BPlusTreePostingPage {
+ public:
+  // After creating a new posting page from buffer pool, must call initialize method to set default values
+  void Init();
+
+  /** @return the length of the list in a slot */
+  auto GetLength(int slot) const -> size_t;
+  /** @return the list in a slot */
+  auto GetList(int slot) const -> const char *;
+  /** @return whether no slot holds a list */
+  auto IsEmpty() const -> bool;
+
+  /**
+   * Store a list in a free slot.
+   * @return the slot, -1 if the list does not fit
+   */
+  auto Insert(const char *data, size_t length) -> int;
+  /**
+   * Replace the list in a slot.
+   * @return false if the new list does not fit, the page is left unchanged then
+   */
+  auto Update(int slot, const char *data, size_t length) -> bool;
+  /** Free a slot. */
+  void Remove(int slot);
+
+ private:
+  struct Slot {
+    uint16_t offset_;
+    uint16_t length_;
+  };
+
+  /** @return the bytes between the slot array and the lists */
+  auto ContiguousFreeSpace() const -> size_t;
+  /** @return the free bytes once the page is compacted */
+  auto FreeSpace() const -> size_t;
+  /** Move the lists next to each other at the end of the page. */
+  void Compact();
+
+  uint16_t slot_count_;
+  uint16_t live_count_;
+  uint16_t free_space_pointer_;
+  uint16_t live_length_;
+  // Flexible array member for page data.
+  Slot slots_[1];
+};
+
+static_assert(PAGE_SIZE <= UINT16_MAX, "posting pages address their lists with 16 bit offsets");
+
+}  // namespace bustub
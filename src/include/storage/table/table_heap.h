@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -55,9 +57,11 @@ class TableHeap {
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
+   * @param ring the buffer ring of a bulk load, nullptr to go through the shared pool; a bulk load starts looking for
+   * room at the page the last bulk loaded tuple went to, rather than walking the whole table through its small ring
    * @return true iff the insert is successful
    */
-  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool;
+  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, BufferRing *ring = nullptr) -> bool;
 
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
@@ -99,8 +103,12 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool;
 
-  /** @return the begin iterator of this table */
-  auto Begin(Transaction *txn) -> TableIterator;
+  /**
+   * @param txn the scanning transaction
+   * @param ring the buffer ring of a large scan, nullptr to go through the shared pool
+   * @return the begin iterator of this table
+   */
+  auto Begin(Transaction *txn, BufferRing *ring = nullptr) -> TableIterator;
 
   /** @return the end iterator of this table */
   auto End() -> TableIterator;
@@ -113,6 +121,8 @@ class TableHeap {
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  /** The page the last tuple inserted through a buffer ring went to, INVALID_PAGE_ID before the first. */
+  std::atomic<page_id_t> bulk_insert_page_id_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
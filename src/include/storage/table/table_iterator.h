@@ -14,6 +14,7 @@
 
 #include <cassert>
 
+#include "buffer/read_ahead.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -29,10 +30,20 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  /**
+   * @param table_heap the table to scan
+   * @param rid the tuple to start at
+   * @param txn the scanning transaction
+   * @param ring the buffer ring the scan reads pages into, nullptr to read them into the shared pool
+   */
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferRing *ring = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        ring_(other.ring_),
+        read_ahead_(other.read_ahead_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -54,6 +65,8 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    ring_ = other.ring_;
+    read_ahead_ = other.read_ahead_;
     return *this;
   }
 
@@ -61,6 +74,9 @@ class TableIterator {
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  BufferRing *ring_;
+  /** Prefetches the pages of the next-page chain ahead of the scan. */
+  ReadAhead read_ahead_;
 };
 
 }  // namespace bustub
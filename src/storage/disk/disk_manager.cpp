@@ -10,17 +10,28 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
+#include "storage/disk/page_codec.h"
 
 namespace bustub {
 
@@ -30,13 +41,16 @@ static char *buffer_used;
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io, bool compress_pages)
+    : file_name_(db_file), compress_pages_(compress_pages) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  fsm_name_ = file_name_.substr(0, n) + ".fsm";
+  page_map_name_ = file_name_.substr(0, n) + ".pmap";
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -49,27 +63,46 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     }
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  if (direct_io && compress_pages) {
+    LOG_DEBUG("compressed pages are not aligned for O_DIRECT, using buffered I/O");
+  } else if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = db_fd_ >= 0;
+    if (db_fd_ < 0 && errno == EINVAL) {
+      LOG_DEBUG("O_DIRECT is not supported for %s, using buffered I/O", db_file.c_str());
     }
   }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  // directory or file does not exist
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  free_space_map_.Load(fsm_name_);
+  if (compress_pages_) {
+    page_map_.Load(page_map_name_);
+  }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  // outstanding asynchronous I/Os still refer to the db file
+  scheduler_.reset();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  scheduler_.reset();
+  if (db_fd_ >= 0) {
+    Sync();
+    close(db_fd_);
+    db_fd_ = -1;
   }
   log_io_.close();
 }
@@ -78,48 +111,287 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
-    return;
-  }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  WritePageImp(page_id, page_data);
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
+void DiskManager::ReadPage(page_id_t page_id, char *page_data) { ReadPageImp(page_id, page_data); }
+
+/**
+ * Submit a page write to the asynchronous backend
+ */
+auto DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<bool> {
+  num_writes_ += 1;
+  if (!IsUsableBuffer(page_data)) {
+    // O_DIRECT needs an aligned buffer, write through a bounce buffer on this thread
+    std::promise<bool> done;
+    done.set_value(WritePageImp(page_id, page_data));
+    return done.get_future();
+  }
+  auto request = std::make_unique<DiskRequest>();
+  request->is_write_ = true;
+  request->data_ = const_cast<char *>(page_data);
+  request->page_id_ = page_id;
+  auto future = request->callback_.get_future();
+  GetScheduler()->Schedule(std::move(request));
+  return future;
+}
+
+/**
+ * Submit a page read to the asynchronous backend
+ */
+auto DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<bool> {
+  if (!IsUsableBuffer(page_data)) {
+    std::promise<bool> done;
+    done.set_value(ReadPageImp(page_id, page_data));
+    return done.get_future();
+  }
+  auto request = std::make_unique<DiskRequest>();
+  request->is_write_ = false;
+  request->data_ = page_data;
+  request->page_id_ = page_id;
+  auto future = request->callback_.get_future();
+  GetScheduler()->Schedule(std::move(request));
+  return future;
+}
+
+/**
+ * Positional write, safe to call from many threads at once
+ */
+auto DiskManager::WritePageImp(page_id_t page_id, const char *page_data) -> bool {
+  if (!IsUsableBuffer(page_data)) {
+    std::unique_ptr<char, decltype(&free)> bounce(static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, PAGE_SIZE)),
+                                                 &free);
+    memcpy(bounce.get(), page_data, PAGE_SIZE);
+    return WritePageImp(page_id, bounce.get());
+  }
+  LatencyHistogram::Timer timer(&write_latency_);
+  if (compress_pages_) {
+    return WriteCompressedPage(page_id, page_data);
+  }
+  return WriteAt(page_data, PAGE_SIZE, static_cast<off_t>(page_id) * PAGE_SIZE);
+}
+
+/**
+ * Compressed pages are stored as they are if compressing them does not save at least a slot
+ */
+auto DiskManager::WriteCompressedPage(page_id_t page_id, const char *page_data) -> bool {
+  std::array<char, PAGE_SIZE> image;
+  size_t length = PageCodec::Compress(page_data, PAGE_SIZE, image.data(), PAGE_SIZE - PageMap::SLOT_SIZE);
+  const char *data = image.data();
+  if (length == 0) {
+    data = page_data;
+    length = PAGE_SIZE;
+  }
+  std::shared_lock lck(place_latch_);
+  uint64_t offset = page_map_.Place(page_id, static_cast<uint32_t>(length));
+  return WriteAt(data, length, static_cast<off_t>(offset));
+}
+
+auto DiskManager::WriteAt(const char *data, size_t size, off_t offset) -> bool {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t n = pwrite(db_fd_, data + written, size - written, offset + written);
+    // check for I/O error
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while writing");
+      return false;
+    }
+    written += n;
+  }
+  bytes_written_ += size;
+  return true;
+}
+
+/**
+ * pwritev in batches of at most IOV_MAX pages, resuming after short writes
+ */
+auto DiskManager::WritePages(page_id_t page_id, const char *const *pages, size_t num_pages) -> bool {
+  num_writes_ += static_cast<int>(num_pages);
+  std::vector<iovec> iov;
+  for (size_t first = 0; first < num_pages;) {
+    size_t batch = std::min<size_t>(num_pages - first, IOV_MAX);
+    iov.clear();
+    for (size_t i = first; i < first + batch && !compress_pages_; i++) {
+      if (!IsUsableBuffer(pages[i])) {
+        // O_DIRECT and an unaligned page, this batch ends before it
+        break;
+      }
+      iov.push_back({const_cast<char *>(pages[i]), PAGE_SIZE});  // NOLINT
+    }
+    if (iov.empty()) {
+      // compressed pages each go to the slots the page map picks for them
+      if (!WritePageImp(page_id + static_cast<page_id_t>(first), pages[first])) {
+        return false;
+      }
+      first++;
+      continue;
+    }
+    off_t offset = static_cast<off_t>(page_id + static_cast<page_id_t>(first)) * PAGE_SIZE;
+    LatencyHistogram::Timer timer(&write_latency_);
+    size_t iov_index = 0;
+    while (iov_index < iov.size()) {
+      ssize_t n = pwritev(db_fd_, iov.data() + iov_index, static_cast<int>(iov.size() - iov_index), offset);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        LOG_DEBUG("I/O error while writing");
+        return false;
+      }
+      bytes_written_ += n;
+      offset += n;
+      // skip the fully written iovecs and trim a partially written one
+      while (n > 0 && static_cast<size_t>(n) >= iov[iov_index].iov_len) {
+        n -= static_cast<ssize_t>(iov[iov_index].iov_len);
+        iov_index++;
+      }
+      if (n > 0) {
+        iov[iov_index].iov_base = static_cast<char *>(iov[iov_index].iov_base) + n;
+        iov[iov_index].iov_len -= n;
+      }
+    }
+    first += iov.size();
+  }
+  return true;
+}
+
+/**
+ * Positional read, safe to call from many threads at once
+ */
+auto DiskManager::ReadPageImp(page_id_t page_id, char *page_data) -> bool {
+  if (!IsUsableBuffer(page_data)) {
+    std::unique_ptr<char, decltype(&free)> bounce(static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, PAGE_SIZE)),
+                                                 &free);
+    bool ok = ReadPageImp(page_id, bounce.get());
+    memcpy(page_data, bounce.get(), PAGE_SIZE);
+    return ok;
+  }
+  LatencyHistogram::Timer timer(&read_latency_);
+  if (compress_pages_) {
+    return ReadCompressedPage(page_id, page_data);
+  }
+  ssize_t read_count = ReadAt(page_data, PAGE_SIZE, static_cast<off_t>(page_id) * PAGE_SIZE);
+  if (read_count < 0) {
+    return false;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+  return true;
+}
+
+auto DiskManager::ReadCompressedPage(page_id_t page_id, char *page_data) -> bool {
+  uint64_t offset;
+  uint32_t length;
+  if (!page_map_.Find(page_id, &offset, &length)) {
+    // like reading past the end of an uncompressed file
+    memset(page_data, 0, PAGE_SIZE);
+    return true;
+  }
+  if (length == PAGE_SIZE) {
+    return ReadAt(page_data, PAGE_SIZE, static_cast<off_t>(offset)) == PAGE_SIZE;
+  }
+  std::array<char, PAGE_SIZE> image;
+  if (ReadAt(image.data(), length, static_cast<off_t>(offset)) != static_cast<ssize_t>(length)) {
+    LOG_DEBUG("page %d is cut short", page_id);
+    return false;
+  }
+  if (!PageCodec::Decompress(image.data(), length, page_data, PAGE_SIZE)) {
+    LOG_DEBUG("page %d is corrupted", page_id);
+    return false;
+  }
+  return true;
+}
+
+auto DiskManager::ReadAt(char *data, size_t size, off_t offset) -> ssize_t {
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t n = pread(db_fd_, data + read_count, size - read_count, offset + read_count);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
       LOG_DEBUG("I/O error while reading");
-      return;
+      return -1;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    if (n == 0) {
+      break;
     }
+    read_count += n;
   }
+  bytes_read_ += read_count;
+  return static_cast<ssize_t>(read_count);
+}
+
+/**
+ * fdatasync the db file; with O_DIRECT the data is on the device already, but the file size and the device's write
+ * cache still need it. The free space map is saved along with it, and the page map as it was before the fdatasync
+ * once the pages it points to are durable; pages written meanwhile may have moved to runs that are not durable yet.
+ */
+auto DiskManager::Sync() -> bool {
+  std::scoped_lock sync_lck(sync_latch_);
+  if (!fsm_name_.empty() && !free_space_map_.Save(fsm_name_)) {
+    return false;
+  }
+  PageMap::Snapshot snapshot;
+  if (compress_pages_) {
+    std::scoped_lock lck(place_latch_);
+    snapshot = page_map_.TakeSnapshot();
+  }
+  LatencyHistogram::Timer timer(&sync_latency_);
+  bool synced = true;
+  while (fdatasync(db_fd_) != 0) {
+    if (errno != EINTR) {
+      LOG_DEBUG("I/O error while syncing");
+      synced = false;
+      break;
+    }
+  }
+  if (!compress_pages_) {
+    return synced;
+  }
+  if (!synced) {
+    page_map_.Discard(std::move(snapshot));
+    return false;
+  }
+  return page_map_.Save(page_map_name_, std::move(snapshot));
+}
+
+auto DiskManager::GetNumPages() -> page_id_t {
+  page_id_t num_pages = 0;
+  if (compress_pages_) {
+    num_pages = page_map_.NumPages();
+  } else {
+    struct stat stat_buf;
+    if (fstat(db_fd_, &stat_buf) == 0) {
+      // a partly written last page still counts
+      num_pages = static_cast<page_id_t>((stat_buf.st_size + PAGE_SIZE - 1) / PAGE_SIZE);
+    }
+  }
+  return std::max(num_pages, free_space_map_.End());
+}
+
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  free_space_map_.Free(page_id);
+  if (compress_pages_) {
+    page_map_.Remove(page_id);
+  }
+}
+
+auto DiskManager::GetScheduler() -> DiskScheduler * {
+  // io_uring reads and writes whole pages at their uncompressed offsets, the thread pool goes through ReadPageImp and
+  // WritePageImp
+  std::call_once(scheduler_init_, [this] { scheduler_ = DiskScheduler::Create(this, !compress_pages_); });
+  return scheduler_.get();
 }
 
 /**
@@ -194,6 +466,29 @@ auto DiskManager::GetNumFlushes() const -> int { return num_flushes_; }
  */
 auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
 
+auto DiskManager::GetStats() const -> DiskStats {
+  DiskStats stats;
+  stats.pages_written_ = num_writes_;
+  stats.bytes_read_ = bytes_read_;
+  stats.bytes_written_ = bytes_written_;
+  stats.read_latency_ = read_latency_.Snapshot();
+  stats.write_latency_ = write_latency_.Snapshot();
+  stats.sync_latency_ = sync_latency_.Snapshot();
+  return stats;
+}
+
+auto DiskStats::ToString() const -> std::string {
+  return "pages written: " + std::to_string(pages_written_) + "\nbytes read: " + std::to_string(bytes_read_) +
+         "\nbytes written: " + std::to_string(bytes_written_) + "\nread latency: " + read_latency_.ToString() +
+         "\nwrite latency: " + write_latency_.ToString() + "\nsync latency: " + sync_latency_.ToString() + "\n";
+}
+
+auto DiskStats::ToJson() const -> std::string {
+  return "{\"pages_written\": " + std::to_string(pages_written_) + ", \"bytes_read\": " + std::to_string(bytes_read_) +
+         ", \"bytes_written\": " + std::to_string(bytes_written_) + ", \"read_latency\": " + read_latency_.ToJson() +
+         ", \"write_latency\": " + write_latency_.ToJson() + ", \"sync_latency\": " + sync_latency_.ToJson() + "}";
+}
+
 /**
  * Returns true if the log is currently being flushed
  */
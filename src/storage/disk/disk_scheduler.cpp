@@ -0,0 +1,324 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.cpp
+//
+// Identification: src/storage/disk/disk_scheduler.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_scheduler.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+/**
+ * Fallback backend: a fixed pool of workers doing blocking pread/pwrite calls.
+ */
+class ThreadPoolDiskScheduler : public DiskScheduler {
+ public:
+  ThreadPoolDiskScheduler(DiskManager *disk_manager, size_t num_workers) : DiskScheduler(disk_manager) {
+    for (size_t i = 0; i < num_workers; i++) {
+      workers_.emplace_back([this] { WorkerLoop(); });
+    }
+  }
+
+  ~ThreadPoolDiskScheduler() override {
+    {
+      std::scoped_lock lck(latch_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  void Schedule(std::unique_ptr<DiskRequest> request) override {
+    {
+      std::scoped_lock lck(latch_);
+      queue_.emplace_back(std::move(request));
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  void WorkerLoop() {
+    while (true) {
+      std::unique_ptr<DiskRequest> request;
+      {
+        std::unique_lock lck(latch_);
+        cv_.wait(lck, [this] { return stop_ || !queue_.empty(); });
+        // drain the queue before stopping, so that no future is left dangling
+        if (queue_.empty()) {
+          return;
+        }
+        request = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      request->callback_.set_value(Perform(*request));
+    }
+  }
+
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<DiskRequest>> queue_;
+  bool stop_{false};
+  std::vector<std::thread> workers_;
+};
+
+/**
+ * io_uring backend, talking to the kernel through the raw system calls. Submissions are serialized by a latch since
+ * the submission ring has a single producer; a completion thread reaps the completion ring and fulfills the futures.
+ */
+class IoUringDiskScheduler : public DiskScheduler {
+ public:
+  /**
+   * Set up the rings.
+   * @return nullptr if the kernel does not support io_uring (or forbids it)
+   */
+  static auto Create(DiskManager *disk_manager, uint32_t queue_depth) -> std::unique_ptr<IoUringDiskScheduler> {
+    std::unique_ptr<IoUringDiskScheduler> scheduler(new IoUringDiskScheduler(disk_manager));
+    if (!scheduler->Setup(queue_depth)) {
+      return nullptr;
+    }
+    scheduler->completer_ = std::thread([s = scheduler.get()] { s->CompletionLoop(); });
+    return scheduler;
+  }
+
+  ~IoUringDiskScheduler() override {
+    if (completer_.joinable()) {
+      // a NOP without a request tells the completion thread to stop, after everything submitted before it
+      if (!Submit(IORING_OP_NOP, nullptr)) {
+        // the ring is broken, so the completion thread fails to wait on it as well and sees the flag
+        stopping_ = true;
+      }
+      completer_.join();
+    }
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (ring_ != nullptr) {
+      munmap(ring_, ring_size_);
+    }
+    if (ring_fd_ >= 0) {
+      close(ring_fd_);
+    }
+  }
+
+  void Schedule(std::unique_ptr<DiskRequest> request) override {
+    auto *req = new UringRequest{std::move(request), {}, std::chrono::steady_clock::now()};
+    req->iov_.iov_base = req->request_->data_;
+    req->iov_.iov_len = PAGE_SIZE;
+    if (!Submit(req->request_->is_write_ ? IORING_OP_WRITEV : IORING_OP_READV, req)) {
+      // the kernel refused the request, do it the blocking way rather than leaving its future unfulfilled
+      req->request_->callback_.set_value(Perform(*req->request_));
+      delete req;
+    }
+  }
+
+  auto IsIoUring() const -> bool override { return true; }
+
+ private:
+  struct UringRequest {
+    std::unique_ptr<DiskRequest> request_;
+    iovec iov_;
+    std::chrono::steady_clock::time_point submitted_;
+  };
+
+  explicit IoUringDiskScheduler(DiskManager *disk_manager) : DiskScheduler(disk_manager) {}
+
+  static auto Enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags) -> int {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+  }
+
+  auto Setup(uint32_t queue_depth) -> bool {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+    if (ring_fd_ < 0) {
+      return false;
+    }
+    // one mapping for both rings keeps the code simple, available since Linux 5.4
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0) {
+      return false;
+    }
+    ring_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(uint32_t),
+                          params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ring_ = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (ring_ == MAP_FAILED) {
+      ring_ = nullptr;
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes =
+        mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    auto *base = static_cast<char *>(ring_);
+    sq_tail_ = reinterpret_cast<uint32_t *>(base + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<uint32_t *>(base + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<uint32_t *>(base + params.sq_off.array);
+    cq_head_ = reinterpret_cast<uint32_t *>(base + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<uint32_t *>(base + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<uint32_t *>(base + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+    // never keep more requests in flight than the completion ring can hold
+    in_flight_limit_ = params.cq_entries;
+    return true;
+  }
+
+  /**
+   * Push one entry onto the submission ring and hand it to the kernel.
+   * @return false if the kernel refused it, in which case the entry is taken back and nothing is in flight for req
+   */
+  auto Submit(uint8_t opcode, UringRequest *req) -> bool {
+    std::unique_lock lck(sq_latch_);
+    sq_cv_.wait(lck, [this] { return in_flight_ < in_flight_limit_; });
+    in_flight_++;
+    // the kernel consumes every entry during io_uring_enter, so the ring always has room here
+    uint32_t tail = *sq_tail_;
+    uint32_t index = tail & sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->user_data = reinterpret_cast<uint64_t>(req);
+    if (req != nullptr) {
+      sqe->fd = DbFd();
+      sqe->addr = reinterpret_cast<uint64_t>(&req->iov_);
+      sqe->len = 1;
+      sqe->off = static_cast<uint64_t>(req->request_->page_id_) * PAGE_SIZE;
+    }
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    auto backoff = std::chrono::microseconds(10);
+    while (Enter(ring_fd_, 1, 0, 0) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EBUSY) {
+        // out of kernel resources or completions, give the completion thread time to reap some
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(backoff * 2, std::chrono::microseconds(1000));
+        continue;
+      }
+      LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+      // only this thread submits and a failed io_uring_enter consumes no entry, so the kernel never saw this one
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      in_flight_--;
+      lck.unlock();
+      sq_cv_.notify_one();
+      return false;
+    }
+    return true;
+  }
+
+  void CompletionLoop() {
+    while (true) {
+      uint32_t head = *cq_head_;
+      uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      if (head == tail) {
+        if (Enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+          if (stopping_) {
+            return;
+          }
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        continue;
+      }
+      io_uring_cqe cqe = cqes_[head & cq_mask_];
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      {
+        std::scoped_lock lck(sq_latch_);
+        in_flight_--;
+      }
+      sq_cv_.notify_one();
+
+      auto *req = reinterpret_cast<UringRequest *>(cqe.user_data);
+      if (req == nullptr) {
+        return;
+      }
+      Complete(req, cqe.res);
+    }
+  }
+
+  void Complete(UringRequest *req, int res) {
+    DiskRequest &request = *req->request_;
+    RecordCompletion(request, req->submitted_, res < 0 ? 0 : res);
+    bool ok = true;
+    if (res < 0) {
+      LOG_DEBUG("I/O error in io_uring request: %s", strerror(-res));
+      ok = false;
+    } else if (res < PAGE_SIZE) {
+      if (request.is_write_) {
+        // short write, finish it synchronously
+        ok = Perform(request);
+      } else {
+        // the file ends before this page
+        memset(request.data_ + res, 0, PAGE_SIZE - res);
+      }
+    }
+    request.callback_.set_value(ok);
+    delete req;
+  }
+
+  int ring_fd_{-1};
+  void *ring_{nullptr};
+  size_t ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+
+  uint32_t *sq_tail_{nullptr};
+  uint32_t *sq_array_{nullptr};
+  uint32_t sq_mask_{0};
+  uint32_t *cq_head_{nullptr};
+  uint32_t *cq_tail_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+  uint32_t cq_mask_{0};
+
+  // protects the submission ring and the in-flight count
+  std::mutex sq_latch_;
+  std::condition_variable sq_cv_;
+  uint32_t in_flight_{0};
+  uint32_t in_flight_limit_{0};
+  std::thread completer_;
+  /** Set when the stopping NOP could not be submitted. */
+  std::atomic<bool> stopping_{false};
+};
+
+auto DiskScheduler::Create(DiskManager *disk_manager, bool try_io_uring) -> std::unique_ptr<DiskScheduler> {
+  if (try_io_uring) {
+    auto uring = IoUringDiskScheduler::Create(disk_manager, DEFAULT_QUEUE_DEPTH);
+    if (uring != nullptr) {
+      return uring;
+    }
+    LOG_DEBUG("io_uring is not available, falling back to a thread pool");
+  }
+  return std::make_unique<ThreadPoolDiskScheduler>(disk_manager, DEFAULT_NUM_WORKERS);
+}
+
+}  // namespace bustub
@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/disk/free_space_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_space_map.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+void FreeSpaceMap::Free(page_id_t page_id) {
+  const auto page = static_cast<size_t>(page_id);
+  const uint64_t bit = static_cast<uint64_t>(1) << (page % EXTENT_SIZE);
+  std::scoped_lock lck(latch_);
+  if (page / EXTENT_SIZE >= extents_.size()) {
+    extents_.resize(page / EXTENT_SIZE + 1, 0);
+  }
+  auto &extent = extents_[page / EXTENT_SIZE];
+  if ((extent & bit) == 0) {
+    extent |= bit;
+    num_free_.fetch_add(1, std::memory_order_relaxed);
+    dirty_ = true;
+  }
+}
+
+auto FreeSpaceMap::Claim(page_id_t page_id) -> bool {
+  if (NumFree() == 0) {
+    return false;
+  }
+  const auto page = static_cast<size_t>(page_id);
+  const uint64_t bit = static_cast<uint64_t>(1) << (page % EXTENT_SIZE);
+  std::scoped_lock lck(latch_);
+  if (page / EXTENT_SIZE >= extents_.size() || (extents_[page / EXTENT_SIZE] & bit) == 0) {
+    return false;
+  }
+  extents_[page / EXTENT_SIZE] &= ~bit;
+  num_free_.fetch_sub(1, std::memory_order_relaxed);
+  dirty_ = true;
+  return true;
+}
+
+auto FreeSpaceMap::FindFree(page_id_t from, page_id_t end) -> page_id_t {
+  if (NumFree() == 0 || from >= end) {
+    return INVALID_PAGE_ID;
+  }
+  std::scoped_lock lck(latch_);
+  auto extent = static_cast<size_t>(from) / EXTENT_SIZE;
+  // mask off the pages of the first extent below from
+  uint64_t mask = ~static_cast<uint64_t>(0) << (static_cast<size_t>(from) % EXTENT_SIZE);
+  for (; extent < extents_.size(); extent++, mask = ~static_cast<uint64_t>(0)) {
+    uint64_t free_pages = extents_[extent] & mask;
+    if (free_pages != 0) {
+      auto page_id = static_cast<page_id_t>(extent * EXTENT_SIZE + __builtin_ctzll(free_pages));
+      return page_id < end ? page_id : INVALID_PAGE_ID;
+    }
+    if (static_cast<page_id_t>((extent + 1) * EXTENT_SIZE) >= end) {
+      break;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+auto FreeSpaceMap::IsFree(page_id_t page_id) -> bool {
+  const auto page = static_cast<size_t>(page_id);
+  std::scoped_lock lck(latch_);
+  return page / EXTENT_SIZE < extents_.size() && (extents_[page / EXTENT_SIZE] >> (page % EXTENT_SIZE) & 1) != 0;
+}
+
+auto FreeSpaceMap::End() -> page_id_t {
+  std::scoped_lock lck(latch_);
+  for (size_t extent = extents_.size(); extent > 0; extent--) {
+    if (extents_[extent - 1] != 0) {
+      return static_cast<page_id_t>((extent - 1) * EXTENT_SIZE + EXTENT_SIZE - __builtin_clzll(extents_[extent - 1]));
+    }
+  }
+  return 0;
+}
+
+auto FreeSpaceMap::Save(const std::string &file_name) -> bool {
+  std::scoped_lock lck(latch_);
+  if (!dirty_) {
+    return true;
+  }
+  if (num_free_ == 0) {
+    std::remove(file_name.c_str());
+    dirty_ = false;
+    return true;
+  }
+  // trailing extents without free pages need not be saved
+  uint64_t num_extents = extents_.size();
+  while (num_extents > 0 && extents_[num_extents - 1] == 0) {
+    num_extents--;
+  }
+  const std::string tmp_name = file_name + ".tmp";
+  std::ofstream out(tmp_name, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(&MAGIC), sizeof(MAGIC));
+  out.write(reinterpret_cast<const char *>(&num_extents), sizeof(num_extents));
+  out.write(reinterpret_cast<const char *>(extents_.data()),
+            static_cast<std::streamsize>(num_extents * sizeof(uint64_t)));
+  out.close();
+  if (out.fail() || std::rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+    LOG_DEBUG("I/O error while saving the free space map");
+    std::remove(tmp_name.c_str());
+    return false;
+  }
+  dirty_ = false;
+  return true;
+}
+
+auto FreeSpaceMap::Load(const std::string &file_name) -> bool {
+  std::ifstream in(file_name, std::ios::binary);
+  uint64_t magic = 0;
+  uint64_t num_extents = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&num_extents), sizeof(num_extents));
+  if (!in || magic != MAGIC || num_extents > static_cast<uint64_t>(INT32_MAX) / EXTENT_SIZE + 1) {
+    return false;
+  }
+  std::vector<uint64_t> extents(num_extents);
+  in.read(reinterpret_cast<char *>(extents.data()), static_cast<std::streamsize>(num_extents * sizeof(uint64_t)));
+  if (!in) {
+    LOG_DEBUG("truncated free space map %s", file_name.c_str());
+    return false;
+  }
+  size_t num_free = 0;
+  for (auto extent : extents) {
+    num_free += __builtin_popcountll(extent);
+  }
+  std::scoped_lock lck(latch_);
+  extents_ = std::move(extents);
+  num_free_ = num_free;
+  dirty_ = false;
+  return true;
+}
+
+}  // namespace bustub
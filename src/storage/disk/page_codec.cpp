@@ -0,0 +1,207 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_codec.cpp
+//
+// Identification: src/storage/disk/page_codec.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+/** Shorter matches cost more to encode than the literals they replace. */
+constexpr size_t MIN_MATCH = 4;
+/** Matches are encoded with a two byte offset. */
+constexpr size_t MAX_OFFSET = 65535;
+/** Lengths that do not fit into their nibble continue in extra bytes. */
+constexpr size_t RUN_MASK = 15;
+constexpr uint32_t HASH_BITS = 12;
+
+inline auto Load32(const char *p) -> uint32_t {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline auto Load64(const char *p) -> uint64_t {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline auto Hash(uint32_t sequence) -> uint32_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** @return the number of equal bytes at a and b, comparing a word at a time */
+inline auto MatchLength(const char *a, const char *b, const char *b_end) -> size_t {
+  const char *start = b;
+  while (b + sizeof(uint64_t) <= b_end) {
+    uint64_t diff = Load64(a) ^ Load64(b);
+    if (diff != 0) {
+      // pages are little endian, the lowest differing bit is in the first differing byte
+      return b - start + (__builtin_ctzll(diff) >> 3);
+    }
+    a += sizeof(uint64_t);
+    b += sizeof(uint64_t);
+  }
+  while (b < b_end && *a == *b) {
+    a++;
+    b++;
+  }
+  return b - start;
+}
+
+/** Append the part of a length that did not fit into its nibble. @return false if dst is full */
+auto PutExtraLength(size_t length, char *dst, size_t capacity, size_t *pos) -> bool {
+  for (; length >= 255; length -= 255) {
+    if (*pos >= capacity) {
+      return false;
+    }
+    dst[(*pos)++] = static_cast<char>(255);
+  }
+  if (*pos >= capacity) {
+    return false;
+  }
+  dst[(*pos)++] = static_cast<char>(length);
+  return true;
+}
+
+/** Read the part of a length that did not fit into its nibble. @return false if src ends first */
+auto GetExtraLength(const uint8_t *src, size_t src_size, size_t limit, size_t *pos, size_t *length) -> bool {
+  uint8_t byte;
+  do {
+    if (*pos >= src_size || *length > limit) {
+      return false;
+    }
+    byte = src[(*pos)++];
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * Append a sequence of literals followed by a match.
+ * @param match_length length of the match, 0 for the last sequence which has literals only
+ * @return false if dst is full
+ */
+auto PutSequence(const char *literals, size_t num_literals, size_t offset, size_t match_length, char *dst,
+                 size_t capacity, size_t *pos) -> bool {
+  if (*pos >= capacity) {
+    return false;
+  }
+  size_t literal_nibble = std::min(num_literals, RUN_MASK);
+  size_t match_nibble = match_length == 0 ? 0 : std::min(match_length - MIN_MATCH, RUN_MASK);
+  dst[(*pos)++] = static_cast<char>(literal_nibble << 4 | match_nibble);
+  if (literal_nibble == RUN_MASK && !PutExtraLength(num_literals - RUN_MASK, dst, capacity, pos)) {
+    return false;
+  }
+  if (num_literals > capacity - *pos) {
+    return false;
+  }
+  memcpy(dst + *pos, literals, num_literals);
+  *pos += num_literals;
+  if (match_length == 0) {
+    return true;
+  }
+  if (capacity - *pos < 2) {
+    return false;
+  }
+  dst[(*pos)++] = static_cast<char>(offset & 0xff);
+  dst[(*pos)++] = static_cast<char>(offset >> 8);
+  return match_nibble != RUN_MASK || PutExtraLength(match_length - MIN_MATCH - RUN_MASK, dst, capacity, pos);
+}
+
+}  // namespace
+
+auto PageCodec::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) -> size_t {
+  // positions of the last occurrences of hashed 4 byte sequences; a stale or colliding entry is caught by comparing
+  std::array<uint32_t, 1 << HASH_BITS> table{};
+  size_t pos = 0;
+  size_t anchor = 0;
+  size_t ip = 0;
+  while (ip + MIN_MATCH <= src_size) {
+    uint32_t sequence = Load32(src + ip);
+    uint32_t &slot = table[Hash(sequence)];
+    size_t candidate = slot;
+    slot = static_cast<uint32_t>(ip);
+    if (candidate >= ip || ip - candidate > MAX_OFFSET || Load32(src + candidate) != sequence) {
+      // skip ahead faster through data that does not compress
+      ip += 1 + ((ip - anchor) >> 6);
+      continue;
+    }
+    size_t length = MIN_MATCH + MatchLength(src + candidate + MIN_MATCH, src + ip + MIN_MATCH, src + src_size);
+    if (!PutSequence(src + anchor, ip - anchor, ip - candidate, length, dst, dst_capacity, &pos)) {
+      return 0;
+    }
+    ip += length;
+    anchor = ip;
+    if (ip + MIN_MATCH <= src_size) {
+      table[Hash(Load32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+    }
+  }
+  if (anchor < src_size && !PutSequence(src + anchor, src_size - anchor, 0, 0, dst, dst_capacity, &pos)) {
+    return 0;
+  }
+  return pos;
+}
+
+auto PageCodec::Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) -> bool {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < src_size) {
+    uint8_t token = in[ip++];
+    size_t num_literals = token >> 4;
+    if (num_literals == RUN_MASK && !GetExtraLength(in, src_size, dst_size, &ip, &num_literals)) {
+      return false;
+    }
+    if (num_literals > src_size - ip || num_literals > dst_size - op) {
+      return false;
+    }
+    memcpy(dst + op, src + ip, num_literals);
+    ip += num_literals;
+    op += num_literals;
+    if (ip == src_size) {
+      break;
+    }
+
+    if (src_size - ip < 2) {
+      return false;
+    }
+    size_t offset = in[ip] | static_cast<size_t>(in[ip + 1]) << 8;
+    ip += 2;
+    size_t match_length = token & RUN_MASK;
+    if (match_length == RUN_MASK && !GetExtraLength(in, src_size, dst_size, &ip, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > op || match_length > dst_size - op) {
+      return false;
+    }
+    char *out = dst + op;
+    const char *from = out - offset;
+    if (offset >= match_length) {
+      memcpy(out, from, match_length);
+    } else {
+      // the match overlaps its own output, e.g. a run of one repeated byte
+      for (size_t i = 0; i < match_length; i++) {
+        out[i] = from[i];
+      }
+    }
+    op += match_length;
+  }
+  return op == dst_size;
+}
+
+}  // namespace bustub
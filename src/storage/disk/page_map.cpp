@@ -0,0 +1,214 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_map.cpp
+//
+// Identification: src/storage/disk/page_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_map.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+auto PageMap::Find(page_id_t page_id, uint64_t *offset, uint32_t *length) -> bool {
+  std::scoped_lock lck(latch_);
+  if (static_cast<size_t>(page_id) >= entries_.size() || entries_[page_id].length_ == 0) {
+    return false;
+  }
+  *offset = static_cast<uint64_t>(entries_[page_id].first_slot_) * SLOT_SIZE;
+  *length = entries_[page_id].length_;
+  return true;
+}
+
+auto PageMap::Place(page_id_t page_id, uint32_t length) -> uint64_t {
+  std::scoped_lock lck(latch_);
+  if (static_cast<size_t>(page_id) >= entries_.size()) {
+    entries_.resize(page_id + 1, Entry{0, 0});
+  }
+  auto &entry = entries_[page_id];
+  const uint32_t count = SlotsFor(length);
+  const uint32_t old_count = SlotsFor(entry.length_);
+  if (entry.length_ == 0 || old_count < count) {
+    if (entry.length_ != 0) {
+      released_runs_.emplace_back(entry.first_slot_, old_count);
+    }
+    entry.first_slot_ = AllocateSlots(count);
+  } else if (old_count > count) {
+    // the image shrank, give up the tail of the run
+    released_runs_.emplace_back(entry.first_slot_ + count, old_count - count);
+  }
+  entry.length_ = length;
+  dirty_ = true;
+  return static_cast<uint64_t>(entry.first_slot_) * SLOT_SIZE;
+}
+
+void PageMap::Remove(page_id_t page_id) {
+  std::scoped_lock lck(latch_);
+  if (static_cast<size_t>(page_id) >= entries_.size() || entries_[page_id].length_ == 0) {
+    return;
+  }
+  auto &entry = entries_[page_id];
+  released_runs_.emplace_back(entry.first_slot_, SlotsFor(entry.length_));
+  entry.length_ = 0;
+  dirty_ = true;
+}
+
+auto PageMap::NumSlots() -> uint64_t {
+  std::scoped_lock lck(latch_);
+  return end_slot_;
+}
+
+auto PageMap::NumPages() -> page_id_t {
+  std::scoped_lock lck(latch_);
+  return static_cast<page_id_t>(entries_.size());
+}
+
+auto PageMap::AllocateSlots(uint32_t count) -> uint32_t {
+  for (auto it = free_runs_.begin(); it != free_runs_.end(); ++it) {
+    if (it->second >= count) {
+      auto [first_slot, run_count] = *it;
+      free_runs_.erase(it);
+      if (run_count > count) {
+        free_runs_.emplace(first_slot + count, run_count - count);
+      }
+      return first_slot;
+    }
+  }
+  uint32_t first_slot = end_slot_;
+  end_slot_ += count;
+  return first_slot;
+}
+
+void PageMap::AddFreeRun(uint32_t first_slot, uint32_t count) {
+  auto next = free_runs_.lower_bound(first_slot);
+  if (next != free_runs_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == first_slot) {
+      first_slot = prev->first;
+      count += prev->second;
+      free_runs_.erase(prev);
+    }
+  }
+  if (next != free_runs_.end() && first_slot + count == next->first) {
+    count += next->second;
+    free_runs_.erase(next);
+  }
+  free_runs_.emplace(first_slot, count);
+}
+
+auto PageMap::TakeSnapshot() -> Snapshot {
+  std::scoped_lock lck(latch_);
+  Snapshot snapshot;
+  if (!dirty_) {
+    return snapshot;
+  }
+  // unmapped entries at the end need not be saved
+  size_t num_entries = entries_.size();
+  while (num_entries > 0 && entries_[num_entries - 1].length_ == 0) {
+    num_entries--;
+  }
+  snapshot.dirty_ = true;
+  snapshot.entries_.assign(entries_.begin(), entries_.begin() + num_entries);
+  snapshot.released_runs_.swap(released_runs_);
+  dirty_ = false;
+  return snapshot;
+}
+
+auto PageMap::Save(const std::string &file_name, Snapshot snapshot) -> bool {
+  if (!snapshot.dirty_) {
+    return true;
+  }
+  const std::string tmp_name = file_name + ".tmp";
+  std::ofstream out(tmp_name, std::ios::binary | std::ios::trunc);
+  uint64_t num_entries = snapshot.entries_.size();
+  out.write(reinterpret_cast<const char *>(&MAGIC), sizeof(MAGIC));
+  out.write(reinterpret_cast<const char *>(&num_entries), sizeof(num_entries));
+  out.write(reinterpret_cast<const char *>(snapshot.entries_.data()),
+            static_cast<std::streamsize>(num_entries * sizeof(Entry)));
+  out.close();
+  if (out.fail() || std::rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+    LOG_DEBUG("I/O error while saving the page map");
+    std::remove(tmp_name.c_str());
+    Discard(std::move(snapshot));
+    return false;
+  }
+  std::scoped_lock lck(latch_);
+  // nothing on disk refers to the runs left before the snapshot anymore
+  for (auto [first_slot, count] : snapshot.released_runs_) {
+    AddFreeRun(first_slot, count);
+  }
+  return true;
+}
+
+void PageMap::Discard(Snapshot snapshot) {
+  if (!snapshot.dirty_) {
+    return;
+  }
+  std::scoped_lock lck(latch_);
+  // the saved map may still point at the runs, a later snapshot takes them along
+  released_runs_.insert(released_runs_.end(), snapshot.released_runs_.begin(), snapshot.released_runs_.end());
+  dirty_ = true;
+}
+
+auto PageMap::Load(const std::string &file_name) -> bool {
+  std::ifstream in(file_name, std::ios::binary);
+  uint64_t magic = 0;
+  uint64_t num_entries = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&num_entries), sizeof(num_entries));
+  if (!in || magic != MAGIC || num_entries > static_cast<uint64_t>(INT32_MAX)) {
+    return false;
+  }
+  std::vector<Entry> entries(num_entries);
+  in.read(reinterpret_cast<char *>(entries.data()), static_cast<std::streamsize>(num_entries * sizeof(Entry)));
+  if (!in) {
+    LOG_DEBUG("truncated page map %s", file_name.c_str());
+    return false;
+  }
+
+  // the gaps between the runs in use are free
+  std::vector<std::pair<uint32_t, uint32_t>> runs;
+  for (const auto &entry : entries) {
+    if (entry.length_ > static_cast<uint32_t>(PAGE_SIZE)) {
+      LOG_DEBUG("malformed page map %s", file_name.c_str());
+      return false;
+    }
+    if (entry.length_ != 0) {
+      runs.emplace_back(entry.first_slot_, SlotsFor(entry.length_));
+    }
+  }
+  std::sort(runs.begin(), runs.end());
+  std::map<uint32_t, uint32_t> free_runs;
+  uint32_t end_slot = 0;
+  for (auto [first_slot, count] : runs) {
+    if (first_slot < end_slot) {
+      LOG_DEBUG("overlapping pages in page map %s", file_name.c_str());
+      return false;
+    }
+    if (first_slot > end_slot) {
+      free_runs.emplace(end_slot, first_slot - end_slot);
+    }
+    end_slot = first_slot + count;
+  }
+
+  std::scoped_lock lck(latch_);
+  entries_ = std::move(entries);
+  free_runs_ = std::move(free_runs);
+  released_runs_.clear();
+  end_slot_ = end_slot;
+  dirty_ = false;
+  return true;
+}
+
+}  // namespace bustub
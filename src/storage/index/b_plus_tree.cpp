@@ -9,7 +9,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
 #include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -20,19 +26,22 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, bool unique)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
+      key_size_(comparator.CompareSize()),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      internal_max_size_(internal_max_size),
+      unique_(unique),
+      postings_(buffer_pool_manager) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
+auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return root_page_id_ == INVALID_PAGE_ID; }
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -43,7 +52,34 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-  return false;
+  // the lookup reads a copy of the leaf, so it takes no latch at all
+  alignas(MappingType) char snapshot[PAGE_SIZE];
+  Page *page = FindLeafOptimistic(key, snapshot);
+  if (page == nullptr) {
+    return false;
+  }
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  ValueType value;
+  bool found = reinterpret_cast<LeafPage *>(snapshot)->Lookup(key, &value, comparator_);
+  if (!found || unique_ || !PostingListStore::IsPostingList(value)) {
+    if (found) {
+      result->push_back(value);
+    }
+    return found;
+  }
+
+  // the posting list of the key may change once the leaf does, so it is read under the leaf latch
+  page = LatchLeaf(key, false);
+  if (page == nullptr) {
+    return false;
+  }
+  found = reinterpret_cast<LeafPage *>(page->GetData())->Lookup(key, &value, comparator_);
+  if (found) {
+    PostingListStore::Read(buffer_pool_manager_, value, result);
+  }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return found;
 }
 
 /*****************************************************************************
@@ -53,12 +89,38 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * A non-unique tree adds the value to the posting list of a key it has already.
+ * @return: false if the tree is unique and has the key, or if the key has the
+ * value already, otherwise true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  return false;
+  // most inserts leave the leaf with room to spare and need nothing but the leaf write latched
+  Page *page = LatchLeaf(key, true);
+  if (page != nullptr) {
+    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    ValueType existing;
+    bool duplicate = leaf->Lookup(key, &existing, comparator_);
+    if (duplicate && !unique_) {
+      bool added = postings_.Add(&existing, value);
+      leaf->SetValueAt(leaf->KeyIndex(key, comparator_), existing);
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), added);
+      return added;
+    }
+    bool safe = IsSafe(leaf, BPlusTreeOperation::INSERT);
+    if (!duplicate && safe) {
+      leaf->Insert(key, value, comparator_);
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), !duplicate && safe);
+    if (duplicate || safe) {
+      return !duplicate;
+    }
+  }
+
+  Transaction scratch(INVALID_TXN_ID);
+  return InsertIntoLeaf(key, value, transaction != nullptr ? transaction : &scratch);
 }
 /*
  * Insert constant key & value pair into an empty tree
@@ -67,19 +129,58 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * tree's root page id and insert entry directly into leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate the root page of a B+ tree");
+  }
+  auto *root = reinterpret_cast<LeafPage *>(page->GetData());
+  root->Init(page_id, INVALID_PAGE_ID, leaf_max_size_, key_size_);
+  root->Insert(key, value, comparator_);
+  root_page_id_ = page_id;
+  UpdateRootPageId(1);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
 
 /*
  * Insert constant key & value pair into leaf page
  * User needs to first find the right leaf page as insertion target, then look
  * through leaf page to see whether insert key exist or not. If exist, return
  * immdiately, otherwise insert entry. Remember to deal with split if necessary.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * The leaf is found with write latches held on every page the split may reach.
+ * @return: false if the tree is unique and has the key, or if the key has the
+ * value already, otherwise true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  return false;
+  Page *page = FindLeafPessimistic(key, BPlusTreeOperation::INSERT, transaction);
+  if (page == nullptr) {
+    StartNewTree(key, value);
+    ReleaseLatches(transaction, false);
+    return true;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType existing;
+  if (leaf->Lookup(key, &existing, comparator_)) {
+    bool added = !unique_ && postings_.Add(&existing, value);
+    if (added) {
+      leaf->SetValueAt(leaf->KeyIndex(key, comparator_), existing);
+    }
+    ReleaseLatches(transaction, added);
+    return added;
+  }
+  leaf->Insert(key, value, comparator_);
+  LeafLink link;
+  if (leaf->GetSize() >= leaf->GetMaxSize()) {
+    LeafPage *sibling = Split(leaf);
+    link = PendLinkBack(sibling);
+    InsertIntoParent(leaf, sibling->KeyAt(0), sibling, transaction);
+    buffer_pool_manager_->UnpinPage(sibling->GetPageId(), true);
+  }
+  ReleaseLatches(transaction, true);
+  LinkBack(link);
+  return true;
 }
 
 /*
@@ -88,11 +189,27 @@ auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
+ * The new page is returned pinned. It is not latched since no other thread can reach it before the write latched
+ * parent of the input page points to it. The prev link of the leaf after a new leaf is left to the caller, see
+ * PendLinkBack.
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 auto BPLUSTREE_TYPE::Split(N *node) -> N * {
-  return nullptr;
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a page to split a B+ tree page into");
+  }
+  auto *sibling = reinterpret_cast<N *>(page->GetData());
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    sibling->Init(page_id, node->GetParentPageId(), leaf_max_size_, key_size_);
+    node->MoveHalfTo(sibling);
+  } else {
+    sibling->Init(page_id, node->GetParentPageId(), internal_max_size_, key_size_);
+    node->MoveHalfTo(sibling, buffer_pool_manager_);
+  }
+  return sibling;
 }
 
 /*
@@ -103,10 +220,38 @@ auto BPLUSTREE_TYPE::Split(N *node) -> N * {
  * User needs to first find the parent page of old_node, parent node must be
  * adjusted to take info of new_node into account. Remember to deal with split
  * recursively if necessary.
+ * The parent is write latched in the page set already, since old_node was not safe.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      Transaction *transaction) {
+  if (old_node->IsRootPage()) {
+    page_id_t root_page_id;
+    Page *page = buffer_pool_manager_->NewPage(&root_page_id);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a new root page for a B+ tree");
+    }
+    auto *root = reinterpret_cast<InternalPage *>(page->GetData());
+    root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_, key_size_);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId();
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
+    return;
+  }
+
+  Page *page = FetchTreePage(old_node->GetParentPageId());
+  auto *parent = reinterpret_cast<InternalPage *>(page->GetData());
+  parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  if (parent->GetSize() > parent->GetMaxSize()) {
+    InternalPage *sibling = Split(parent);
+    InsertIntoParent(parent, sibling->KeyAt(0), sibling, transaction);
+    buffer_pool_manager_->UnpinPage(sibling->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -117,21 +262,134 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  * If not, User needs to first find the right leaf page as deletion target, then
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
+ * In a non-unique tree this removes the key with all its values.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) { RemoveValue(key, nullptr, transaction); }
+
+/*
+ * Delete a key & value pair, leaving the key with its other values in a
+ * non-unique tree. Nothing is deleted if the key does not have the value.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  RemoveValue(key, &value, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveValue(const KeyType &key, const ValueType *value, Transaction *transaction) {
+  // most removes leave the leaf at least half full, or only shrink a posting list, and need nothing but the leaf
+  // write latched
+  Page *page = LatchLeaf(key, true);
+  if (page == nullptr) {
+    return;
+  }
+  bool dirty = false;
+  bool done = RemoveFromLeaf(reinterpret_cast<LeafPage *>(page->GetData()), key, value, true, &dirty);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+  if (done) {
+    return;
+  }
+
+  Transaction scratch(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &scratch;
+  }
+  page = FindLeafPessimistic(key, BPlusTreeOperation::DELETE, transaction);
+  if (page == nullptr) {
+    ReleaseLatches(transaction, false);
+    return;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int size = leaf->GetSize();
+  dirty = false;
+  RemoveFromLeaf(leaf, key, value, false, &dirty);
+  if (leaf->GetSize() == size) {
+    ReleaseLatches(transaction, dirty);
+    return;
+  }
+  LeafLink link;
+  CoalesceOrRedistribute(leaf, transaction, &link);
+  ReleaseLatches(transaction, true);
+  // a merged page is only deleted once the leaf after it links back past it
+  LinkBack(link);
+  DeletePages(transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RemoveFromLeaf(LeafPage *leaf, const KeyType &key, const ValueType *value, bool safe_only,
+                                    bool *dirty) -> bool {
+  ValueType existing;
+  if (!leaf->Lookup(key, &existing, comparator_)) {
+    return true;
+  }
+  bool posting_list = !unique_ && PostingListStore::IsPostingList(existing);
+  if (posting_list && value != nullptr) {
+    *dirty = postings_.Remove(&existing, *value);
+    leaf->SetValueAt(leaf->KeyIndex(key, comparator_), existing);
+    return true;
+  }
+  if (value != nullptr && !(existing == *value)) {
+    return true;
+  }
+  if (safe_only && !IsSafe(leaf, BPlusTreeOperation::DELETE)) {
+    return false;
+  }
+  leaf->RemoveAndDeleteRecord(key, comparator_);
+  if (posting_list) {
+    postings_.Free(existing);
+  }
+  *dirty = true;
+  return true;
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
  * Using template N to represent either internal page or leaf page.
+ * The node and its parent are write latched in the page set; the sibling is latched here, which cannot deadlock since
+ * any other thread that gets to the sibling has to go through the parent.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -> bool {
-  return false;
+auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction, LeafLink *link) -> bool {
+  if (node->IsRootPage()) {
+    if (!AdjustRoot(node)) {
+      return false;
+    }
+    transaction->AddIntoDeletedPageSet(node->GetPageId());
+    return true;
+  }
+  if (node->GetSize() >= node->GetMinSize()) {
+    return false;
+  }
+
+  Page *parent_page = FetchTreePage(node->GetParentPageId());
+  auto *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  int index = parent->ValueIndex(node->GetPageId());
+  Page *sibling_page = FetchTreePage(parent->ValueAt(index == 0 ? 1 : index - 1));
+  sibling_page->WLatch();
+  auto *sibling = reinterpret_cast<N *>(sibling_page->GetData());
+
+  // the merged page covers the ranges of both; a leaf is full at max size already, an internal page only above it
+  N *left = index == 0 ? node : sibling;
+  N *right = index == 0 ? sibling : node;
+  int capacity = left->MaxSizeFor(left->GetLowKey(), right->GetHighKey()) - (node->IsLeafPage() ? 1 : 0);
+  bool node_deleted = false;
+  if (sibling->GetSize() + node->GetSize() <= capacity) {
+    // the right one of the pair is merged into the left one
+    node_deleted = index != 0;
+    Coalesce(&sibling, &node, &parent, index, transaction, link);
+  } else {
+    Redistribute(sibling, node, parent, index);
+  }
+  sibling_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
+  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
+  return node_deleted;
 }
 
 /*
@@ -140,6 +398,8 @@ auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -
  * take info of deletion into account. Remember to deal with coalesce or
  * redistribute recursively if necessary.
  * Using template N to represent either internal page or leaf page.
+ * The page is only deleted once all latches are released, through the deleted page set of the transaction. The
+ * prev link of the leaf after merged leaves is set through link once the latches are released, see PendLinkBack.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
  * @param   parent             parent page of input "node"
@@ -150,8 +410,21 @@ INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 auto BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
                               BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent, int index,
-                              Transaction *transaction) -> bool {
-  return false;
+                              Transaction *transaction, LeafLink *link) -> bool {
+  if (index == 0) {
+    // the node is the leftmost child, merge its right sibling into it instead
+    std::swap(*neighbor_node, *node);
+    index = 1;
+  }
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    (*node)->MoveAllTo(*neighbor_node);
+    *link = PendLinkBack(*neighbor_node);
+  } else {
+    (*node)->MoveAllTo(*neighbor_node, (*parent)->KeyAt(index), buffer_pool_manager_);
+  }
+  transaction->AddIntoDeletedPageSet((*node)->GetPageId());
+  (*parent)->Remove(index);
+  return CoalesceOrRedistribute(*parent, transaction, link);
 }
 
 /*
@@ -162,10 +435,28 @@ auto BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
+ * @param   parent             parent page of both
+ * @param   index              index of "node" in its parent
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index) {
+  if (index == 0) {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveFirstToEndOf(node);
+    } else {
+      neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(1), buffer_pool_manager_);
+    }
+    parent->SetKeyAt(1, neighbor_node->KeyAt(0));
+    return;
+  }
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    neighbor_node->MoveLastToFrontOf(node);
+  } else {
+    neighbor_node->MoveLastToFrontOf(node, parent->KeyAt(index), buffer_pool_manager_);
+  }
+  parent->SetKeyAt(index, node->KeyAt(0));
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -177,7 +468,26 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool { return false; }
+auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool {
+  if (old_root_node->IsLeafPage()) {
+    if (old_root_node->GetSize() > 0) {
+      return false;
+    }
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId();
+    return true;
+  }
+  if (old_root_node->GetSize() > 1) {
+    return false;
+  }
+  page_id_t child_page_id = reinterpret_cast<InternalPage *>(old_root_node)->RemoveAndReturnOnlyChild();
+  Page *page = FetchTreePage(child_page_id);
+  reinterpret_cast<BPlusTreePage *>(page->GetData())->SetParentPageId(INVALID_PAGE_ID);
+  buffer_pool_manager_->UnpinPage(child_page_id, true);
+  root_page_id_ = child_page_id;
+  UpdateRootPageId();
+  return true;
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -188,7 +498,14 @@ auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool { return f
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
+  // no key orders before the all zero one
+  Page *page = LatchLeaf(KeyType{}, false);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, 0, false, unique_);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -196,7 +513,47 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE()
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  Page *page = LatchLeaf(key, false);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, leaf->KeyIndex(key, comparator_), false, unique_);
+}
+
+/*
+ * Input parameter is void, find the rightmost leaf page first, then construct
+ * a reverse index iterator from its last pair
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin() -> INDEXITERATOR_TYPE {
+  // no key orders after the all one key
+  KeyType key;
+  memset(&key, 0xFF, sizeof(KeyType));
+  return RBegin(key);
+}
+
+/*
+ * Input parameter is high key, find the leaf page that covers it first, then
+ * construct a reverse index iterator from the last pair whose key is not
+ * greater
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  Page *page = LatchLeaf(key, false);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int index = leaf->KeyIndex(key, comparator_);
+  if (index == leaf->GetSize() || comparator_(leaf->KeyAt(index), key) > 0) {
+    index--;
+  }
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, index, true, unique_);
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -215,7 +572,263 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE();
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) -> Page * {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+  Page *page = LatchLeaf(leftMost ? KeyType{} : key, false);
+  if (page != nullptr) {
+    page->RUnlatch();
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, char *snapshot) -> Page * {
+  alignas(MappingType) char internal_snapshot[PAGE_SIZE];
+  while (true) {
+    page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      return nullptr;
+    }
+    // a pinned page is not deleted, so the root is still a page of the tree if it is still the root once pinned
+    Page *page = FetchTreePage(root_page_id);
+    if (root_page_id_ != root_page_id) {
+      buffer_pool_manager_->UnpinPage(root_page_id, false);
+      continue;
+    }
+    while (true) {
+      // the type of a page of the tree does not change while it is pinned
+      bool is_leaf = reinterpret_cast<BPlusTreePage *>(page->GetData())->IsLeafPage();
+      if (is_leaf && snapshot == nullptr) {
+        return page;
+      }
+      char *copy = is_leaf ? snapshot : internal_snapshot;
+      uint64_t version = ReadSnapshot(page, copy);
+      auto *node = reinterpret_cast<BPlusTreePage *>(copy);
+      page_id_t next_page_id;
+      if (!CheckRange(key, node, &next_page_id)) {
+        buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+        break;
+      }
+      if (next_page_id == INVALID_PAGE_ID) {
+        if (is_leaf) {
+          return page;
+        }
+        next_page_id = reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_);
+      }
+      // the next page is a page of the tree if the page pointing to it is unchanged once it is pinned, since a page is
+      // unlinked under its write latch before it is deleted
+      Page *next_page = FetchTreePage(next_page_id);
+      if (page->GetVersion() != version) {
+        buffer_pool_manager_->UnpinPage(next_page_id, false);
+        continue;
+      }
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      page = next_page;
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::LatchLeaf(const KeyType &key, bool exclusive) -> Page * {
+  while (true) {
+    Page *page = FindLeafOptimistic(key, nullptr);
+    if (page == nullptr) {
+      return nullptr;
+    }
+    while (page != nullptr) {
+      exclusive ? page->WLatch() : page->RLatch();
+      page_id_t next_page_id;
+      bool in_range = CheckRange(key, reinterpret_cast<BPlusTreePage *>(page->GetData()), &next_page_id);
+      if (in_range && next_page_id == INVALID_PAGE_ID) {
+        return page;
+      }
+      // the sibling is pinned while the leaf linking to it is latched, and latched once the leaf is released
+      Page *next_page = in_range ? FetchTreePage(next_page_id) : nullptr;
+      exclusive ? page->WUnlatch() : page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      page = next_page;
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::CheckRange(const KeyType &key, BPlusTreePage *node, page_id_t *next_page_id) const -> bool {
+  *next_page_id = INVALID_PAGE_ID;
+  // only a page that was merged into its left sibling or an old root is empty
+  if (node->GetSize() == 0) {
+    return false;
+  }
+  if (node->IsLeafPage()) {
+    auto *leaf = reinterpret_cast<LeafPage *>(node);
+    if (comparator_(key, leaf->GetLowKey()) < 0) {
+      return false;
+    }
+    if (comparator_(key, leaf->GetHighKey()) >= 0) {
+      *next_page_id = leaf->GetNextPageId();
+    }
+    return true;
+  }
+  auto *internal = reinterpret_cast<InternalPage *>(node);
+  if (comparator_(key, internal->GetLowKey()) < 0) {
+    return false;
+  }
+  if (comparator_(key, internal->GetHighKey()) >= 0) {
+    *next_page_id = internal->GetNextPageId();
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::ReadSnapshot(Page *page, char *snapshot) -> uint64_t {
+  while (true) {
+    uint64_t version = page->GetVersion();
+    if (version % 2 == 0) {
+      memcpy(snapshot, page->GetData(), PAGE_SIZE);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (page->GetVersion() == version) {
+        return version;
+      }
+    }
+    std::this_thread::yield();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPessimistic(const KeyType &key, BPlusTreeOperation op, Transaction *transaction)
+    -> Page * {
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  page_id_t page_id = root_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = FetchTreePage(page_id);
+    page->WLatch();
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op)) {
+      ReleaseLatches(transaction, false);
+    }
+    transaction->AddIntoPageSet(page);
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    page_id = reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_);
+  }
+  return nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, BPlusTreeOperation op) const -> bool {
+  switch (op) {
+    case BPlusTreeOperation::SEARCH:
+      return true;
+    case BPlusTreeOperation::INSERT:
+      // a leaf splits once it is full, an internal page once it overflows
+      return node->IsLeafPage() ? node->GetSize() + 1 < node->GetMaxSize() : node->GetSize() < node->GetMaxSize();
+    case BPlusTreeOperation::DELETE:
+      if (node->IsRootPage()) {
+        // the root goes away once the tree is empty or it has a single child left
+        return node->GetSize() > (node->IsLeafPage() ? 1 : 2);
+      }
+      return node->GetSize() > node->GetMinSize();
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseLatches(Transaction *transaction, bool is_dirty) {
+  auto page_set = transaction->GetPageSet();
+  for (Page *page : *page_set) {
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+      continue;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+  page_set->clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePages(Transaction *transaction) {
+  auto deleted_page_set = transaction->GetDeletedPageSet();
+  if (deleted_page_set->empty()) {
+    return;
+  }
+  std::scoped_lock lck(deferred_latch_);
+  // the pins that kept earlier pages from being deleted are likely gone by now
+  std::vector<page_id_t> pending;
+  pending.swap(deferred_deletes_);
+  pending.insert(pending.end(), deleted_page_set->begin(), deleted_page_set->end());
+  deleted_page_set->clear();
+  for (page_id_t page_id : pending) {
+    // a page still pinned by an iterator is unreachable anyway, but its id must go back to the free space map
+    if (!buffer_pool_manager_->DeletePage(page_id)) {
+      deferred_deletes_.push_back(page_id);
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::PendLinkBack(LeafPage *prev_leaf) -> LeafLink {
+  LeafLink link;
+  if (prev_leaf->GetNextPageId() != INVALID_PAGE_ID) {
+    link.page_ = FetchTreePage(prev_leaf->GetNextPageId());
+    link.prev_page_ = FetchTreePage(prev_leaf->GetPageId());
+  }
+  return link;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::LinkBack(const LeafLink &link) {
+  Page *page = link.page_;
+  if (page == nullptr) {
+    return;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  Page *prev_page = link.prev_page_;
+  bool dirty = false;
+  while (true) {
+    page->WLatch();
+    // a writer of the neighbour may be waiting for this leaf, so the neighbour is read like ReadSnapshot does, but
+    // without waiting for the writer while the leaf is latched
+    uint64_t version = prev_page->GetVersion();
+    auto *prev_leaf = reinterpret_cast<LeafPage *>(prev_page->GetData());
+    bool prev_merged = prev_leaf->GetSize() == 0;
+    page_id_t next_page_id = prev_leaf->GetNextPageId();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    bool stable = version % 2 == 0 && prev_page->GetVersion() == version;
+    bool merged = leaf->GetSize() == 0;
+    bool linked = next_page_id == page->GetPageId();
+    if (stable && !merged && !prev_merged && linked) {
+      leaf->SetPrevPageId(prev_page->GetPageId());
+      dirty = true;
+    }
+    page->WUnlatch();
+    if (!stable) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (merged || prev_merged || linked || next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    // the neighbour split since, the leaf is linked to the page the split put after it, which cannot be merged away
+    // before it is pinned while the neighbour is unchanged
+    Page *next_page = FetchTreePage(next_page_id);
+    if (prev_page->GetVersion() != version) {
+      buffer_pool_manager_->UnpinPage(next_page_id, false);
+      continue;
+    }
+    buffer_pool_manager_->UnpinPage(prev_page->GetPageId(), false);
+    prev_page = next_page;
+  }
+  buffer_pool_manager_->UnpinPage(prev_page->GetPageId(), false);
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchTreePage(page_id_t page_id) -> Page * {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a B+ tree page");
+  }
+  return page;
 }
 
 /*
@@ -228,14 +841,15 @@ auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) -> Page * {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
+  auto *header_page = static_cast<HeaderPage *>(FetchTreePage(HEADER_PAGE_ID));
+  // the header page is shared by all indexes
+  header_page->WLatch();
+  // create a new record<index_name + root_page_id> in header_page, a tree that was emptied before has one already
+  if (insert_record == 0 || !header_page->InsertRecord(index_name_, root_page_id_)) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
+  header_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
@@ -272,6 +886,148 @@ void BPLUSTREE_TYPE::RemoveFromFile(const std::string &file_name, Transaction *t
   }
 }
 
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(const std::function<bool(MappingType *)> &next, size_t num_pairs, double fill_factor)
+    -> size_t {
+  root_latch_.WLock();
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    root_latch_.WUnlock();
+    throw Exception("cannot bulk load a B+ tree that is not empty");
+  }
+
+  // Plan every level bottom up, spreading its entries evenly over its pages. A leaf holds one pair less than its max
+  // size. Fewer pages are better than pages below min size. The plan does not count on key compression, the pages
+  // that end up with a prefix just have room to spare.
+  std::vector<LoadLevel> levels;
+  int leaf_max_size = std::min(leaf_max_size_, LeafPage::Capacity(key_size_, 0));
+  int internal_max_size = std::min(internal_max_size_, InternalPage::Capacity(key_size_, 0) - 1);
+  for (size_t num_entries = num_pairs; num_entries > 0;) {
+    bool leaf = levels.empty();
+    int capacity = leaf ? leaf_max_size - 1 : internal_max_size;
+    int min_size = std::max(leaf ? leaf_max_size / 2 : (internal_max_size + 1) / 2, 1);
+    auto target = static_cast<size_t>(std::clamp(static_cast<int>(std::lround(fill_factor * capacity)), min_size,
+                                                 std::max(capacity, min_size)));
+    size_t num_nodes = (num_entries + target - 1) / target;
+    while (num_nodes > 1 && num_entries / num_nodes < static_cast<size_t>(min_size)) {
+      num_nodes--;
+    }
+    levels.push_back(LoadLevel{num_entries, num_nodes});
+    num_entries = num_nodes > 1 ? num_nodes : 0;
+  }
+
+  // a non-unique tree collects the values of a key until the next key comes, then stores them as its posting list
+  MappingType pair;
+  size_t num_loaded = 0;
+  size_t num_extra = 0;
+  LeafPage *last_leaf = nullptr;
+  std::vector<ValueType> values;
+  auto store_values = [&]() {
+    if (values.size() > 1) {
+      last_leaf->SetValueAt(last_leaf->GetSize() - 1, postings_.Create(&values));
+      num_extra += values.size() - 1;
+    }
+    values.clear();
+  };
+  while (num_loaded < num_pairs && next(&pair)) {
+    if (last_leaf != nullptr && comparator_(last_leaf->KeyAt(last_leaf->GetSize() - 1), pair.first) == 0) {
+      if (!unique_) {
+        values.push_back(pair.second);
+      }
+      continue;
+    }
+    if (last_leaf != nullptr) {
+      store_values();
+    }
+    last_leaf = reinterpret_cast<LeafPage *>(LoadNodeFor(&levels, 0, pair.first)->GetData());
+    last_leaf->Append(pair.first, pair.second);
+    values.push_back(pair.second);
+    num_loaded++;
+  }
+  if (last_leaf != nullptr) {
+    store_values();
+  }
+  if (num_loaded == 0) {
+    root_latch_.WUnlock();
+    return 0;
+  }
+  for (auto &level : levels) {
+    buffer_pool_manager_->UnpinPage(level.page_->GetPageId(), true);
+  }
+
+  // with fewer pairs than planned, the root may have a single child
+  page_id_t root_page_id = levels.back().page_->GetPageId();
+  while (true) {
+    Page *page = FetchTreePage(root_page_id);
+    auto *root = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (root->IsLeafPage() || root->GetSize() > 1) {
+      buffer_pool_manager_->UnpinPage(root_page_id, false);
+      break;
+    }
+    AdjustRoot(root);
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
+    buffer_pool_manager_->DeletePage(root_page_id);
+    root_page_id = root_page_id_;
+  }
+  root_page_id_ = root_page_id;
+  UpdateRootPageId(1);
+  root_latch_.WUnlock();
+  return num_loaded + num_extra;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::LoadNodeFor(std::vector<LoadLevel> *levels, size_t level, const KeyType &first_key) -> Page * {
+  LoadLevel &load = (*levels)[level];
+  Page *page = load.page_;
+  if (page != nullptr && static_cast<size_t>(reinterpret_cast<BPlusTreePage *>(page->GetData())->GetSize()) <
+                             load.target_) {
+    return page;
+  }
+
+  page_id_t page_id;
+  Page *new_page = buffer_pool_manager_->NewPage(&page_id);
+  if (new_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a page to bulk load a B+ tree into");
+  }
+  page_id_t parent_page_id = INVALID_PAGE_ID;
+  if (level + 1 < levels->size()) {
+    Page *parent_page = LoadNodeFor(levels, level + 1, first_key);
+    reinterpret_cast<InternalPage *>(parent_page->GetData())->Append(first_key, page_id);
+    parent_page_id = parent_page->GetPageId();
+  }
+  // the first key splits the range of the new page off the one before
+  if (level == 0) {
+    auto *leaf = reinterpret_cast<LeafPage *>(new_page->GetData());
+    leaf->Init(page_id, parent_page_id, leaf_max_size_, key_size_);
+    if (page != nullptr) {
+      auto *last_leaf = reinterpret_cast<LeafPage *>(page->GetData());
+      last_leaf->SetNextPageId(page_id);
+      leaf->SetPrevPageId(page->GetPageId());
+      last_leaf->SetFences(last_leaf->GetLowKey(), first_key);
+      leaf->SetFences(first_key, leaf->GetHighKey());
+    }
+  } else {
+    auto *internal = reinterpret_cast<InternalPage *>(new_page->GetData());
+    internal->Init(page_id, parent_page_id, internal_max_size_, key_size_);
+    if (page != nullptr) {
+      auto *last_internal = reinterpret_cast<InternalPage *>(page->GetData());
+      last_internal->SetNextPageId(page_id);
+      last_internal->SetFences(last_internal->GetLowKey(), first_key);
+      internal->SetFences(first_key, internal->GetHighKey());
+    }
+  }
+  if (page != nullptr) {
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  }
+
+  load.page_ = new_page;
+  load.target_ = load.num_entries_ / load.num_nodes_ + (load.node_ < load.num_entries_ % load.num_nodes_ ? 1 : 0);
+  load.node_++;
+  return new_page;
+}
+
 /**
  * This method is used for debug only, You don't need to modify
  */
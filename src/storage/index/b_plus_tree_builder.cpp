@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_builder.cpp
+//
+// Identification: src/storage/index/b_plus_tree_builder.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/b_plus_tree_builder.h"
+
+#include <algorithm>
+#include <queue>
+
+#include "common/exception.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_BUILDER_TYPE::BPlusTreeBuilder(BPlusTree<KeyType, ValueType, KeyComparator> *tree,
+                                         const KeyComparator &comparator, double fill_factor, size_t run_size)
+    : tree_(tree), comparator_(comparator), fill_factor_(fill_factor), run_size_(std::max<size_t>(run_size, 1)) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_BUILDER_TYPE::~BPlusTreeBuilder() {
+  for (auto &run : runs_) {
+    std::fclose(run.file_);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_BUILDER_TYPE::Add(const KeyType &key, const ValueType &value) {
+  buffer_.emplace_back(key, value);
+  if (buffer_.size() >= run_size_) {
+    SpillRun();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_BUILDER_TYPE::Finish() -> size_t {
+  if (!runs_.empty()) {
+    if (!buffer_.empty()) {
+      SpillRun();
+    }
+    return MergeRuns();
+  }
+  SortBuffer();
+  size_t pos = 0;
+  size_t num_loaded = tree_->BulkLoad(
+      [this, &pos](MappingType *pair) {
+        if (pos == buffer_.size()) {
+          return false;
+        }
+        *pair = buffer_[pos++];
+        return true;
+      },
+      buffer_.size(), fill_factor_);
+  buffer_.clear();
+  return num_loaded;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_BUILDER_TYPE::SortBuffer() {
+  // a non-unique tree keeps every value of a key, only equal pairs are duplicates then
+  bool unique = tree_->IsUnique();
+  std::sort(buffer_.begin(), buffer_.end(), [this, unique](const MappingType &a, const MappingType &b) {
+    int cmp = comparator_(a.first, b.first);
+    return cmp < 0 || (cmp == 0 && !unique && a.second.Get() < b.second.Get());
+  });
+  auto end = std::unique(buffer_.begin(), buffer_.end(), [this, unique](const MappingType &a, const MappingType &b) {
+    return comparator_(a.first, b.first) == 0 && (unique || a.second == b.second);
+  });
+  buffer_.erase(end, buffer_.end());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_BUILDER_TYPE::SpillRun() {
+  SortBuffer();
+  // removed as soon as it is closed
+  std::FILE *file = std::tmpfile();
+  if (file == nullptr) {
+    throw Exception("cannot create a temporary file for a sorted run");
+  }
+  if (std::fwrite(buffer_.data(), sizeof(MappingType), buffer_.size(), file) != buffer_.size() ||
+      std::fflush(file) != 0) {
+    std::fclose(file);
+    throw Exception("I/O error while spilling a sorted run");
+  }
+  std::rewind(file);
+  runs_.push_back(Run{file, buffer_.size()});
+  buffer_.clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_BUILDER_TYPE::MergeRuns() -> size_t {
+  std::vector<RunReader> readers;
+  readers.reserve(runs_.size());
+  size_t num_pairs = 0;
+  for (const auto &run : runs_) {
+    readers.emplace_back(run);
+    num_pairs += run.size_;
+  }
+  // the run with the smallest head on top
+  auto later = [this, &readers](size_t a, size_t b) {
+    return comparator_(readers[a].Head().first, readers[b].Head().first) > 0;
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heads(later);
+  for (size_t i = 0; i < readers.size(); i++) {
+    heads.push(i);
+  }
+
+  // duplicates across runs are dropped by BulkLoad, the count is an upper bound on the number of keys
+  size_t num_loaded = tree_->BulkLoad(
+      [&readers, &heads](MappingType *pair) {
+        if (heads.empty()) {
+          return false;
+        }
+        size_t i = heads.top();
+        heads.pop();
+        *pair = readers[i].Head();
+        if (readers[i].Next()) {
+          heads.push(i);
+        }
+        return true;
+      },
+      num_pairs, fill_factor_);
+  for (auto &run : runs_) {
+    std::fclose(run.file_);
+  }
+  runs_.clear();
+  return num_loaded;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_BUILDER_TYPE::RunReader::Refill() -> bool {
+  size_t count = std::min(remaining_, MERGE_BLOCK_SIZE);
+  block_.resize(count);
+  pos_ = 0;
+  if (count == 0) {
+    return false;
+  }
+  if (std::fread(block_.data(), sizeof(MappingType), count, file_) != count) {
+    throw Exception("I/O error while reading back a sorted run");
+  }
+  remaining_ -= count;
+  return true;
+}
+
+template class BPlusTreeBuilder<GenericKey<4>, RID, GenericComparator<4>>;
+template class BPlusTreeBuilder<GenericKey<8>, RID, GenericComparator<8>>;
+template class BPlusTreeBuilder<GenericKey<16>, RID, GenericComparator<16>>;
+template class BPlusTreeBuilder<GenericKey<32>, RID, GenericComparator<32>>;
+template class BPlusTreeBuilder<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -9,6 +9,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
 #include "storage/index/b_plus_tree_index.h"
 
 namespace bustub {
@@ -19,13 +23,14 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
     : Index(std::move(metadata)),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE,
+                 false) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.Insert(index_key, rid, transaction);
 }
@@ -34,20 +39,88 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
-  container_.Remove(index_key, transaction);
+  container_.Remove(index_key, rid, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkInsertEntries(const std::function<bool(Tuple *key, RID *rid)> &next,
+                                             Transaction *transaction) {
+  if (!container_.IsEmpty()) {
+    Index::BulkInsertEntries(next, transaction);
+    return;
+  }
+  // sort all entries and build the tree bottom up
+  BPlusTreeBuilder<KeyType, ValueType, KeyComparator> builder(&container_, comparator_);
+  Tuple key;
+  RID rid;
+  KeyType index_key;
+  while (next(&key, &rid)) {
+    index_key.SetFromKey(key, GetKeySchema());
+    builder.Add(index_key, rid);
+  }
+  builder.Finish();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::ScanRange(const std::vector<Value> &low_key, const std::vector<Value> &high_key,
+                                     bool descending, Transaction *transaction) -> std::unique_ptr<IndexRangeScan> {
+  // a key is at least the low key if the leading bytes it shares with the encoded low key are not less, which makes
+  // it not less than the smallest key with those leading columns; likewise at most the high key if the bytes are not
+  // greater, which makes it not greater than the largest key with them, the encoding followed by all one bytes
+  KeyType low;
+  size_t low_length = std::min(low.SetFromPrefix(CastKeyPrefix(low_key)), comparator_.CompareSize());
+  KeyType high;
+  size_t high_length = std::min(high.SetFromPrefix(CastKeyPrefix(high_key)), comparator_.CompareSize());
+  if (descending) {
+    KeyType largest = high;
+    memset(largest.data_ + high_length, 0xFF, sizeof(KeyType) - high_length);
+    return std::make_unique<RangeScan>(container_.RBegin(largest), low, low_length, true);
+  }
+  return std::make_unique<RangeScan>(container_.Begin(low), high, high_length, false);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::RangeScan::NextBatch(std::vector<RID> *rids) -> bool {
+  rids->clear();
+  if (iterator_.IsEnd()) {
+    return false;
+  }
+  iterator_.TakeBatch(&pairs_);
+  for (const auto &pair : pairs_) {
+    int cmp = memcmp(pair.first.data_, end_key_.data_, end_length_);
+    if (descending_ ? cmp < 0 : cmp > 0) {
+      iterator_ = INDEXITERATOR_TYPE();
+      break;
+    }
+    rids->push_back(pair.second);
+  }
+  return !rids->empty();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::CastKeyPrefix(const std::vector<Value> &values) const -> std::vector<Value> {
+  if (values.size() > GetKeySchema()->GetColumnCount()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "a key bound has more values than the key has columns");
+  }
+  std::vector<Value> prefix;
+  prefix.reserve(values.size());
+  for (uint32_t i = 0; i < values.size(); i++) {
+    prefix.push_back(values[i].CastAs(GetKeySchema()->GetColumn(i).GetType()));
+  }
+  return prefix;
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_.Begin(); }
 
@@ -57,6 +130,14 @@ auto BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) -> INDEXITERATOR
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetEndIterator() -> INDEXITERATOR_TYPE { return container_.End(); }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseBeginIterator() -> INDEXITERATOR_TYPE { return container_.RBegin(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE {
+  return container_.RBegin(key);
+}
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
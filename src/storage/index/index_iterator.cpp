@@ -1,30 +1,175 @@
 /**
  * index_iterator.cpp
  */
+#include <algorithm>
 #include <cassert>
+#include <utility>
 
+#include "common/exception.h"
 #include "storage/index/index_iterator.h"
+#include "storage/index/posting_list_store.h"
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index, bool reverse,
+                                  bool unique)
+    : buffer_pool_manager_(buffer_pool_manager), page_(page), index_(index), reverse_(reverse), unique_(unique) {
+  Settle();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() {  // NOLINT
+  if (page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other) noexcept
+    : buffer_pool_manager_(other.buffer_pool_manager_),
+      page_(other.page_),
+      index_(other.index_),
+      batch_(std::move(other.batch_)),
+      batch_pos_(other.batch_pos_),
+      reverse_(other.reverse_),
+      unique_(other.unique_) {
+  other.page_ = nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator=(IndexIterator &&other) noexcept -> INDEXITERATOR_TYPE & {
+  if (this != &other) {
+    if (page_ != nullptr) {
+      buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    }
+    buffer_pool_manager_ = other.buffer_pool_manager_;
+    page_ = other.page_;
+    index_ = other.index_;
+    batch_ = std::move(other.batch_);
+    batch_pos_ = other.batch_pos_;
+    reverse_ = other.reverse_;
+    unique_ = other.unique_;
+    other.page_ = nullptr;
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::IsEnd() -> bool { return page_ == nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
+  assert(page_ != nullptr);
+  return batch_[batch_pos_];
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
+  assert(page_ != nullptr);
+  if (++batch_pos_ < batch_.size()) {
+    return *this;
+  }
+  // pairs may have been inserted after the batch since it was copied
+  page_->RLatch();
+  Settle();
+  return *this;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::IsEnd() -> bool { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::TakeBatch(std::vector<MappingType> *batch) {
+  assert(page_ != nullptr);
+  batch->assign(batch_.begin() + batch_pos_, batch_.end());
+  batch_pos_ = batch_.size() - 1;
+  ++(*this);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::Settle() {
+  while (true) {
+    auto *leaf = reinterpret_cast<LeafPage *>(page_->GetData());
+    page_id_t next_page_id = reverse_ ? leaf->GetPrevPageId() : leaf->GetNextPageId();
+    if (reverse_) {
+      // pairs may have been removed since the iterator was positioned
+      index_ = std::min(index_, leaf->GetSize() - 1);
+    }
+    if (reverse_ ? index_ >= 0 : index_ < leaf->GetSize()) {
+      batch_.clear();
+      std::vector<RID> rids;
+      for (; reverse_ ? index_ >= 0 : index_ < leaf->GetSize(); index_ += reverse_ ? -1 : 1) {
+        MappingType item = leaf->GetItem(index_);
+        if (unique_ || !PostingListStore::IsPostingList(item.second)) {
+          batch_.push_back(item);
+          continue;
+        }
+        rids.clear();
+        PostingListStore::Read(buffer_pool_manager_, item.second, &rids);
+        if (reverse_) {
+          std::reverse(rids.begin(), rids.end());
+        }
+        for (const RID &rid : rids) {
+          batch_.emplace_back(item.first, rid);
+        }
+      }
+      batch_pos_ = 0;
+      page_->RUnlatch();
+      // the following leaf is read in while the batch is consumed
+      if (next_page_id != INVALID_PAGE_ID) {
+        buffer_pool_manager_->PrefetchPages({next_page_id});
+      }
+      return;
+    }
+    // a leaf merged away still links to its neighbours of the time of the merge, its pairs went to the left one
+    page_id_t from_page_id = leaf->GetSize() > 0 ? page_->GetPageId() : INVALID_PAGE_ID;
+    page_id_t from_next_page_id = leaf->GetNextPageId();
+    MoveTo(next_page_id);
+    if (page_ == nullptr) {
+      return;
+    }
+    if (reverse_ && from_page_id != INVALID_PAGE_ID) {
+      // the prev link is set a moment after the split or merge that changes it, so the leaf may have split since and
+      // the pairs before the one the iterator came from are further right; the leaf came from may have been merged
+      // into it as well, it then links to the one after
+      while (true) {
+        auto *prev_leaf = reinterpret_cast<LeafPage *>(page_->GetData());
+        page_id_t prev_next_page_id = prev_leaf->GetNextPageId();
+        if (prev_leaf->GetSize() == 0 || prev_next_page_id == from_page_id || prev_next_page_id == from_next_page_id ||
+            prev_next_page_id == INVALID_PAGE_ID) {
+          break;
+        }
+        MoveTo(prev_next_page_id);
+      }
+    }
+    if (reverse_) {
+      index_ = reinterpret_cast<LeafPage *>(page_->GetData())->GetSize() - 1;
+    }
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::MoveTo(page_id_t page_id) {
+  Page *next_page = nullptr;
+  if (page_id != INVALID_PAGE_ID) {
+    // pinned while its neighbour is latched: a leaf is only ever merged into its left neighbour, and its pages are
+    // only deleted once the leaves around them link past them
+    next_page = buffer_pool_manager_->FetchPage(page_id);
+    if (next_page == nullptr) {
+      page_->RUnlatch();
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch the next leaf of a B+ tree");
+    }
+  }
+  page_->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  page_ = next_page;
+  index_ = 0;
+  batch_pos_ = 0;
+  if (page_ != nullptr) {
+    page_->RLatch();
+  }
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -0,0 +1,305 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_encoding.cpp
+//
+// Identification: src/storage/index/key_encoding.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/key_encoding.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common/exception.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr uint8_t VARCHAR_ESCAPE = 0x00;
+constexpr uint8_t VARCHAR_ESCAPED_ZERO = 0xFF;
+constexpr uint8_t VARCHAR_END = 0x01;
+constexpr uint8_t VARCHAR_NULL = 0x00;
+
+/** Appends to an encoded key, dropping the bytes that do not fit. */
+class KeyWriter {
+ public:
+  KeyWriter(char *data, size_t size) : data_(data), size_(size) {}
+
+  void PutByte(uint8_t byte) {
+    if (pos_ < size_) {
+      data_[pos_] = static_cast<char>(byte);
+    }
+    pos_++;
+  }
+
+  /** @return the number of bytes put, including those dropped */
+  auto Length() const -> size_t { return pos_; }
+
+  /** Put the low width bytes of bits, most significant first. */
+  void PutBigEndian(uint64_t bits, size_t width) {
+    for (size_t i = width; i-- > 0;) {
+      PutByte(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+  }
+
+  /** Put a signed integer of width bytes with its sign bit flipped. */
+  void PutSigned(int64_t value, size_t width) {
+    PutBigEndian(static_cast<uint64_t>(value) ^ (uint64_t{1} << (8 * width - 1)), width);
+  }
+
+ private:
+  char *data_;
+  size_t size_;
+  size_t pos_{0};
+};
+
+/** Reads an encoded key back, every read fails once the key is exhausted. */
+class KeyReader {
+ public:
+  KeyReader(const char *data, size_t size) : data_(data), size_(size) {}
+
+  auto GetByte(uint8_t *byte) -> bool {
+    if (pos_ == size_) {
+      return false;
+    }
+    *byte = static_cast<uint8_t>(data_[pos_++]);
+    return true;
+  }
+
+  auto GetBigEndian(size_t width, uint64_t *bits) -> bool {
+    *bits = 0;
+    for (size_t i = 0; i < width; i++) {
+      uint8_t byte;
+      if (!GetByte(&byte)) {
+        return false;
+      }
+      *bits = (*bits << 8) | byte;
+    }
+    return true;
+  }
+
+  /** Read a signed integer of width bytes, sign extended. */
+  auto GetSigned(size_t width, int64_t *value) -> bool {
+    uint64_t bits;
+    if (!GetBigEndian(width, &bits)) {
+      return false;
+    }
+    size_t shift = 64 - 8 * width;
+    *value = static_cast<int64_t>((bits ^ (uint64_t{1} << (8 * width - 1))) << shift) >> shift;
+    return true;
+  }
+
+  /** Read a varchar, @return false if the key ends before its terminator */
+  auto GetVarchar(std::string *str, bool *is_null) -> bool {
+    str->clear();
+    *is_null = false;
+    uint8_t byte;
+    while (GetByte(&byte)) {
+      if (byte != VARCHAR_ESCAPE) {
+        str->push_back(static_cast<char>(byte));
+        continue;
+      }
+      if (!GetByte(&byte)) {
+        return false;
+      }
+      if (byte == VARCHAR_ESCAPED_ZERO) {
+        str->push_back('\0');
+        continue;
+      }
+      *is_null = byte == VARCHAR_NULL;
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  const char *data_;
+  size_t size_;
+  size_t pos_{0};
+};
+
+auto DecimalBits(double value) -> uint64_t {
+  // -0.0 equals 0.0
+  if (value == 0) {
+    value = 0;
+  }
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return (bits >> 63) != 0 ? ~bits : bits | (uint64_t{1} << 63);
+}
+
+auto DecimalFromBits(uint64_t bits) -> double {
+  bits = (bits >> 63) != 0 ? bits & ~(uint64_t{1} << 63) : ~bits;
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/** Put a value as a key column of the type. */
+void PutValue(const Value &value, TypeId type, KeyWriter *writer) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      writer->PutSigned(value.GetAs<int8_t>(), sizeof(int8_t));
+      break;
+    case TypeId::SMALLINT:
+      writer->PutSigned(value.GetAs<int16_t>(), sizeof(int16_t));
+      break;
+    case TypeId::INTEGER:
+      writer->PutSigned(value.GetAs<int32_t>(), sizeof(int32_t));
+      break;
+    case TypeId::BIGINT:
+      writer->PutSigned(value.GetAs<int64_t>(), sizeof(int64_t));
+      break;
+    case TypeId::TIMESTAMP:
+      writer->PutBigEndian(value.GetAs<uint64_t>(), sizeof(uint64_t));
+      break;
+    case TypeId::DECIMAL:
+      writer->PutBigEndian(DecimalBits(value.GetAs<double>()), sizeof(uint64_t));
+      break;
+    case TypeId::VARCHAR: {
+      if (value.IsNull()) {
+        writer->PutByte(VARCHAR_ESCAPE);
+        writer->PutByte(VARCHAR_NULL);
+        break;
+      }
+      // the length counts a terminating '\0'
+      uint32_t length = value.GetLength() == 0 ? 0 : value.GetLength() - 1;
+      const char *str = value.GetData();
+      for (uint32_t j = 0; j < length; j++) {
+        writer->PutByte(static_cast<uint8_t>(str[j]));
+        if (str[j] == '\0') {
+          writer->PutByte(VARCHAR_ESCAPED_ZERO);
+        }
+      }
+      writer->PutByte(VARCHAR_ESCAPE);
+      writer->PutByte(VARCHAR_END);
+      break;
+    }
+    default:
+      throw Exception(ExceptionType::UNKNOWN_TYPE, "cannot encode a key column of this type");
+  }
+}
+
+}  // namespace
+
+void KeyEncoding::Encode(const Tuple &key, const Schema *key_schema, char *data, size_t size) {
+  std::memset(data, 0, size);
+  KeyWriter writer(data, size);
+  for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+    PutValue(key.GetValue(key_schema, i), key_schema->GetColumn(i).GetType(), &writer);
+  }
+}
+
+auto KeyEncoding::EncodePrefix(const std::vector<Value> &values, char *data, size_t size) -> size_t {
+  std::memset(data, 0, size);
+  KeyWriter writer(data, size);
+  for (const auto &value : values) {
+    PutValue(value, value.GetTypeId(), &writer);
+  }
+  return writer.Length();
+}
+
+auto KeyEncoding::Decode(const char *data, size_t size, const Schema *key_schema, uint32_t column_idx) -> Value {
+  KeyReader reader(data, size);
+  for (uint32_t i = 0; i <= column_idx; i++) {
+    TypeId type = key_schema->GetColumn(i).GetType();
+    int64_t integer = 0;
+    uint64_t bits = 0;
+    std::string str;
+    bool is_null = false;
+    bool complete;
+    switch (type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+      case TypeId::SMALLINT:
+      case TypeId::INTEGER:
+      case TypeId::BIGINT:
+        complete = reader.GetSigned(FixedWidth(type), &integer);
+        break;
+      case TypeId::TIMESTAMP:
+      case TypeId::DECIMAL:
+        complete = reader.GetBigEndian(sizeof(uint64_t), &bits);
+        break;
+      case TypeId::VARCHAR:
+        complete = reader.GetVarchar(&str, &is_null);
+        break;
+      default:
+        throw Exception(ExceptionType::UNKNOWN_TYPE, "cannot decode a key column of this type");
+    }
+    if (!complete) {
+      return ValueFactory::GetNullValueByType(key_schema->GetColumn(column_idx).GetType());
+    }
+    if (i < column_idx) {
+      continue;
+    }
+    switch (type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        return {type, static_cast<int8_t>(integer)};
+      case TypeId::SMALLINT:
+        return {type, static_cast<int16_t>(integer)};
+      case TypeId::INTEGER:
+        return {type, static_cast<int32_t>(integer)};
+      case TypeId::BIGINT:
+        return {type, integer};
+      case TypeId::TIMESTAMP:
+        return {type, bits};
+      case TypeId::DECIMAL:
+        return {type, DecimalFromBits(bits)};
+      default:
+        return is_null ? ValueFactory::GetNullValueByType(type) : ValueFactory::GetVarcharValue(str);
+    }
+  }
+  UNREACHABLE("column_idx is out of range");
+}
+
+auto KeyEncoding::FixedLength(const Schema *key_schema) -> size_t {
+  size_t length = 0;
+  for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+    size_t width = FixedWidth(key_schema->GetColumn(i).GetType());
+    if (width == 0) {
+      return 0;
+    }
+    length += width;
+  }
+  return length;
+}
+
+void KeyEncoding::EncodeBigInt(int64_t value, char *data) {
+  KeyWriter(data, sizeof(int64_t)).PutSigned(value, sizeof(int64_t));
+}
+
+auto KeyEncoding::DecodeBigInt(const char *data) -> int64_t {
+  int64_t value;
+  KeyReader(data, sizeof(int64_t)).GetSigned(sizeof(int64_t), &value);
+  return value;
+}
+
+auto KeyEncoding::FixedWidth(TypeId type) -> size_t {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return sizeof(int8_t);
+    case TypeId::SMALLINT:
+      return sizeof(int16_t);
+    case TypeId::INTEGER:
+      return sizeof(int32_t);
+    case TypeId::BIGINT:
+    case TypeId::TIMESTAMP:
+    case TypeId::DECIMAL:
+      return sizeof(uint64_t);
+    default:
+      return 0;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,501 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posting_list_store.cpp
+//
+// Identification: src/storage/index/posting_list_store.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/posting_list_store.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "common/exception.h"
+#include "storage/page/b_plus_tree_overflow_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
+
+namespace bustub {
+
+namespace {
+
+/** Delta encodes RIDs in increasing order, see PostingListStore::Encode. */
+class RunEncoder {
+ public:
+  explicit RunEncoder(std::vector<char> *data) : data_(data) {}
+
+  /** @return the number of bytes Put appends for a RID */
+  auto Length(const RID &rid) const -> size_t {
+    auto [page_delta, slot_delta] = Deltas(rid);
+    return VarintLength(page_delta) + VarintLength(slot_delta);
+  }
+
+  void Put(const RID &rid) {
+    auto [page_delta, slot_delta] = Deltas(rid);
+    PutVarint(page_delta);
+    PutVarint(slot_delta);
+    page_id_ = rid.GetPageId();
+    next_slot_ = rid.GetSlotNum() + 1;
+  }
+
+ private:
+  auto Deltas(const RID &rid) const -> std::pair<uint32_t, uint32_t> {
+    auto page_delta = static_cast<uint32_t>(rid.GetPageId() - page_id_);
+    return {page_delta, page_delta == 0 ? rid.GetSlotNum() - next_slot_ : rid.GetSlotNum()};
+  }
+
+  static auto VarintLength(uint32_t value) -> size_t {
+    size_t length = 1;
+    for (; value >= 0x80; value >>= 7) {
+      length++;
+    }
+    return length;
+  }
+
+  void PutVarint(uint32_t value) {
+    for (; value >= 0x80; value >>= 7) {
+      data_->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    }
+    data_->push_back(static_cast<char>(value));
+  }
+
+  std::vector<char> *data_;
+  page_id_t page_id_{0};
+  uint32_t next_slot_{0};
+};
+
+auto GetVarint(const char *data, size_t *pos) -> uint32_t {
+  uint32_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    auto byte = static_cast<uint8_t>(data[(*pos)++]);
+    value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+}
+
+/**
+ * Encode as many RIDs from begin on as fit into capacity bytes, at least one.
+ * @return the position after the last one encoded
+ */
+auto EncodeRun(const std::vector<RID> &rids, size_t begin, size_t capacity, std::vector<char> *data) -> size_t {
+  data->clear();
+  RunEncoder encoder(data);
+  size_t end = begin;
+  while (end < rids.size() && (end == begin || data->size() + encoder.Length(rids[end]) <= capacity)) {
+    encoder.Put(rids[end++]);
+  }
+  return end;
+}
+
+auto RidLess(const RID &a, const RID &b) -> bool { return a.Get() < b.Get(); }
+
+}  // namespace
+
+PostingListStore::PostingListStore(BufferPoolManager *buffer_pool_manager)
+    : buffer_pool_manager_(buffer_pool_manager) {}
+
+void PostingListStore::Read(BufferPoolManager *buffer_pool_manager, const RID &value, std::vector<RID> *rids) {
+  if (!IsPostingList(value)) {
+    rids->push_back(value);
+    return;
+  }
+  if ((value.GetSlotNum() & CHAIN_FLAG) != 0) {
+    for (page_id_t page_id = value.GetPageId(); page_id != INVALID_PAGE_ID;) {
+      Page *page = FetchPage(buffer_pool_manager, page_id);
+      auto *overflow = reinterpret_cast<BPlusTreeOverflowPage *>(page->GetData());
+      Decode(overflow->GetRun(), overflow->GetLength(), rids);
+      page_id_t next_page_id = overflow->GetNextPageId();
+      buffer_pool_manager->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    return;
+  }
+  Page *page = FetchPage(buffer_pool_manager, value.GetPageId());
+  page->RLatch();
+  auto *posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  int slot = static_cast<int>(value.GetSlotNum() & ~LIST_FLAG);
+  Decode(posting->GetList(slot), posting->GetLength(slot), rids);
+  page->RUnlatch();
+  buffer_pool_manager->UnpinPage(value.GetPageId(), false);
+}
+
+auto PostingListStore::Create(std::vector<RID> *rids) -> RID {
+  assert(!rids->empty());
+  std::sort(rids->begin(), rids->end(), RidLess);
+  rids->erase(std::unique(rids->begin(), rids->end()), rids->end());
+  return Store(*rids);
+}
+
+auto PostingListStore::Add(RID *value, const RID &rid) -> bool {
+  if (!IsPostingList(*value)) {
+    if (*value == rid) {
+      return false;
+    }
+    std::vector<RID> rids{*value, rid};
+    *value = Create(&rids);
+    return true;
+  }
+  if ((value->GetSlotNum() & CHAIN_FLAG) != 0) {
+    return AddToChain(value->GetPageId(), rid);
+  }
+  return UpdateShared(value, [&rid](std::vector<RID> *rids) {
+    auto pos = std::lower_bound(rids->begin(), rids->end(), rid, RidLess);
+    if (pos != rids->end() && *pos == rid) {
+      return false;
+    }
+    rids->insert(pos, rid);
+    return true;
+  });
+}
+
+auto PostingListStore::Remove(RID *value, const RID &rid) -> bool {
+  assert(IsPostingList(*value));
+  if ((value->GetSlotNum() & CHAIN_FLAG) == 0) {
+    return UpdateShared(value, [&rid](std::vector<RID> *rids) {
+      auto pos = std::lower_bound(rids->begin(), rids->end(), rid, RidLess);
+      if (pos == rids->end() || !(*pos == rid)) {
+        return false;
+      }
+      rids->erase(pos);
+      return true;
+    });
+  }
+  page_id_t head_page_id = value->GetPageId();
+  if (!RemoveFromChain(head_page_id, rid)) {
+    return false;
+  }
+  // a chain that shrank to a short run goes back to sharing a posting page, the margin keeps a list at the threshold
+  // from moving back and forth
+  Page *page = FetchPage(buffer_pool_manager_, head_page_id);
+  auto *head = reinterpret_cast<BPlusTreeOverflowPage *>(page->GetData());
+  if (head->GetNextPageId() != INVALID_PAGE_ID || head->GetLength() > MAX_SHARED_LENGTH / 2) {
+    buffer_pool_manager_->UnpinPage(head_page_id, false);
+    return true;
+  }
+  std::vector<RID> rids;
+  Decode(head->GetRun(), head->GetLength(), &rids);
+  buffer_pool_manager_->UnpinPage(head_page_id, false);
+  *value = Store(rids);
+  FreeChain(head_page_id);
+  return true;
+}
+
+void PostingListStore::Free(const RID &value) {
+  if (!IsPostingList(value)) {
+    return;
+  }
+  if ((value.GetSlotNum() & CHAIN_FLAG) != 0) {
+    FreeChain(value.GetPageId());
+    return;
+  }
+  FreeShared(value.GetPageId(), static_cast<int>(value.GetSlotNum() & ~LIST_FLAG));
+}
+
+void PostingListStore::Encode(std::vector<RID>::const_iterator begin, std::vector<RID>::const_iterator end,
+                              std::vector<char> *data) {
+  RunEncoder encoder(data);
+  for (auto it = begin; it != end; ++it) {
+    encoder.Put(*it);
+  }
+}
+
+void PostingListStore::Decode(const char *data, size_t length, std::vector<RID> *rids) {
+  page_id_t page_id = 0;
+  uint32_t next_slot = 0;
+  for (size_t pos = 0; pos < length;) {
+    uint32_t page_delta = GetVarint(data, &pos);
+    uint32_t slot_delta = GetVarint(data, &pos);
+    page_id += static_cast<page_id_t>(page_delta);
+    uint32_t slot_num = page_delta == 0 ? next_slot + slot_delta : slot_delta;
+    rids->emplace_back(page_id, slot_num);
+    next_slot = slot_num + 1;
+  }
+}
+
+auto PostingListStore::Store(const std::vector<RID> &rids) -> RID {
+  if (rids.size() == 1) {
+    return rids[0];
+  }
+  std::vector<char> data;
+  Encode(rids.begin(), rids.end(), &data);
+  return data.size() <= MAX_SHARED_LENGTH ? StoreShared(data) : CreateChain(rids);
+}
+
+template <typename Change>
+auto PostingListStore::UpdateShared(RID *value, Change change) -> bool {
+  page_id_t page_id = value->GetPageId();
+  int slot = static_cast<int>(value->GetSlotNum() & ~LIST_FLAG);
+  Page *page = FetchPage(buffer_pool_manager_, page_id);
+  page->WLatch();
+  auto *posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  std::vector<RID> rids;
+  Decode(posting->GetList(slot), posting->GetLength(slot), &rids);
+  if (!change(&rids)) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return false;
+  }
+  if (rids.size() == 1) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    *value = rids[0];
+    FreeShared(page_id, slot);
+    return true;
+  }
+  std::vector<char> data;
+  Encode(rids.begin(), rids.end(), &data);
+  bool updated = data.size() <= MAX_SHARED_LENGTH && posting->Update(slot, data.data(), data.size());
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, updated);
+  if (!updated) {
+    // the list is stored anew before the old one is freed, the key keeps it should that fail
+    *value = Store(rids);
+    FreeShared(page_id, slot);
+  }
+  return true;
+}
+
+auto PostingListStore::StoreShared(const std::vector<char> &data) -> RID {
+  std::scoped_lock guard(latch_);
+  if (fill_page_id_ != INVALID_PAGE_ID) {
+    Page *page = FetchPage(buffer_pool_manager_, fill_page_id_);
+    page->WLatch();
+    int slot = reinterpret_cast<BPlusTreePostingPage *>(page->GetData())->Insert(data.data(), data.size());
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(fill_page_id_, slot >= 0);
+    if (slot >= 0) {
+      return RID(fill_page_id_, static_cast<uint32_t>(slot) | LIST_FLAG);
+    }
+  }
+  // no other thread reaches the new page before it is the fill page
+  page_id_t page_id;
+  Page *page = NewPage(&page_id);
+  auto *posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  posting->Init();
+  int slot = posting->Insert(data.data(), data.size());
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  fill_page_id_ = page_id;
+  return RID(page_id, static_cast<uint32_t>(slot) | LIST_FLAG);
+}
+
+void PostingListStore::FreeShared(page_id_t page_id, int slot) {
+  Page *page = FetchPage(buffer_pool_manager_, page_id);
+  page->WLatch();
+  auto *posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  posting->Remove(slot);
+  bool empty = posting->IsEmpty();
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  if (empty) {
+    DropSharedPage(page_id);
+  }
+}
+
+void PostingListStore::DropSharedPage(page_id_t page_id) {
+  // a page that new lists do not go to only gets lists back while some are left in it, so once it is empty it stays so
+  std::scoped_lock guard(latch_);
+  if (page_id == fill_page_id_) {
+    return;
+  }
+  Page *page = FetchPage(buffer_pool_manager_, page_id);
+  page->RLatch();
+  bool empty = reinterpret_cast<BPlusTreePostingPage *>(page->GetData())->IsEmpty();
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  if (empty) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+}
+
+auto PostingListStore::CreateChain(const std::vector<RID> &rids) -> RID {
+  page_id_t head_page_id = INVALID_PAGE_ID;
+  Page *last_page = nullptr;
+  std::vector<char> data;
+  for (size_t begin = 0; begin < rids.size();) {
+    size_t end = EncodeRun(rids, begin, OVERFLOW_PAGE_CAPACITY, &data);
+    page_id_t page_id;
+    Page *page = NewPage(&page_id);
+    auto *overflow = reinterpret_cast<BPlusTreeOverflowPage *>(page->GetData());
+    overflow->Init();
+    overflow->SetRun(data.data(), data.size(), rids[end - 1].Get());
+    if (last_page == nullptr) {
+      head_page_id = page_id;
+    } else {
+      reinterpret_cast<BPlusTreeOverflowPage *>(last_page->GetData())->SetNextPageId(page_id);
+      buffer_pool_manager_->UnpinPage(last_page->GetPageId(), true);
+    }
+    last_page = page;
+    begin = end;
+  }
+  page_id_t tail_page_id = last_page->GetPageId();
+  buffer_pool_manager_->UnpinPage(tail_page_id, true);
+  Page *head_page = FetchPage(buffer_pool_manager_, head_page_id);
+  reinterpret_cast<BPlusTreeOverflowPage *>(head_page->GetData())->SetTailPageId(tail_page_id);
+  buffer_pool_manager_->UnpinPage(head_page_id, true);
+  return RID(head_page_id, LIST_FLAG | CHAIN_FLAG);
+}
+
+auto PostingListStore::AddToChain(page_id_t head_page_id, const RID &rid) -> bool {
+  Page *head_page = FetchPage(buffer_pool_manager_, head_page_id);
+  auto *head = reinterpret_cast<BPlusTreeOverflowPage *>(head_page->GetData());
+  // RIDs past the end of the list go to the last page, others to the first page whose run does not end before them
+  page_id_t page_id = head->GetTailPageId();
+  Page *page = FetchPage(buffer_pool_manager_, page_id);
+  auto *overflow = reinterpret_cast<BPlusTreeOverflowPage *>(page->GetData());
+  if (rid.Get() <= overflow->GetLastRid()) {
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    // the next page id is read while the page is pinned, an unpinned frame may be reused at once
+    for (page_id = head_page_id;;) {
+      page = FetchPage(buffer_pool_manager_, page_id);
+      overflow = reinterpret_cast<BPlusTreeOverflowPage *>(page->GetData());
+      if (rid.Get() <= overflow->GetLastRid()) {
+        break;
+      }
+      page_id_t next_page_id = overflow->GetNextPageId();
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+  }
+
+  std::vector<RID> rids;
+  Decode(overflow->GetRun(), overflow->GetLength(), &rids);
+  auto pos = std::lower_bound(rids.begin(), rids.end(), rid, RidLess);
+  if (pos != rids.end() && *pos == rid) {
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    buffer_pool_manager_->UnpinPage(head_page_id, false);
+    return false;
+  }
+  bool append = pos == rids.end();
+  rids.insert(pos, rid);
+  std::vector<char> data;
+  if (EncodeRun(rids, 0, OVERFLOW_PAGE_CAPACITY, &data) == rids.size()) {
+    overflow->SetRun(data.data(), data.size(), rids.back().Get());
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    buffer_pool_manager_->UnpinPage(head_page_id, true);
+    return true;
+  }
+
+  // split the run with a new page after it; a RID appended to a full last page starts the new page on its own, so
+  // that the pages of a list that grows at its end end up full
+  size_t split = append ? rids.size() - 1 : rids.size() / 2;
+  page_id_t new_page_id;
+  auto *sibling = reinterpret_cast<BPlusTreeOverflowPage *>(NewPage(&new_page_id)->GetData());
+  sibling->Init();
+  size_t end = EncodeRun(rids, split, OVERFLOW_PAGE_CAPACITY, &data);
+  assert(end == rids.size());
+  (void)end;
+  sibling->SetRun(data.data(), data.size(), rids.back().Get());
+  sibling->SetNextPageId(overflow->GetNextPageId());
+  data.clear();
+  Encode(rids.begin(), rids.begin() + split, &data);
+  overflow->SetRun(data.data(), data.size(), rids[split - 1].Get());
+  overflow->SetNextPageId(new_page_id);
+  if (head->GetTailPageId() == page_id) {
+    head->SetTailPageId(new_page_id);
+  }
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  buffer_pool_manager_->UnpinPage(head_page_id, true);
+  return true;
+}
+
+auto PostingListStore::RemoveFromChain(page_id_t head_page_id, const RID &rid) -> bool {
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id = head_page_id;
+  Page *page;
+  BPlusTreeOverflowPage *overflow;
+  while (true) {
+    page = FetchPage(buffer_pool_manager_, page_id);
+    overflow = reinterpret_cast<BPlusTreeOverflowPage *>(page->GetData());
+    if (rid.Get() <= overflow->GetLastRid()) {
+      break;
+    }
+    page_id_t next_page_id = overflow->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (next_page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+    prev_page_id = page_id;
+    page_id = next_page_id;
+  }
+
+  std::vector<RID> rids;
+  Decode(overflow->GetRun(), overflow->GetLength(), &rids);
+  auto pos = std::lower_bound(rids.begin(), rids.end(), rid, RidLess);
+  if (pos == rids.end() || !(*pos == rid)) {
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return false;
+  }
+  rids.erase(pos);
+  page_id_t next_page_id = overflow->GetNextPageId();
+  if (!rids.empty() || (page_id == head_page_id && next_page_id == INVALID_PAGE_ID)) {
+    std::vector<char> data;
+    Encode(rids.begin(), rids.end(), &data);
+    overflow->SetRun(data.data(), data.size(), rids.empty() ? 0 : rids.back().Get());
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    return true;
+  }
+
+  // unlink the empty page; the first page stays where the value of the key refers to and takes over the next run
+  if (page_id == head_page_id) {
+    Page *next_page = FetchPage(buffer_pool_manager_, next_page_id);
+    auto *next = reinterpret_cast<BPlusTreeOverflowPage *>(next_page->GetData());
+    overflow->SetRun(next->GetRun(), next->GetLength(), next->GetLastRid());
+    overflow->SetNextPageId(next->GetNextPageId());
+    if (overflow->GetTailPageId() == next_page_id) {
+      overflow->SetTailPageId(head_page_id);
+    }
+    buffer_pool_manager_->UnpinPage(next_page_id, false);
+    buffer_pool_manager_->DeletePage(next_page_id);
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    return true;
+  }
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  buffer_pool_manager_->DeletePage(page_id);
+  Page *prev_page = FetchPage(buffer_pool_manager_, prev_page_id);
+  reinterpret_cast<BPlusTreeOverflowPage *>(prev_page->GetData())->SetNextPageId(next_page_id);
+  buffer_pool_manager_->UnpinPage(prev_page_id, true);
+  Page *head_page = FetchPage(buffer_pool_manager_, head_page_id);
+  auto *head = reinterpret_cast<BPlusTreeOverflowPage *>(head_page->GetData());
+  bool was_tail = head->GetTailPageId() == page_id;
+  if (was_tail) {
+    head->SetTailPageId(prev_page_id);
+  }
+  buffer_pool_manager_->UnpinPage(head_page_id, was_tail);
+  return true;
+}
+
+void PostingListStore::FreeChain(page_id_t head_page_id) {
+  for (page_id_t page_id = head_page_id; page_id != INVALID_PAGE_ID;) {
+    Page *page = FetchPage(buffer_pool_manager_, page_id);
+    page_id_t next_page_id = reinterpret_cast<BPlusTreeOverflowPage *>(page->GetData())->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    buffer_pool_manager_->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+auto PostingListStore::FetchPage(BufferPoolManager *buffer_pool_manager, page_id_t page_id) -> Page * {
+  Page *page = buffer_pool_manager->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a page of a posting list");
+  }
+  return page;
+}
+
+auto PostingListStore::NewPage(page_id_t *page_id) -> Page * {
+  Page *page = buffer_pool_manager_->NewPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a page for a posting list");
+  }
+  return page;
+}
+
+}  // namespace bustub
@@ -10,9 +10,13 @@
 //===----------------------------------------------------------------------===//
 
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#include <vector>
 
 #include "common/exception.h"
+#include "storage/index/key_search.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 
 namespace bustub {
@@ -23,36 +27,142 @@ namespace bustub {
  * Init method after creating a new internal page
  * Including set page type, set current size, set page id, set parent id and set
  * max page size
+ * The page covers all keys, from all zero bytes to all one bytes.
+ * @param max_size limit to the max size, which is lower if the slots do not fit one child more than that
+ * @param key_size number of leading bytes of a key that decide its order
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size, size_t key_size) {
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetLSN();
+  size_limit_ = max_size;
+  key_size_ = static_cast<uint16_t>(std::min(key_size, sizeof(KeyType)));
+  KeyType low_key;
+  KeyType high_key;
+  memset(&low_key, 0, sizeof(KeyType));
+  memset(&high_key, 0, sizeof(KeyType));
+  memset(&high_key, 0xFF, key_size_);
+  SetFences(low_key, high_key);
+  // the prefix of any range is at least as long as that of the full range
+  SetMinSize((GetMaxSize() + 1) / 2);
+}
+/**
+ * Helper methods to set/get next page id
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  KeyType key{};
+  KeyType key;
+  auto *key_data = reinterpret_cast<char *>(&key);
+  memcpy(key_data, &low_key_, prefix_size_);
+  memcpy(key_data + prefix_size_, SlotAt(index), key_size_ - prefix_size_);
+  memset(key_data + key_size_, 0, sizeof(KeyType) - key_size_);
   return key;
 }
 
+/*
+ * The key must share the prefix of the page
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  memcpy(SlotAt(index), reinterpret_cast<const char *>(&key) + prefix_size_, key_size_ - prefix_size_);
+}
 
 /*
  * Helper method to find and return array index(or offset), so that its value
  * equals to input "value"
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const -> int { return 0; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const -> int {
+  for (int i = 0; i < GetSize(); i++) {
+    if (ValueAt(i) == value) {
+      return i;
+    }
+  }
+  return -1;
+}
 
 /*
  * Helper method to get the value associated with input "index"(a.k.a array
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return 0; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType {
+  ValueType value;
+  memcpy(&value, SlotAt(index) + key_size_ - prefix_size_, sizeof(ValueType));
+  return value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  memcpy(SlotAt(index) + key_size_ - prefix_size_, &value, sizeof(ValueType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::SlotWidth() const -> size_t {
+  return key_size_ - prefix_size_ + sizeof(ValueType);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::SlotAt(int index) -> char * { return slots_ + index * SlotWidth(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::SlotAt(int index) const -> const char * { return slots_ + index * SlotWidth(); }
+
+/*
+ * Helper methods to get/set the key range of the page
+ * Setting it lays the slots out again for the prefix of the new range, and resizes the page to match.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetLowKey() const -> const KeyType & { return low_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetHighKey() const -> const KeyType & { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetFences(const KeyType &low_key, const KeyType &high_key) {
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    items.emplace_back(i == 0 ? low_key : KeyAt(i), ValueAt(i));
+  }
+  assert(GetSize() <= MaxSizeFor(low_key, high_key));
+  SetMaxSize(MaxSizeFor(low_key, high_key));
+  low_key_ = low_key;
+  high_key_ = high_key;
+  prefix_size_ = static_cast<uint16_t>(CommonPrefixSize(reinterpret_cast<const char *>(&low_key_),
+                                                        reinterpret_cast<const char *>(&high_key_), key_size_));
+  for (int i = 0; i < GetSize(); i++) {
+    SetKeyAt(i, items[i].first);
+    SetValueAt(i, items[i].second);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::MaxSizeFor(const KeyType &low_key, const KeyType &high_key) const -> int {
+  size_t prefix_size =
+      CommonPrefixSize(reinterpret_cast<const char *>(&low_key), reinterpret_cast<const char *>(&high_key), key_size_);
+  // an internal page holds one child more than its max size just before it splits
+  return std::min(size_limit_, Capacity(key_size_, prefix_size) - 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Capacity(size_t key_size, size_t prefix_size) -> int {
+  return static_cast<int>((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (key_size - prefix_size + sizeof(ValueType)));
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -64,7 +174,15 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { ret
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType {
-  return INVALID_PAGE_ID;
+  // keys outside the prefix of the page go to the first or the last child
+  const auto *key_data = reinterpret_cast<const char *>(&key);
+  int cmp = memcmp(key_data, &low_key_, prefix_size_);
+  if (cmp != 0) {
+    return ValueAt(cmp < 0 ? 0 : GetSize() - 1);
+  }
+  // the first key greater than the input key bounds the child to follow from the right
+  return ValueAt(KeySearch::UpperBound(SlotAt(1), SlotWidth(), GetSize() - 1, key_data + prefix_size_,
+                                       key_size_ - prefix_size_));
 }
 
 /*****************************************************************************
@@ -78,7 +196,13 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyCompara
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
-                                                     const ValueType &new_value) {}
+                                                     const ValueType &new_value) {
+  SetKeyAt(0, low_key_);
+  SetValueAt(0, old_value);
+  SetKeyAt(1, new_key);
+  SetValueAt(1, new_value);
+  SetSize(2);
+}
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
  * old_value
@@ -87,7 +211,22 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value,
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
                                                      const ValueType &new_value) -> int {
-  return 0;
+  int index = ValueIndex(old_value) + 1;
+  memmove(SlotAt(index + 1), SlotAt(index), (GetSize() - index) * SlotWidth());
+  SetKeyAt(index, new_key);
+  SetValueAt(index, new_value);
+  IncreaseSize(1);
+  return GetSize();
+}
+
+/*
+ * Append key & value pair at the end, the key is greater than all keys in the page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Append(const KeyType &key, const ValueType &value) {
+  SetKeyAt(GetSize(), key);
+  SetValueAt(GetSize(), value);
+  IncreaseSize(1);
 }
 
 /*****************************************************************************
@@ -95,17 +234,23 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value,
  *****************************************************************************/
 /*
  * Remove half of key & value pairs from this page to "recipient" page
+ * The recipient is the new right sibling of this page. The first key moved splits the range of this page between the
+ * two.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient,
-                                                BufferPoolManager *buffer_pool_manager) {}
-
-/* Copy entries into me, starting from {items} and copy {size} entries.
- * Since it is an internal page, for all entries (pages) moved, their parents page now changes to me.
- * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {}
+                                                BufferPoolManager *buffer_pool_manager) {
+  int keep = (GetSize() + 1) / 2;
+  KeyType separator = KeyAt(keep);
+  recipient->SetFences(separator, high_key_);
+  for (int i = keep; i < GetSize(); i++) {
+    recipient->CopyLastFrom(MappingType(KeyAt(i), ValueAt(i)), buffer_pool_manager);
+  }
+  SetSize(keep);
+  SetFences(low_key_, separator);
+  recipient->SetNextPageId(GetNextPageId());
+  SetNextPageId(recipient->GetPageId());
+}
 
 /*****************************************************************************
  * REMOVE
@@ -116,14 +261,20 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, Buf
  * NOTE: store key&value pair continuously after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  memmove(SlotAt(index), SlotAt(index + 1), (GetSize() - index - 1) * SlotWidth());
+  IncreaseSize(-1);
+}
 
 /*
  * Remove the only key & value pair in internal page and return the value
  * NOTE: only call this method within AdjustRoot()(in b_plus_tree.cpp)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() -> ValueType { return INVALID_PAGE_ID; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() -> ValueType {
+  SetSize(0);
+  return ValueAt(0);
+}
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
@@ -133,10 +284,18 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() -> ValueType { r
  * to make sure the middle key is added to the recipient to maintain the invariant.
  * You also need to use BufferPoolManager to persist changes to the parent page id for those
  * pages that are moved to the recipient
+ * The recipient is the left sibling of this page and takes over its range; the children of both must fit into it.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                               BufferPoolManager *buffer_pool_manager) {}
+                                               BufferPoolManager *buffer_pool_manager) {
+  recipient->SetFences(recipient->GetLowKey(), high_key_);
+  for (int i = 0; i < GetSize(); i++) {
+    recipient->CopyLastFrom(MappingType(i == 0 ? middle_key : KeyAt(i), ValueAt(i)), buffer_pool_manager);
+  }
+  recipient->SetNextPageId(GetNextPageId());
+  SetSize(0);
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
@@ -148,17 +307,28 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient,
  * to make sure the middle key is added to the recipient to maintain the invariant.
  * You also need to use BufferPoolManager to persist changes to the parent page id for those
  * pages that are moved to the recipient
+ * The second key of this page becomes its first and splits the ranges of the two.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                      BufferPoolManager *buffer_pool_manager) {}
+                                                      BufferPoolManager *buffer_pool_manager) {
+  MappingType pair(middle_key, ValueAt(0));
+  Remove(0);
+  KeyType separator = KeyAt(0);
+  recipient->SetFences(recipient->GetLowKey(), separator);
+  recipient->CopyLastFrom(pair, buffer_pool_manager);
+  SetFences(separator, high_key_);
+}
 
 /* Append an entry at the end.
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
+  Append(pair.first, pair.second);
+  Adopt(pair.second, buffer_pool_manager);
+}
 
 /*
  * Remove the last key & value pair from this page to head of "recipient" page.
@@ -166,17 +336,45 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, Buffe
  * right place.
  * You also need to use BufferPoolManager to persist changes to the parent page id for those pages that are
  * moved to the recipient
+ * The last key of this page splits the ranges of the two.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                       BufferPoolManager *buffer_pool_manager) {}
+                                                       BufferPoolManager *buffer_pool_manager) {
+  MappingType pair(KeyAt(GetSize() - 1), ValueAt(GetSize() - 1));
+  IncreaseSize(-1);
+  recipient->SetFences(pair.first, recipient->GetHighKey());
+  recipient->SetKeyAt(0, middle_key);
+  recipient->CopyFirstFrom(pair, buffer_pool_manager);
+  SetFences(low_key_, pair.first);
+}
 
 /* Append an entry at the beginning.
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
+  memmove(SlotAt(1), SlotAt(0), GetSize() * SlotWidth());
+  SetKeyAt(0, pair.first);
+  SetValueAt(0, pair.second);
+  IncreaseSize(1);
+  Adopt(pair.second, buffer_pool_manager);
+}
+
+/*
+ * Make me the parent of a child page that moved here.
+ * The child is not latched, a parent page id is only used by writers that hold the write latch of the parent.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Adopt(page_id_t child_page_id, BufferPoolManager *buffer_pool_manager) {
+  Page *page = buffer_pool_manager->FetchPage(child_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a child page of a B+ tree internal page");
+  }
+  reinterpret_cast<BPlusTreePage *>(page->GetData())->SetParentPageId(GetPageId());
+  buffer_pool_manager->UnpinPage(child_page_id, true);
+}
 
 // valuetype for internalNode should be page id_t
 template class BPlusTreeInternalPage<GenericKey<4>, page_id_t, GenericComparator<4>>;
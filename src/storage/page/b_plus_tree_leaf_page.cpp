@@ -9,10 +9,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 #include "common/exception.h"
 #include "common/rid.h"
+#include "storage/index/key_search.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -24,27 +27,103 @@ namespace bustub {
 /**
  * Init method after creating a new leaf page
  * Including set page type, set current size to zero, set page id/parent id, set
- * next page id and set max size
+ * next/prev page id and set max size
+ * The page covers all keys, from all zero bytes to all one bytes.
+ * @param max_size limit to the max size, which is lower if the slots do not fit as many pairs
+ * @param key_size number of leading bytes of a key that decide its order
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size, size_t key_size) {
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetPrevPageId(INVALID_PAGE_ID);
+  SetLSN();
+  size_limit_ = max_size;
+  key_size_ = static_cast<uint16_t>(std::min(key_size, sizeof(KeyType)));
+  KeyType low_key;
+  KeyType high_key;
+  memset(&low_key, 0, sizeof(KeyType));
+  memset(&high_key, 0, sizeof(KeyType));
+  memset(&high_key, 0xFF, key_size_);
+  SetFences(low_key, high_key);
+  // the prefix of any range is at least as long as that of the full range
+  SetMinSize(GetMaxSize() / 2);
+}
 
 /**
  * Helper methods to set/get next page id
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const -> page_id_t { return INVALID_PAGE_ID; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+/**
+ * Helper methods to set/get prev page id
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetPrevPageId() const -> page_id_t { return prev_page_id_; }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetPrevPageId(page_id_t prev_page_id) { prev_page_id_ = prev_page_id; }
+
+/**
+ * Helper methods to get/set the key range of the page
+ * Setting it lays the slots out again for the prefix of the new range, and resizes the page to match.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetLowKey() const -> const KeyType & { return low_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetHighKey() const -> const KeyType & { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetFences(const KeyType &low_key, const KeyType &high_key) {
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    items.push_back(GetItem(i));
+  }
+  assert(GetSize() <= MaxSizeFor(low_key, high_key));
+  SetMaxSize(MaxSizeFor(low_key, high_key));
+  low_key_ = low_key;
+  high_key_ = high_key;
+  prefix_size_ = static_cast<uint16_t>(CommonPrefixSize(reinterpret_cast<const char *>(&low_key_),
+                                                        reinterpret_cast<const char *>(&high_key_), key_size_));
+  for (int i = 0; i < GetSize(); i++) {
+    SetItem(i, items[i].first, items[i].second);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::MaxSizeFor(const KeyType &low_key, const KeyType &high_key) const -> int {
+  size_t prefix_size =
+      CommonPrefixSize(reinterpret_cast<const char *>(&low_key), reinterpret_cast<const char *>(&high_key), key_size_);
+  return std::min(size_limit_, Capacity(key_size_, prefix_size));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::Capacity(size_t key_size, size_t prefix_size) -> int {
+  return static_cast<int>((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (key_size - prefix_size + sizeof(ValueType)));
+}
 
 /**
  * Helper method to find the first index i so that array[i].first >= key
  * NOTE: This method is only used when generating index iterator
+ * Keys outside the prefix of the page are before or after all of its keys; the others only compare their slots.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int {
-  return 0;
+  const auto *key_data = reinterpret_cast<const char *>(&key);
+  int cmp = memcmp(key_data, &low_key_, prefix_size_);
+  if (cmp != 0) {
+    return cmp < 0 ? 0 : GetSize();
+  }
+  return KeySearch::LowerBound(slots_, SlotWidth(), GetSize(), key_data + prefix_size_, key_size_ - prefix_size_);
 }
 
 /*
@@ -53,19 +132,52 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparato
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  KeyType key{};
+  KeyType key;
+  auto *key_data = reinterpret_cast<char *>(&key);
+  memcpy(key_data, &low_key_, prefix_size_);
+  memcpy(key_data + prefix_size_, SlotAt(index), key_size_ - prefix_size_);
+  memset(key_data + key_size_, 0, sizeof(KeyType) - key_size_);
   return key;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType {
+  ValueType value;
+  memcpy(&value, SlotAt(index) + key_size_ - prefix_size_, sizeof(ValueType));
+  return value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  memcpy(SlotAt(index) + key_size_ - prefix_size_, &value, sizeof(ValueType));
+}
+
 /*
  * Helper method to find and return the key & value pair associated with input
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) -> const MappingType & {
-  // replace with your own code
-  return array_[0];
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const -> MappingType {
+  return MappingType(KeyAt(index), ValueAt(index));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::SlotWidth() const -> size_t { return key_size_ - prefix_size_ + sizeof(ValueType); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::SlotAt(int index) -> char * { return slots_ + index * SlotWidth(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::SlotAt(int index) const -> const char * { return slots_ + index * SlotWidth(); }
+
+/*
+ * Store a pair in a slot, the key must share the prefix of the page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetItem(int index, const KeyType &key, const ValueType &value) {
+  char *slot = SlotAt(index);
+  memcpy(slot, reinterpret_cast<const char *>(&key) + prefix_size_, key_size_ - prefix_size_);
+  memcpy(slot + key_size_ - prefix_size_, &value, sizeof(ValueType));
 }
 
 /*****************************************************************************
@@ -73,28 +185,52 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) -> const MappingType & {
  *****************************************************************************/
 /*
  * Insert key & value pair into leaf page ordered by key
+ * A duplicate key is not inserted and leaves the page unchanged
  * @return  page size after insertion
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator)
     -> int {
-  return 0;
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && comparator(KeyAt(index), key) == 0) {
+    return GetSize();
+  }
+  memmove(SlotAt(index + 1), SlotAt(index), (GetSize() - index) * SlotWidth());
+  SetItem(index, key, value);
+  IncreaseSize(1);
+  return GetSize();
 }
 
-/*****************************************************************************
- * SPLIT
- *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Append key & value pair at the end, the key is greater than all keys in the page
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Append(const KeyType &key, const ValueType &value) {
+  CopyLastFrom(MappingType(key, value));
+}
 
+/*****************************************************************************
+ * SPLIT
+ *****************************************************************************/
 /*
- * Copy starting from items, and copy {size} number of elements into me.
+ * Remove half of key & value pairs from this page to "recipient" page
+ * The recipient is the new right sibling of this page and takes its place in the leaf chain. Its first key splits the
+ * range of this page between the two. The caller links the page after the recipient back to it.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
+  int keep = (GetSize() + 1) / 2;
+  KeyType separator = KeyAt(keep);
+  recipient->SetFences(separator, high_key_);
+  for (int i = keep; i < GetSize(); i++) {
+    recipient->CopyLastFrom(GetItem(i));
+  }
+  SetSize(keep);
+  SetFences(low_key_, separator);
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetPrevPageId(GetPageId());
+  SetNextPageId(recipient->GetPageId());
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -107,7 +243,12 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {}
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const
     -> bool {
-  return false;
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(KeyAt(index), key) != 0) {
+    return false;
+  }
+  *value = ValueAt(index);
+  return true;
 }
 
 /*****************************************************************************
@@ -121,7 +262,13 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, co
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) -> int {
-  return 0;
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(KeyAt(index), key) != 0) {
+    return GetSize();
+  }
+  memmove(SlotAt(index), SlotAt(index + 1), (GetSize() - index - 1) * SlotWidth());
+  IncreaseSize(-1);
+  return GetSize();
 }
 
 /*****************************************************************************
@@ -130,36 +277,69 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const
 /*
  * Remove all of key & value pairs from this page to "recipient" page. Don't forget
  * to update the next_page id in the sibling page
+ * This page keeps its own next and prev page ids, so that an iterator still holding it moves on past the merged pair.
+ * The caller links the page after this one back to the recipient.
+ * The recipient is the left sibling of this page and takes over its range; the pairs of both must fit into it.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
+  recipient->SetFences(recipient->GetLowKey(), high_key_);
+  for (int i = 0; i < GetSize(); i++) {
+    recipient->CopyLastFrom(GetItem(i));
+  }
+  recipient->SetNextPageId(GetNextPageId());
+  SetSize(0);
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
  *****************************************************************************/
 /*
  * Remove the first key & value pair from this page to "recipient" page.
+ * The recipient is the left sibling of this page, the new first key of this page splits their ranges.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
+  MappingType item = GetItem(0);
+  memmove(SlotAt(0), SlotAt(1), (GetSize() - 1) * SlotWidth());
+  IncreaseSize(-1);
+  KeyType separator = KeyAt(0);
+  recipient->SetFences(recipient->GetLowKey(), separator);
+  recipient->CopyLastFrom(item);
+  SetFences(separator, high_key_);
+}
 
 /*
  * Copy the item into the end of my item list. (Append item to my array)
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
+  SetItem(GetSize(), item.first, item.second);
+  IncreaseSize(1);
+}
 
 /*
  * Remove the last key & value pair from this page to "recipient" page.
+ * The recipient is the right sibling of this page, the moved key splits their ranges.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
+  MappingType item = GetItem(GetSize() - 1);
+  IncreaseSize(-1);
+  recipient->SetFences(item.first, recipient->GetHighKey());
+  recipient->CopyFirstFrom(item);
+  SetFences(low_key_, item.first);
+}
 
 /*
  * Insert item at the front of my items. Move items accordingly.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {
+  memmove(SlotAt(1), SlotAt(0), GetSize() * SlotWidth());
+  SetItem(0, item.first, item.second);
+  IncreaseSize(1);
+}
 
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_overflow_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_overflow_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/b_plus_tree_overflow_page.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace bustub {
+
+void BPlusTreeOverflowPage::Init() {
+  next_page_id_ = INVALID_PAGE_ID;
+  tail_page_id_ = INVALID_PAGE_ID;
+  length_ = 0;
+  padding_ = 0;
+  last_rid_ = 0;
+}
+
+auto BPlusTreeOverflowPage::GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+void BPlusTreeOverflowPage::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+auto BPlusTreeOverflowPage::GetTailPageId() const -> page_id_t { return tail_page_id_; }
+
+void BPlusTreeOverflowPage::SetTailPageId(page_id_t tail_page_id) { tail_page_id_ = tail_page_id; }
+
+auto BPlusTreeOverflowPage::GetRun() const -> const char * { return run_; }
+
+auto BPlusTreeOverflowPage::GetLength() const -> size_t { return length_; }
+
+auto BPlusTreeOverflowPage::GetLastRid() const -> int64_t { return last_rid_; }
+
+void BPlusTreeOverflowPage::SetRun(const char *data, size_t length, int64_t last_rid) {
+  assert(length <= OVERFLOW_PAGE_CAPACITY);
+  memcpy(run_, data, length);
+  length_ = static_cast<uint32_t>(length);
+  last_rid_ = last_rid;
+}
+
+}  // namespace bustub
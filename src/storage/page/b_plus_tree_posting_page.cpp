@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_posting_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_posting_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/b_plus_tree_posting_page.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t POSTING_PAGE_HEADER_SIZE = 4 * sizeof(uint16_t);
+
+}  // namespace
+
+void BPlusTreePostingPage::Init() {
+  slot_count_ = 0;
+  live_count_ = 0;
+  free_space_pointer_ = PAGE_SIZE;
+  live_length_ = 0;
+}
+
+auto BPlusTreePostingPage::GetLength(int slot) const -> size_t { return slots_[slot].length_; }
+
+auto BPlusTreePostingPage::GetList(int slot) const -> const char * {
+  return reinterpret_cast<const char *>(this) + slots_[slot].offset_;
+}
+
+auto BPlusTreePostingPage::IsEmpty() const -> bool { return live_count_ == 0; }
+
+auto BPlusTreePostingPage::Insert(const char *data, size_t length) -> int {
+  assert(length > 0);
+  int slot = 0;
+  while (slot < slot_count_ && slots_[slot].length_ != 0) {
+    slot++;
+  }
+  size_t slot_length = slot == slot_count_ ? sizeof(Slot) : 0;
+  if (FreeSpace() < length + slot_length) {
+    return -1;
+  }
+  if (ContiguousFreeSpace() < length + slot_length) {
+    Compact();
+  }
+  if (slot == slot_count_) {
+    slot_count_++;
+  }
+  free_space_pointer_ -= length;
+  memcpy(reinterpret_cast<char *>(this) + free_space_pointer_, data, length);
+  slots_[slot] = Slot{free_space_pointer_, static_cast<uint16_t>(length)};
+  live_count_++;
+  live_length_ += length;
+  return slot;
+}
+
+auto BPlusTreePostingPage::Update(int slot, const char *data, size_t length) -> bool {
+  assert(length > 0 && slots_[slot].length_ != 0);
+  Slot &entry = slots_[slot];
+  // a shorter list is written over the old one, the rest of which is reclaimed by the next compaction
+  if (length <= entry.length_) {
+    memcpy(reinterpret_cast<char *>(this) + entry.offset_, data, length);
+    live_length_ -= entry.length_ - length;
+    entry.length_ = static_cast<uint16_t>(length);
+    return true;
+  }
+  if (FreeSpace() + entry.length_ < length) {
+    return false;
+  }
+  live_length_ -= entry.length_;
+  entry.length_ = 0;
+  if (ContiguousFreeSpace() < length) {
+    Compact();
+  }
+  free_space_pointer_ -= length;
+  memcpy(reinterpret_cast<char *>(this) + free_space_pointer_, data, length);
+  slots_[slot] = Slot{free_space_pointer_, static_cast<uint16_t>(length)};
+  live_length_ += length;
+  return true;
+}
+
+void BPlusTreePostingPage::Remove(int slot) {
+  assert(slots_[slot].length_ != 0);
+  live_length_ -= slots_[slot].length_;
+  slots_[slot].length_ = 0;
+  live_count_--;
+  while (slot_count_ > 0 && slots_[slot_count_ - 1].length_ == 0) {
+    slot_count_--;
+  }
+  if (live_count_ == 0) {
+    free_space_pointer_ = PAGE_SIZE;
+  }
+}
+
+auto BPlusTreePostingPage::ContiguousFreeSpace() const -> size_t {
+  return free_space_pointer_ - POSTING_PAGE_HEADER_SIZE - slot_count_ * sizeof(Slot);
+}
+
+auto BPlusTreePostingPage::FreeSpace() const -> size_t {
+  return PAGE_SIZE - POSTING_PAGE_HEADER_SIZE - slot_count_ * sizeof(Slot) - live_length_;
+}
+
+void BPlusTreePostingPage::Compact() {
+  char lists[PAGE_SIZE];
+  auto *page = reinterpret_cast<char *>(this);
+  size_t end = PAGE_SIZE;
+  for (int slot = 0; slot < slot_count_; slot++) {
+    if (slots_[slot].length_ != 0) {
+      end -= slots_[slot].length_;
+      memcpy(lists + end, page + slots_[slot].offset_, slots_[slot].length_);
+      slots_[slot].offset_ = static_cast<uint16_t>(end);
+    }
+  }
+  memcpy(page + end, lists + end, PAGE_SIZE - end);
+  free_space_pointer_ = static_cast<uint16_t>(end);
+}
+
+}  // namespace bustub
@@ -140,4 +140,6 @@ void HashTableDirectoryPage::PrintDirectory() {
   LOG_DEBUG("================ END DIRECTORY ================");
 }
 
+static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE, "the directory does not fit into a page");
+
 }  // namespace bustub
@@ -0,0 +1,476 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager_bench_test.cpp
+//
+// Identification: test/buffer/buffer_pool_manager_bench_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Benchmarks are disabled by default, run them with
+//   ./test/buffer_pool_manager_bench_test --gtest_also_run_disabled_tests
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "buffer/read_ahead.h"
+#include "catalog/schema.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+namespace {
+
+const size_t bench_pool_size = 64;
+const size_t bench_ops_per_thread = 50000;
+const size_t bench_scan_pages = 4096;
+const size_t bench_flush_instances = 8;
+const size_t bench_skew_instances = 8;
+const size_t bench_skew_pages = 8192;
+const size_t bench_flush_pool_size = 4096;
+/** The page size benchmark keeps the size of the table fixed, whatever the page size. */
+const size_t bench_page_size_table_bytes = 64 << 20;
+const size_t bench_page_size_lookups = 2000;
+
+/**
+ * Every thread fetches a random page out of the first num_pages pages and unpins it again.
+ * @return the number of fetch/unpin pairs per second over all threads
+ */
+auto RunFetchBench(BufferPoolManager *bpm, size_t num_pages, size_t num_threads, size_t *fetched) -> double {
+  std::vector<std::thread> threads;
+  std::vector<size_t> ok(num_threads, 0);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, num_pages, tid, &ok] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<page_id_t> dist(0, static_cast<page_id_t>(num_pages) - 1);
+      for (size_t i = 0; i < bench_ops_per_thread; i++) {
+        page_id_t page_id = dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        ok[tid]++;
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  *fetched = 0;
+  for (auto n : ok) {
+    *fetched += n;
+  }
+  return static_cast<double>(*fetched) / elapsed.count();
+}
+
+/** Draws ranks 0..n-1 with a Zipf distribution, rank 0 being the hottest. */
+class ZipfGenerator {
+ public:
+  ZipfGenerator(size_t n, double theta) : cdf_(n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+      cdf_[i] = sum;
+    }
+    for (auto &c : cdf_) {
+      c /= sum;
+    }
+  }
+
+  auto Next(std::mt19937 *rng) -> size_t {
+    double u = std::uniform_real_distribution<double>(0, 1)(*rng);
+    return std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+  }
+
+ private:
+  std::vector<double> cdf_;
+};
+
+/** @return the busiest instance's share of the load relative to a perfectly even split */
+auto LoadImbalance(const std::vector<uint64_t> &load) -> double {
+  uint64_t total = 0;
+  uint64_t max = 0;
+  for (auto n : load) {
+    total += n;
+    max = std::max(max, n);
+  }
+  return total == 0 ? 0 : static_cast<double>(max) * load.size() / total;
+}
+
+/** Write back the database file and drop it from the OS page cache, so that the next scan reads from the device. */
+void DropFromPageCache(const std::string &db_name) {
+  int fd = open(db_name.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+/**
+ * Walk the next-page chain of a table heap.
+ * @param read_ahead whether to prefetch ahead of the walk, otherwise every page is a blocking fetch
+ * @return the number of pages visited
+ */
+auto WalkChain(BufferPoolManager *bpm, page_id_t first_page_id, bool read_ahead) -> size_t {
+  ReadAhead prefetcher(read_ahead ? bpm : nullptr);
+  size_t pages = 0;
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID; pages++) {
+    auto *page = reinterpret_cast<TablePage *>(bpm->FetchPage(page_id));
+    page_id_t next_page_id = page->GetNextPageId();
+    prefetcher.OnPage(page_id, next_page_id);
+    bpm->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return pages;
+}
+
+/**
+ * Build a chain of table pages. TableHeap::InsertTuple walks the chain from its start for every tuple, so the chain
+ * is built here directly.
+ * @param num_pages length of the chain
+ * @param make_tuple returns the i-th tuple to insert
+ * @return the id of the first page
+ */
+template <typename MakeTuple>
+auto BuildTableChain(BufferPoolManager *bpm, Transaction *txn, size_t num_pages, MakeTuple &&make_tuple) -> page_id_t {
+  page_id_t first_page_id = INVALID_PAGE_ID;
+  TablePage *prev_page = nullptr;
+  size_t num_tuples = 0;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = reinterpret_cast<TablePage *>(bpm->NewPage(&page_id));
+    EXPECT_NE(nullptr, page);
+    page->Init(page_id, PAGE_SIZE, prev_page == nullptr ? INVALID_PAGE_ID : prev_page->GetTablePageId(), nullptr, txn);
+    RID rid;
+    while (page->InsertTuple(make_tuple(num_tuples), &rid, txn, nullptr, nullptr)) {
+      num_tuples++;
+    }
+    if (prev_page == nullptr) {
+      first_page_id = page_id;
+    } else {
+      prev_page->SetNextPageId(page_id);
+      bpm->UnpinPage(prev_page->GetTablePageId(), true);
+    }
+    prev_page = page;
+  }
+  bpm->UnpinPage(prev_page->GetTablePageId(), true);
+  return first_page_id;
+}
+
+/** Customer-like rows: a key, a few low-cardinality columns and a comment drawn from a small vocabulary. */
+class CustomerRows {
+ public:
+  auto Make(size_t i) -> Tuple {
+    std::string comment;
+    for (int w = 0; w < 5; w++) {
+      comment += words_[rng_() % words_.size()] + " ";
+    }
+    return Tuple({Value(TypeId::INTEGER, static_cast<int32_t>(i)),
+                  Value(TypeId::VARCHAR, "Customer#" + std::to_string(100000 + i)),
+                  Value(TypeId::VARCHAR, segments_[rng_() % segments_.size()]),
+                  Value(TypeId::INTEGER, static_cast<int32_t>(rng_() % 10000)), Value(TypeId::VARCHAR, comment)},
+                 &schema_);
+  }
+
+ private:
+  Schema schema_{{Column("id", TypeId::INTEGER), Column("name", TypeId::VARCHAR, 32),
+                  Column("segment", TypeId::VARCHAR, 16), Column("balance", TypeId::INTEGER),
+                  Column("comment", TypeId::VARCHAR, 64)}};
+  std::vector<std::string> segments_{"AUTOMOBILE", "BUILDING", "FURNITURE", "HOUSEHOLD", "MACHINERY"};
+  std::vector<std::string> words_{"carefully", "final", "deposits", "sleep", "quickly", "regular", "ideas"};
+  std::mt19937 rng_{0};
+};
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchTest, DISABLED_FetchThroughputTest) {
+  const std::string db_name = "bench.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(bench_pool_size, disk_manager);
+
+  // Lay out four pools worth of pages on disk.
+  page_id_t page_id;
+  for (size_t i = 0; i < bench_pool_size * 4; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    snprintf(bpm->FetchPage(page_id)->GetData(), PAGE_SIZE, "page %d", page_id);
+    bpm->UnpinPage(page_id, true);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // The hot workload fits into the pool and is served by the latch-free hit path, the cold one mostly misses and
+  // goes through the latched replacement path.
+  std::printf("%8s %16s %16s\n", "threads", "hit path op/s", "miss path op/s");
+  for (size_t num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    size_t fetched;
+    double hot = RunFetchBench(bpm, bench_pool_size / 2, num_threads, &fetched);
+    EXPECT_EQ(num_threads * bench_ops_per_thread, fetched);
+    double cold = RunFetchBench(bpm, bench_pool_size * 4, num_threads, &fetched);
+    std::printf("%8zu %16.0f %16.0f\n", num_threads, hot, cold);
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchTest, DISABLED_SequentialScanTest) {
+  const std::string db_name = "bench.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(bench_pool_size, disk_manager);
+  auto *txn = new Transaction(0);
+
+  // A chain of table pages holding a few large tuples each.
+  Schema schema({Column("a", TypeId::VARCHAR, PAGE_SIZE / 2)});
+  page_id_t first_page_id = BuildTableChain(bpm, txn, bench_scan_pages, [&schema](size_t) {
+    return Tuple({Value(TypeId::VARCHAR, std::string(PAGE_SIZE / 5, 'x'))}, &schema);
+  });
+  auto *table = new TableHeap(bpm, nullptr, nullptr, first_page_id);
+  bpm->FlushAllPages();
+
+  // Cold scans: the table is far larger than the pool, and the file is dropped from the OS cache before each scan.
+  std::printf("%24s %12s\n", "scan", "MiB/s");
+  size_t pages = 0;
+  for (bool read_ahead : {false, true}) {
+    DropFromPageCache(db_name);
+    auto start = std::chrono::steady_clock::now();
+    pages = WalkChain(bpm, table->GetFirstPageId(), read_ahead);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(bench_scan_pages, pages);
+    std::printf("%24s %12.1f\n", read_ahead ? "chain with read-ahead" : "chain page at a time",
+                pages * PAGE_SIZE / elapsed.count() / (1 << 20));
+  }
+
+  DropFromPageCache(db_name);
+  auto start = std::chrono::steady_clock::now();
+  size_t tuples = 0;
+  for (auto it = table->Begin(txn); it != table->End(); ++it) {
+    tuples++;
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_LT(pages, tuples);
+  std::printf("%24s %12.1f\n", "TableIterator read-ahead", pages * PAGE_SIZE / elapsed.count() / (1 << 20));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete table;
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchTest, DISABLED_FlushAllTest) {
+  const std::string db_name = "bench.db";
+  const size_t num_pages = bench_flush_instances * bench_flush_pool_size;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(bench_flush_instances, bench_flush_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    page_ids.push_back(page_id);
+  }
+  auto dirty_all = [bpm, &page_ids] {
+    for (auto page_id : page_ids) {
+      bpm->UnpinPage(page_id, true);
+    }
+    for (auto page_id : page_ids) {
+      bpm->FetchPage(page_id);
+    }
+  };
+
+  // Page-at-a-time writes in random order, like the old hash map walk, against the sorted and coalesced checkpoint.
+  std::printf("%24s %12s\n", "flush", "MiB/s");
+  std::shuffle(page_ids.begin(), page_ids.end(), std::mt19937(0));
+  dirty_all();
+  auto start = std::chrono::steady_clock::now();
+  for (auto page_id : page_ids) {
+    bpm->FlushPage(page_id);
+  }
+  disk_manager->Sync();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::printf("%24s %12.1f\n", "page at a time", num_pages * PAGE_SIZE / elapsed.count() / (1 << 20));
+
+  dirty_all();
+  start = std::chrono::steady_clock::now();
+  bpm->FlushAllPages();
+  elapsed = std::chrono::steady_clock::now() - start;
+  std::printf("%24s %12.1f\n", "FlushAllPages", num_pages * PAGE_SIZE / elapsed.count() / (1 << 20));
+
+  for (auto page_id : page_ids) {
+    bpm->UnpinPage(page_id, false);
+  }
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchTest, DISABLED_SkewedLoadBalanceTest) {
+  const std::string db_name = "bench.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(bench_skew_instances, bench_pool_size, disk_manager);
+
+  for (size_t i = 0; i < bench_skew_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // Zipf distributed accesses whose hottest pages are all equal modulo the number of instances, e.g. the root and
+  // inner pages of indexes that were created in lock step.
+  const size_t stride = bench_skew_pages / bench_skew_instances;
+  std::vector<uint64_t> modulo_load(bench_skew_instances, 0);
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < 8; tid++) {
+    threads.emplace_back([bpm, tid, stride] {
+      std::mt19937 rng(tid);
+      ZipfGenerator zipf(bench_skew_pages, 0.99);
+      for (size_t i = 0; i < bench_ops_per_thread; i++) {
+        size_t rank = zipf.Next(&rng);
+        auto page_id = static_cast<page_id_t>((rank % stride) * bench_skew_instances + rank / stride);
+        if (bpm->FetchPage(page_id) != nullptr) {
+          bpm->UnpinPage(page_id, false);
+        }
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  // the same trace, routed by page_id % num_instances
+  for (size_t tid = 0; tid < 8; tid++) {
+    std::mt19937 rng(tid);
+    ZipfGenerator zipf(bench_skew_pages, 0.99);
+    for (size_t i = 0; i < bench_ops_per_thread; i++) {
+      size_t rank = zipf.Next(&rng);
+      modulo_load[(rank % stride * bench_skew_instances + rank / stride) % bench_skew_instances]++;
+    }
+  }
+
+  std::vector<uint64_t> load(bench_skew_instances, 0);
+  std::printf("%8s %12s %12s %12s\n", "instance", "fetches", "hit ratio", "modulo");
+  for (size_t i = 0; i < bench_skew_instances; i++) {
+    auto stats = bpm->GetInstanceStats(i);
+    load[i] = stats.hits_ + stats.misses_;
+    std::printf("%8zu %12lu %12.3f %12lu\n", i, load[i], stats.HitRatio(), modulo_load[i]);
+  }
+  std::printf("max / mean load: %.2f, with modulo routing: %.2f\n", LoadImbalance(load), LoadImbalance(modulo_load));
+  std::printf("%s", bpm->GetStats().ToString().c_str());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchTest, DISABLED_CompressedScanTest) {
+  const std::string db_name = "bench.db";
+  std::printf("%12s %12s %12s %12s\n", "pages", "file MiB", "read MiB", "scan MiB/s");
+  for (bool compress : {false, true}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name, false, compress);
+    auto *bpm = new BufferPoolManagerInstance(bench_pool_size, disk_manager);
+    auto *txn = new Transaction(0);
+    CustomerRows rows;
+    page_id_t first_page_id =
+        BuildTableChain(bpm, txn, bench_scan_pages, [&rows](size_t i) { return rows.Make(i); });
+    bpm->FlushAllPages();
+    disk_manager->Sync();
+
+    DropFromPageCache(db_name);
+    auto bytes_before = disk_manager->GetStats().bytes_read_;
+    auto start = std::chrono::steady_clock::now();
+    size_t pages = WalkChain(bpm, first_page_id, true);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(bench_scan_pages, pages);
+    struct stat file_stat;
+    stat(db_name.c_str(), &file_stat);
+    std::printf("%12s %12.1f %12.1f %12.1f\n", compress ? "compressed" : "raw",
+                static_cast<double>(file_stat.st_size) / (1 << 20),
+                static_cast<double>(disk_manager->GetStats().bytes_read_ - bytes_before) / (1 << 20),
+                pages * PAGE_SIZE / elapsed.count() / (1 << 20));
+
+    disk_manager->ShutDown();
+    delete txn;
+    delete bpm;
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+  remove("bench.pmap");
+}
+
+// NOLINTNEXTLINE
+// The page size is fixed at build time, build_support/bench_page_sizes.sh runs this with every supported page size
+TEST(BufferPoolManagerBenchTest, DISABLED_PageSizeTest) {
+  const std::string db_name = "bench.db";
+  const size_t num_pages = bench_page_size_table_bytes / PAGE_SIZE;
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(bench_pool_size, disk_manager);
+  auto *txn = new Transaction(0);
+  CustomerRows rows;
+  page_id_t first_page_id = BuildTableChain(bpm, txn, num_pages, [&rows](size_t i) { return rows.Make(i); });
+  bpm->FlushAllPages();
+
+  // Cold scan: fewer, larger reads with larger pages.
+  DropFromPageCache(db_name);
+  auto reads_before = disk_manager->GetStats().read_latency_.count_;
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(num_pages, WalkChain(bpm, first_page_id, false));
+  std::chrono::duration<double> scan_elapsed = std::chrono::steady_clock::now() - start;
+  auto scan_reads = disk_manager->GetStats().read_latency_.count_ - reads_before;
+
+  // Cold point lookups: every lookup reads a whole page, whatever the size of the tuple it is after.
+  DropFromPageCache(db_name);
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<page_id_t> dist(first_page_id, first_page_id + static_cast<page_id_t>(num_pages) - 1);
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < bench_page_size_lookups; i++) {
+    page_id_t page_id = dist(rng);
+    auto *page = reinterpret_cast<TablePage *>(bpm->FetchPage(page_id));
+    ASSERT_NE(nullptr, page);
+    Tuple tuple;
+    EXPECT_TRUE(page->GetTuple(RID(page_id, 0), &tuple, txn, nullptr));
+    bpm->UnpinPage(page_id, false);
+  }
+  std::chrono::duration<double> lookup_elapsed = std::chrono::steady_clock::now() - start;
+
+  std::printf("%10s %10s %12s %12s %14s\n", "page size", "pages", "scan reads", "scan MiB/s", "lookups/s");
+  std::printf("%10d %10zu %12zu %12.1f %14.1f\n", PAGE_SIZE, num_pages, static_cast<size_t>(scan_reads),
+              bench_page_size_table_bytes / scan_elapsed.count() / (1 << 20),
+              bench_page_size_lookups / lookup_elapsed.count());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete txn;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -11,9 +11,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <algorithm>
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -141,4 +144,415 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Buffer hits pin pages without the instance latch, while misses keep evicting frames underneath them
+TEST(BufferPoolManagerInstanceTest, ConcurrentFetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 40;
+  const int num_threads = 8;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid] {
+      std::default_random_engine rng(tid);
+      // even threads hammer a hot set of three pages, odd threads sweep over all pages
+      std::uniform_int_distribution<page_id_t> dist(0, tid % 2 == 0 ? 2 : num_pages - 1);
+      for (int i = 0; i < 2000; ++i) {
+        page_id_t page_id = dist(rng);
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_EQ(page_id, std::stoi(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: every pin was dropped again, so the whole pool can be handed out to new pages.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// The page cleaner writes dirty eviction candidates ahead of time, so that evicting them costs no foreground write
+TEST(BufferPoolManagerInstanceTest, PageCleanerTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+  }
+  // Scenario: only unpinned dirty pages are cleaned.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  EXPECT_EQ(5, bpm->CleanPages(buffer_pool_size));
+  EXPECT_EQ(0, bpm->CleanPages(buffer_pool_size));
+  EXPECT_EQ(5, bpm->GetCleanerFlushCount());
+
+  // Scenario: evicting the cleaned pages needs no synchronous write, and their content survives.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(0, bpm->GetSyncFlushCount());
+  for (int i = 5; i < 15; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  for (int i = 0; i < 5; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, std::stoi(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(5, bpm->GetSyncFlushCount());
+
+  // Scenario: the background cleaner keeps the cold end of the replacer clean.
+  bpm->StartPageCleaner(buffer_pool_size, buffer_pool_size, std::chrono::milliseconds(1));
+  for (int i = 0; i < 5; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  for (int retry = 0; retry < 1000 && bpm->GetCleanerFlushCount() < 10; ++retry) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  bpm->StopPageCleaner();
+  EXPECT_LE(10, bpm->GetCleanerFlushCount());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Prefetched pages are read in without a pin and found resident by later fetches
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto resident = [bpm](page_id_t page_id) {
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      if (bpm->GetPages()[i].GetPageId() == page_id) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * 2; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_FALSE(resident(0));
+
+  // Scenario: a quarter of the pool may be prefetching at a time, and pages that were never allocated are skipped.
+  bpm->PrefetchPages({100, 0, 1, 2, 3});
+  EXPECT_FALSE(resident(100));
+  EXPECT_TRUE(resident(0));
+  EXPECT_TRUE(resident(1));
+  EXPECT_FALSE(resident(2));
+
+  // Scenario: fetching a prefetched page returns its content and it can be unpinned and deleted like any other.
+  for (page_id_t page_id = 0; page_id < 4; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(true, bpm->DeletePage(1));
+
+  // Scenario: a prefetched page nobody fetches gets back to the replacer once its read is done.
+  bpm->PrefetchPages({4, 5});
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// A scan through a buffer ring recycles the ring's frames instead of evicting the working set
+TEST(BufferPoolManagerInstanceTest, BufferRingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto resident = [bpm](page_id_t page_id) {
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      if (bpm->GetPages()[i].GetPageId() == page_id) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Scenario: a bulk load through a ring writes back the pages it recycles.
+  BufferRing ring(2);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * 3; ++i) {
+    auto *page = bpm->NewPageInRing(&page_id_temp, &ring);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_TRUE(resident(29));
+  EXPECT_FALSE(resident(27));
+
+  // Scenario: the working set stays resident while a scan goes through the ring.
+  for (page_id_t page_id = 0; page_id < 5; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  BufferRing scan_ring(2);
+  for (page_id_t page_id = 5; page_id < 25; ++page_id) {
+    auto *page = bpm->FetchPageInRing(page_id, &scan_ring);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  for (page_id_t page_id = 0; page_id < 5; ++page_id) {
+    EXPECT_TRUE(resident(page_id));
+  }
+  EXPECT_TRUE(resident(24));
+  EXPECT_FALSE(resident(22));
+
+  // Scenario: a ring frame somebody else pinned is not recycled.
+  auto *pinned = bpm->FetchPage(24);
+  ASSERT_NE(nullptr, pinned);
+  for (page_id_t page_id = 5; page_id < 10; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPageInRing(page_id, &scan_ring));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_TRUE(resident(24));
+  EXPECT_EQ(24, std::stoi(pinned->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(24, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// With O_DIRECT every miss reads from the file, the frames are aligned so no bounce buffer is needed
+TEST(BufferPoolManagerInstanceTest, DirectIOTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name, true);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(bpm->GetPages()[i].GetData()) % DiskManager::DIRECT_IO_ALIGNMENT);
+  }
+
+  // Scenario: pages written back on eviction and on flush read back intact.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * 4; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->FlushAllPages();
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size * 4); ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// The counters follow hits, misses, evictions and failures
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: filling the pool evicts nothing, one more NewPage fails.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.new_page_failures_);
+  EXPECT_EQ(0, stats.evictions_);
+  EXPECT_EQ(buffer_pool_size + 1, stats.latch_wait_.count_);
+
+  // Scenario: two new pages evict pages 0 (dirty) and 1 (clean).
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+  EXPECT_EQ(true, bpm->UnpinPage(1, false));
+  EXPECT_EQ(true, bpm->UnpinPage(2, true));
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(1, stats.dirty_evictions_);
+
+  // Scenario: a resident page is a hit, page 0 is a miss that evicts page 2 (dirty), and with every frame pinned
+  // fetching page 1 fails.
+  EXPECT_NE(nullptr, bpm->FetchPage(3));
+  EXPECT_EQ(true, bpm->UnpinPage(3, false));
+  EXPECT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(nullptr, bpm->FetchPage(1));
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.hits_);
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_EQ(1, stats.fetch_failures_);
+  EXPECT_EQ(3, stats.evictions_);
+  EXPECT_EQ(2, stats.dirty_evictions_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRatio());
+
+  // Scenario: the dumps carry the counters.
+  EXPECT_NE(std::string::npos, stats.ToString().find("dirty evictions: 2"));
+  EXPECT_NE(std::string::npos, stats.ToJson().find("\"evictions\": 3"));
+  auto disk_stats = disk_manager->GetStats();
+  EXPECT_EQ(1, disk_stats.read_latency_.count_);
+  EXPECT_EQ(2, disk_stats.write_latency_.count_);
+  EXPECT_NE(std::string::npos, disk_stats.ToJson().find("\"pages_written\": 2"));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Deleted pages are handed out again before the database file grows
+TEST(BufferPoolManagerInstanceTest, PageReuseTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: deleted pages are reused lowest first, whether they were resident or not, then new ids follow.
+  EXPECT_EQ(true, bpm->DeletePage(7));
+  EXPECT_EQ(true, bpm->DeletePage(3));
+  EXPECT_EQ(true, bpm->FlushPage(5));
+  EXPECT_EQ(true, bpm->DeletePage(5));
+  EXPECT_EQ(true, bpm->DeletePage(5));
+  EXPECT_EQ(3, disk_manager->GetFreeSpaceMap()->NumFree());
+  for (page_id_t expected : {3, 5, 7, 10}) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(expected, page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: ids that were never allocated are not taken as free.
+  EXPECT_EQ(true, bpm->DeletePage(100));
+  EXPECT_EQ(0, disk_manager->GetFreeSpaceMap()->NumFree());
+
+  // Scenario: the free space map outlives the pool; a reopened pool reuses the pages it lists and never hands out a
+  // page that is still in use.
+  EXPECT_EQ(true, bpm->DeletePage(2));
+  std::vector<page_id_t> live_pages;
+  for (page_id_t page_id = 0; page_id <= 10; ++page_id) {
+    if (page_id == 2) {
+      continue;
+    }
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    live_pages.push_back(page_id);
+  }
+  bpm->FlushAllPages();
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  EXPECT_TRUE(disk_manager->GetFreeSpaceMap()->IsFree(2));
+  for (page_id_t expected : {2, 11, 12, 13}) {
+    Page *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(expected, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "new page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_EQ(0, disk_manager->GetFreeSpaceMap()->NumFree());
+  // pages of the earlier pool can be freed and reused as well
+  EXPECT_EQ(true, bpm->DeletePage(9));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(9, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  live_pages.erase(std::find(live_pages.begin(), live_pages.end(), 9));
+  bpm->FlushAllPages();
+  for (page_id_t page_id : live_pages) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cstdio>
 #include <thread>  // NOLINT
 #include <vector>
@@ -19,7 +20,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +60,52 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const int num_threads = 8;
+  const int frames_per_thread = 64;
+  ClockReplacer clock_replacer(num_threads * frames_per_thread);
+
+  // Scenario: every thread unpins its own frames and pins every other one again.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&clock_replacer, tid] {
+      for (int i = 0; i < frames_per_thread; i++) {
+        clock_replacer.Unpin(tid * frames_per_thread + i);
+      }
+      for (int i = 0; i < frames_per_thread; i += 2) {
+        clock_replacer.Pin(tid * frames_per_thread + i);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(num_threads * frames_per_thread / 2, clock_replacer.Size());
+
+  // Scenario: concurrent victim searches hand out every unpinned frame exactly once.
+  std::vector<std::vector<frame_id_t>> victims(num_threads);
+  threads.clear();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&clock_replacer, &victims, tid] {
+      frame_id_t frame_id;
+      while (clock_replacer.Victim(&frame_id)) {
+        victims[tid].emplace_back(frame_id);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  std::vector<frame_id_t> all;
+  for (auto &v : victims) {
+    all.insert(all.end(), v.begin(), v.end());
+  }
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(num_threads * frames_per_thread / 2, all.size());
+  for (size_t i = 0; i < all.size(); i++) {
+    EXPECT_EQ(static_cast<frame_id_t>(2 * i + 1), all[i]);
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
 }  // namespace bustub
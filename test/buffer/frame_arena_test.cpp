@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <unistd.h>
+
+#include <cstdint>
+
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(FrameArenaTest, SampleTest) {
+  const size_t num_frames = 16;
+  FrameArena arena(num_frames);
+  Page *pages = arena.GetPages();
+
+  // Scenario: frames are empty, their data is page aligned and laid out back to back.
+  for (size_t i = 0; i < num_frames; i++) {
+    EXPECT_EQ(INVALID_PAGE_ID, pages[i].GetPageId());
+    EXPECT_EQ(0, pages[i].GetPinCount());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages[i].GetData()) % sysconf(_SC_PAGESIZE));
+    EXPECT_EQ(pages[0].GetData() + i * PAGE_SIZE, pages[i].GetData());
+    for (size_t j = 0; j < PAGE_SIZE; j += 512) {
+      EXPECT_EQ(0, pages[i].GetData()[j]);
+    }
+  }
+  // Scenario: small arenas do not use huge pages.
+  EXPECT_FALSE(arena.IsHugeTlb());
+}
+
+TEST(FrameArenaTest, LargeArenaTest) {
+  // Scenario: an arena of several huge pages, bound to a NUMA node, works whether or not huge pages are reserved.
+  const size_t num_frames = 3 * FrameArena::HUGE_PAGE_SIZE / PAGE_SIZE;
+  FrameArena arena(num_frames, FrameArena::NumNumaNodes() - 1);
+  EXPECT_EQ(FrameArena::NumNumaNodes() - 1, arena.GetNumaNode());
+  Page *pages = arena.GetPages();
+  for (size_t i = 0; i < num_frames; i++) {
+    pages[i].GetData()[0] = static_cast<char>(i);
+    pages[i].GetData()[PAGE_SIZE - 1] = static_cast<char>(i);
+  }
+  for (size_t i = 0; i < num_frames; i++) {
+    EXPECT_EQ(static_cast<char>(i), pages[i].GetData()[0]);
+    EXPECT_EQ(static_cast<char>(i), pages[i].GetData()[PAGE_SIZE - 1]);
+  }
+}
+
+}  // namespace bustub
@@ -13,7 +13,10 @@
 #include "buffer/parallel_buffer_pool_manager.h"
 #include <cstdio>
 #include <random>
+#include <set>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -151,4 +154,178 @@ TEST(ParallelBufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// FlushAllPages writes the dirty pages of every instance and leaves them clean and resident
+TEST(ParallelBufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 5;
+  const page_id_t num_pages = buffer_pool_size * num_instances;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+  }
+  // every third page stays pinned through a second pin, the flush must not drop its pin
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    if (i % 3 == 0) {
+      EXPECT_NE(nullptr, bpm->FetchPage(i));
+    }
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+
+  // Scenario: every page is in the file after one flush.
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_pages, disk_manager->GetNumWrites());
+  char buf[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    memset(expected, 0, PAGE_SIZE);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    disk_manager->ReadPage(i, buf);
+    EXPECT_EQ(0, memcmp(buf, expected, PAGE_SIZE));
+  }
+
+  // Scenario: the pages are clean now, and the pinned ones are still pinned exactly once.
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_pages, disk_manager->GetNumWrites());
+  for (page_id_t i = 0; i < num_pages; i += 3) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+    EXPECT_EQ(false, bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: only pages dirtied since the last flush are written again.
+  for (page_id_t i = 10; i < 20; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "again %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_pages + 10, disk_manager->GetNumWrites());
+  disk_manager->ReadPage(15, buf);
+  EXPECT_EQ(0, strcmp(buf, "again 15"));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Page ids map to instances evenly, also when the hot ones are equal modulo the number of instances
+TEST(ParallelBufferPoolManagerTest, PageMappingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t num_instances = 4;
+  const size_t num_threads = 8;
+
+  // Scenario: the ids of every block are spread over all instances, and strided ids are too.
+  std::vector<size_t> block_load(num_instances, 0);
+  std::vector<size_t> strided_load(num_instances, 0);
+  for (page_id_t page_id = 0; page_id < 4000; ++page_id) {
+    block_load[BufferPoolManagerInstance::InstanceOf(page_id, num_instances)]++;
+    strided_load[BufferPoolManagerInstance::InstanceOf(page_id * num_instances, num_instances)]++;
+  }
+  for (size_t i = 0; i < num_instances; ++i) {
+    EXPECT_EQ(1000, block_load[i]);
+    EXPECT_LT(750, strided_load[i]);
+    EXPECT_GT(1250, strided_load[i]);
+  }
+
+  // Scenario: concurrent NewPage calls fill the pool with distinct ids, each resident in the instance it maps to.
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  std::vector<std::vector<page_id_t>> created(num_threads);
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, &created, tid] {
+      page_id_t page_id;
+      for (size_t i = 0; i < buffer_pool_size * num_instances / num_threads; ++i) {
+        if (bpm->NewPage(&page_id) != nullptr) {
+          created[tid].push_back(page_id);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::set<page_id_t> ids;
+  for (auto &pages : created) {
+    ids.insert(pages.begin(), pages.end());
+  }
+  EXPECT_EQ(buffer_pool_size * num_instances, ids.size());
+  EXPECT_EQ(0, *ids.begin());
+  EXPECT_EQ(buffer_pool_size * num_instances - 1, *ids.rbegin());
+  for (auto page_id : ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// An instance whose frames are all pinned borrows free frames of another one
+TEST(ParallelBufferPoolManagerTest, FrameBorrowingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 2;
+  const size_t num_instances = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, nullptr,
+                                            ReplacerPolicy::LRU, buffer_pool_size);
+  auto instance_of = [](page_id_t page_id) { return BufferPoolManagerInstance::InstanceOf(page_id, num_instances); };
+
+  // four pages per instance, the last two of each stay resident
+  std::vector<std::vector<page_id_t>> pages(num_instances);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * num_instances * 2; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    pages[instance_of(page_id_temp)].push_back(page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  ASSERT_EQ(4, pages[0].size());
+  ASSERT_EQ(4, pages[1].size());
+
+  // Scenario: with instance 1 idle, instance 0 holds all four of its pages pinned at once.
+  EXPECT_EQ(true, bpm->DeletePage(pages[1][2]));
+  EXPECT_EQ(true, bpm->DeletePage(pages[1][3]));
+  for (auto page_id : pages[0]) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, page->GetPageId());
+  }
+  EXPECT_EQ(2, bpm->GetInstanceStats(0).frames_borrowed_);
+  EXPECT_EQ(2, bpm->GetInstanceStats(1).frames_lent_);
+
+  // Scenario: instance 1 is left without frames until instance 0 frees one, then borrows it back.
+  EXPECT_EQ(nullptr, bpm->FetchPage(pages[1][0]));
+  for (auto page_id : pages[0]) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(true, bpm->DeletePage(pages[0][3]));
+  EXPECT_NE(nullptr, bpm->FetchPage(pages[1][0]));
+  EXPECT_EQ(1, bpm->GetInstanceStats(1).frames_borrowed_);
+  EXPECT_EQ(nullptr, bpm->FetchPage(pages[1][1]));
+  EXPECT_EQ(true, bpm->UnpinPage(pages[1][0], false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -0,0 +1,206 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_bench_test.cpp
+//
+// Identification: test/buffer/replacer_bench_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Benchmarks are disabled by default, run them with
+//   ./test/replacer_bench_test --gtest_also_run_disabled_tests
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <chrono>  // NOLINT
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+const size_t trace_pool_size = 256;
+const size_t trace_num_pages = 8192;
+const size_t trace_length = 1000000;
+const size_t micro_pool_size = 4096;
+const size_t micro_ops_per_thread = 200000;
+
+/** Draws page ids 0..n-1 with a Zipf distribution, page 0 being the hottest. */
+class ZipfGenerator {
+ public:
+  ZipfGenerator(size_t n, double theta) : cdf_(n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+      cdf_[i] = sum;
+    }
+    for (auto &c : cdf_) {
+      c /= sum;
+    }
+  }
+
+  auto Next(std::mt19937 *rng) -> page_id_t {
+    double u = std::uniform_real_distribution<double>(0, 1)(*rng);
+    return static_cast<page_id_t>(std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin());
+  }
+
+ private:
+  std::vector<double> cdf_;
+};
+
+/**
+ * An OLTP workload of Zipf distributed point accesses, interrupted every scan_interval accesses by a sequential scan
+ * of scan_length pages that are never touched otherwise.
+ */
+auto MakeTrace(double theta, size_t scan_interval, size_t scan_length) -> std::vector<page_id_t> {
+  std::mt19937 rng(42);
+  ZipfGenerator zipf(trace_num_pages, theta);
+  std::vector<page_id_t> trace;
+  trace.reserve(trace_length);
+  page_id_t next_scan_page = trace_num_pages;
+  while (trace.size() < trace_length) {
+    if (scan_interval != 0 && trace.size() % scan_interval == 0) {
+      for (size_t i = 0; i < scan_length && trace.size() < trace_length; i++) {
+        trace.emplace_back(next_scan_page++);
+      }
+      continue;
+    }
+    trace.emplace_back(zipf.Next(&rng));
+  }
+  return trace;
+}
+
+/**
+ * Replay a trace against a replacer the way a buffer pool drives it: a hit pins and unpins the frame, a miss takes a
+ * free frame or a victim and unpins it once the page is in.
+ * @return the hit ratio
+ */
+auto ReplayTrace(Replacer *replacer, const std::vector<page_id_t> &trace) -> double {
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frames(trace_pool_size, INVALID_PAGE_ID);
+  frame_id_t next_free = 0;
+  size_t hits = 0;
+  for (auto page_id : trace) {
+    auto it = page_table.find(page_id);
+    if (it != page_table.end()) {
+      hits++;
+      replacer->Pin(it->second);
+      replacer->Unpin(it->second);
+      continue;
+    }
+    frame_id_t frame_id;
+    if (next_free < static_cast<frame_id_t>(trace_pool_size)) {
+      frame_id = next_free++;
+    } else {
+      EXPECT_TRUE(replacer->Victim(&frame_id));
+      page_table.erase(frames[frame_id]);
+    }
+    frames[frame_id] = page_id;
+    page_table[page_id] = frame_id;
+    replacer->Unpin(frame_id);
+  }
+  return static_cast<double>(hits) / static_cast<double>(trace.size());
+}
+
+/**
+ * Every thread repeatedly pins and unpins random frames, like buffer pool hits do, and every 16th operation evicts a
+ * frame and brings it back in, like a miss does.
+ * @return replacer operations per second over all threads
+ */
+auto RunReplacerMicroBench(Replacer *replacer, size_t num_threads) -> double {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([replacer, tid] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<frame_id_t> dist(0, static_cast<frame_id_t>(micro_pool_size) - 1);
+      for (size_t i = 0; i < micro_ops_per_thread; i++) {
+        frame_id_t frame_id;
+        if (i % 16 == 0) {
+          if (replacer->Victim(&frame_id)) {
+            replacer->Unpin(frame_id);
+          }
+          continue;
+        }
+        frame_id = dist(rng);
+        replacer->Pin(frame_id);
+        replacer->Unpin(frame_id);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(num_threads * micro_ops_per_thread) / elapsed.count();
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(ReplacerBenchTest, DISABLED_ThroughputTest) {
+  const std::vector<std::pair<const char *, ReplacerPolicy>> policies = {{"LRU", ReplacerPolicy::LRU},
+                                                                         {"CLOCK", ReplacerPolicy::CLOCK}};
+  std::printf("%8s", "threads");
+  for (auto &[name, policy] : policies) {
+    std::printf(" %14s", (std::string(name) + " op/s").c_str());
+  }
+  std::printf("\n");
+  for (size_t num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    std::printf("%8zu", num_threads);
+    for (auto &[name, policy] : policies) {
+      auto replacer = Replacer::Create(policy, micro_pool_size);
+      for (size_t i = 0; i < micro_pool_size; i++) {
+        replacer->Unpin(static_cast<frame_id_t>(i));
+      }
+      std::printf(" %14.0f", RunReplacerMicroBench(replacer.get(), num_threads));
+    }
+    std::printf("\n");
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacerBenchTest, DISABLED_HitRatioTest) {
+  const std::vector<std::pair<const char *, ReplacerPolicy>> policies = {
+      {"LRU", ReplacerPolicy::LRU}, {"LRU-2", ReplacerPolicy::LRU_K}, {"2Q", ReplacerPolicy::TWO_Q},
+      {"CLOCK", ReplacerPolicy::CLOCK}};
+  struct Workload {
+    const char *name_;
+    double theta_;
+    size_t scan_interval_;
+    size_t scan_length_;
+  };
+  const std::vector<Workload> workloads = {{"zipf 0.8", 0.8, 0, 0},
+                                           {"zipf 0.99", 0.99, 0, 0},
+                                           {"zipf 0.8 + scans", 0.8, 20000, trace_pool_size * 2},
+                                           {"zipf 0.99 + scans", 0.99, 20000, trace_pool_size * 2}};
+
+  std::printf("%20s", "workload");
+  for (auto &[name, policy] : policies) {
+    std::printf(" %8s", name);
+  }
+  std::printf("\n");
+  for (auto &workload : workloads) {
+    auto trace = MakeTrace(workload.theta_, workload.scan_interval_, workload.scan_length_);
+    std::printf("%20s", workload.name_);
+    for (auto &[name, policy] : policies) {
+      auto replacer = Replacer::Create(policy, trace_pool_size);
+      std::printf(" %8.4f", ReplayTrace(replacer.get(), trace));
+    }
+    std::printf("\n");
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer_test.cpp
+//
+// Identification: test/buffer/two_q_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <vector>
+
+#include "buffer/two_q_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(TwoQReplacerTest, SampleTest) {
+  // A1 may hold two of the eight frames before it is victimized first.
+  TwoQReplacer two_q_replacer(8, 25);
+
+  // Scenario: bring in four frames and reference 1 and 2 again, moving them to Am.
+  for (frame_id_t i = 1; i <= 4; i++) {
+    two_q_replacer.Unpin(i);
+  }
+  two_q_replacer.Pin(1);
+  two_q_replacer.Unpin(1);
+  two_q_replacer.Pin(2);
+  two_q_replacer.Unpin(2);
+  EXPECT_EQ(4, two_q_replacer.Size());
+
+  // Scenario: a scan brings in more frames, they only churn A1 in FIFO order.
+  two_q_replacer.Unpin(5);
+  int value;
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+
+  // Scenario: A1 is below its share now, so Am gives up its least recently used frame.
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: pinned frames are not victimized, and Am is used once A1 is empty.
+  two_q_replacer.Pin(5);
+  EXPECT_EQ(1, two_q_replacer.Size());
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(two_q_replacer.Victim(&value));
+
+  // Scenario: 5 was referenced again while resident, so it lands in Am.
+  two_q_replacer.Unpin(5);
+  two_q_replacer.Unpin(6);
+  two_q_replacer.Unpin(7);
+  std::vector<frame_id_t> frames;
+  two_q_replacer.PeekVictims(8, &frames);
+  EXPECT_EQ((std::vector<frame_id_t>{6, 7, 5}), frames);
+
+  two_q_replacer.Remove(6);
+  EXPECT_EQ(2, two_q_replacer.Size());
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(7, value);
+}
+
+}  // namespace bustub
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics_test.cpp
+//
+// Identification: test/common/metrics_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/util/metrics.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, StripedCounterTest) {
+  const int num_threads = 8;
+  const int num_adds = 10000;
+  StripedCounter counter;
+  EXPECT_EQ(0, counter.Get());
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&counter] {
+      for (int i = 0; i < num_adds; i++) {
+        counter.Add();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  counter.Add(5);
+  EXPECT_EQ(num_threads * num_adds + 5, counter.Get());
+}
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, LatencyHistogramTest) {
+  using std::chrono::nanoseconds;
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.Snapshot().count_);
+  EXPECT_EQ(0, histogram.Snapshot().PercentileNanos(0.99));
+
+  // 90 fast samples in [512, 1024) ns, 9 slow ones in [65536, 131072) ns and one zero
+  for (int i = 0; i < 90; i++) {
+    histogram.Record(nanoseconds(1000));
+  }
+  for (int i = 0; i < 9; i++) {
+    histogram.Record(nanoseconds(100000));
+  }
+  histogram.Record(nanoseconds(0));
+
+  auto snapshot = histogram.Snapshot();
+  EXPECT_EQ(100, snapshot.count_);
+  EXPECT_EQ(90 * 1000 + 9 * 100000, snapshot.sum_nanos_);
+  EXPECT_DOUBLE_EQ(9900, snapshot.MeanNanos());
+  EXPECT_EQ(0, snapshot.PercentileNanos(0.01));
+  EXPECT_EQ(1024, snapshot.PercentileNanos(0.5));
+  EXPECT_EQ(1024, snapshot.PercentileNanos(0.91));
+  EXPECT_EQ(131072, snapshot.PercentileNanos(0.99));
+  EXPECT_EQ(131072, snapshot.PercentileNanos(1));
+
+  // Scenario: snapshots of several histograms add up.
+  snapshot += histogram.Snapshot();
+  EXPECT_EQ(200, snapshot.count_);
+  EXPECT_EQ(1024, snapshot.PercentileNanos(0.5));
+
+  // Scenario: durations past the last bucket are clamped into it.
+  LatencyHistogram slow;
+  slow.Record(std::chrono::hours(1));
+  EXPECT_EQ(1, slow.Snapshot().buckets_[HistogramSnapshot::NUM_BUCKETS - 1]);
+
+  EXPECT_NE(std::string::npos, histogram.Snapshot().ToJson().find("\"count\": 100"));
+  EXPECT_NE(std::string::npos, histogram.Snapshot().ToString().find("count=100"));
+}
+
+}  // namespace bustub
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <atomic>
 // NOLINTNEXTLINE
 #include <chrono>
 #include <cstdio>
@@ -406,6 +407,106 @@ void MixTest2Call() {
   }
 }
 
+void SplitTestCall() {
+  for (size_t iter = 0; iter < 10; iter++) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+    ExtendibleHashTable<int, int, IntComparator> hash_table("foo_pk", bpm, IntComparator(), HashFunction<int>());
+
+    // Create header_page
+    page_id_t page_id;
+    bpm->NewPage(&page_id, nullptr);
+
+    std::vector<int> perserved_keys;
+    for (int i = 1; i <= 300; i++) {
+      perserved_keys.emplace_back(-i);
+    }
+    InsertHelper(&hash_table, perserved_keys, 1);
+    std::vector<int> growing_keys;
+    for (int i = 1; i <= 8000; i++) {
+      growing_keys.emplace_back(i);
+    }
+
+    // splits double the directory while lookups of other keys go on, which never miss a key
+    size_t num_threads = 4;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_threads; i++) {
+      if (i % 2 == 0) {
+        threads.emplace_back(InsertHelperSplit, &hash_table, growing_keys, num_threads / 2, i, i / 2);
+      } else {
+        threads.emplace_back(LookupHelper, &hash_table, perserved_keys, i, 0);
+      }
+    }
+    for (size_t i = 0; i < num_threads; i++) {
+      threads[i].join();
+    }
+
+    LookupHelper(&hash_table, perserved_keys, 1);
+    LookupHelper(&hash_table, growing_keys, 1);
+    EXPECT_LT(0, hash_table.GetGlobalDepth());
+    hash_table.VerifyIntegrity();
+
+    // Cleanup
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    disk_manager->ShutDown();
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+void MergeFlushTestCall() {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> hash_table("foo_pk", bpm, IntComparator(), HashFunction<int>());
+
+  // Create header_page
+  page_id_t page_id;
+  bpm->NewPage(&page_id, nullptr);
+
+  std::vector<int> keys;
+  for (int i = 1; i <= 2000; i++) {
+    keys.emplace_back(i);
+  }
+  // removes empty and merge buckets while the buffer pool keeps flushing, which pins the dirty buckets for a moment
+  size_t num_threads = 4;
+  std::atomic<bool> done = false;
+  std::vector<std::thread> flushers;
+  for (size_t i = 0; i < num_threads; i++) {
+    flushers.emplace_back([bpm, &done] {
+      while (!done) {
+        bpm->FlushAllPages();
+      }
+    });
+  }
+  for (size_t iter = 0; iter < 40; iter++) {
+    InsertHelper(&hash_table, keys, 1);
+    LaunchParallelTest(num_threads, 0, DeleteHelperSplit, &hash_table, keys, num_threads);
+  }
+  done = true;
+  for (auto &flusher : flushers) {
+    flusher.join();
+  }
+
+  for (auto key : keys) {
+    std::vector<int> result;
+    EXPECT_FALSE(hash_table.GetValue(nullptr, key, &result));
+  }
+  hash_table.VerifyIntegrity();
+  // the table takes inserts again
+  InsertHelper(&hash_table, {1, 2}, 1);
+  LookupHelper(&hash_table, {1, 2}, 1);
+
+  // Cleanup
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  disk_manager->ShutDown();
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 /*
  * Score: 5
  * Description: Concurrently insert a set of keys.
@@ -474,4 +575,26 @@ TEST(HashTableConcurrentTest2, MixTest2) {
   MixTest2Call();
   TEST_TIMEOUT_FAIL_END(3 * 1000 * 120)
 }
+
+/*
+ * Description: Insert a set of keys. Concurrently insert keys that split
+ * buckets and double the directory, while getting the previously inserted
+ * keys. Check that every lookup finds its key.
+ */
+TEST(HashTableConcurrentTest2, SplitTest) {
+  TEST_TIMEOUT_BEGIN
+  SplitTestCall();
+  TEST_TIMEOUT_FAIL_END(3 * 1000 * 120)
+}
+
+/*
+ * Description: Insert a set of keys. Concurrently remove them all, which
+ * merges buckets, while the buffer pool flushes all pages over and over.
+ * Check that the table ends up empty and intact.
+ */
+TEST(HashTableConcurrentTest2, MergeFlushTest) {
+  TEST_TIMEOUT_BEGIN
+  MergeFlushTestCall();
+  TEST_TIMEOUT_FAIL_END(3 * 1000 * 120)
+}
 }  // namespace bustub
@@ -31,6 +31,7 @@
 #include "execution/plans/delete_plan.h"
 #include "execution/plans/distinct_plan.h"
 #include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
 #include "execution/plans/limit_plan.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/update_plan.h"
@@ -46,6 +47,7 @@
  * particular, the tests in this file include:
  *
  * - Sequential Scan
+ * - Index Scan
  * - Insert (Raw)
  * - Insert (Select)
  * - Update
@@ -110,6 +112,98 @@ TEST_F(ExecutorTest, SimpleSeqScanTest) {
   }
 }
 
+// SELECT colA, colB FROM test_1 WHERE colA BETWEEN 100 AND 299 AND colB < 5, through a B+ tree index on colA
+TEST_F(ExecutorTest, SimpleIndexScanTest) {
+  TableInfo *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  const Schema &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("a integer");
+  auto *index_info = GetExecutorContext()->GetCatalog()->CreateBPlusTreeIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index1", "test_1", schema, *key_schema, {0}, 8);
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *const5 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(5));
+  auto *predicate = MakeComparisonExpression(col_b, const5, ComparisonType::LessThan);
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+
+  // Scenario: a range scan with a predicate returns the matching tuples of the range in key order.
+  IndexScanPlanNode plan{out_schema, predicate, index_info->index_oid_, {ValueFactory::GetIntegerValue(100)},
+                         {ValueFactory::GetIntegerValue(299)}};
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+  size_t expected = 0;
+  for (auto iter = table_info->table_->Begin(GetTxn()); iter != table_info->table_->End(); ++iter) {
+    int32_t a = iter->GetValue(&schema, 0).GetAs<int32_t>();
+    expected += a >= 100 && a <= 299 && iter->GetValue(&schema, 1).GetAs<int32_t>() < 5 ? 1 : 0;
+  }
+  ASSERT_EQ(result_set.size(), expected);
+  int32_t last = 99;
+  for (const auto &tuple : result_set) {
+    int32_t a = tuple.GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>();
+    ASSERT_LT(last, a);
+    ASSERT_LE(a, 299);
+    ASSERT_LT(tuple.GetValue(out_schema, out_schema->GetColIdx("colB")).GetAs<int32_t>(), 5);
+    last = a;
+  }
+
+  // Scenario: a scan without bounds returns every tuple in key order.
+  IndexScanPlanNode full_plan{out_schema, nullptr, index_info->index_oid_};
+  result_set.clear();
+  GetExecutionEngine()->Execute(&full_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), TEST1_SIZE);
+  for (size_t i = 0; i < result_set.size(); i++) {
+    ASSERT_EQ(result_set[i].GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>(), i);
+  }
+
+  // Scenario: a prefix of a composite key bounds its first column only, the keys come in order of the second.
+  key_schema = ParseCreateStatement("b integer,a integer");
+  auto *composite_info = GetExecutorContext()->GetCatalog()->CreateBPlusTreeIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index2", "test_1", schema, *key_schema, {1, 0}, 8);
+  IndexScanPlanNode prefix_plan{out_schema, nullptr, composite_info->index_oid_, {ValueFactory::GetIntegerValue(3)},
+                                {ValueFactory::GetIntegerValue(3)}};
+  result_set.clear();
+  GetExecutionEngine()->Execute(&prefix_plan, &result_set, GetTxn(), GetExecutorContext());
+  expected = 0;
+  for (auto iter = table_info->table_->Begin(GetTxn()); iter != table_info->table_->End(); ++iter) {
+    expected += iter->GetValue(&schema, 1).GetAs<int32_t>() == 3 ? 1 : 0;
+  }
+  ASSERT_EQ(result_set.size(), expected);
+  last = -1;
+  for (const auto &tuple : result_set) {
+    ASSERT_EQ(tuple.GetValue(out_schema, out_schema->GetColIdx("colB")).GetAs<int32_t>(), 3);
+    int32_t a = tuple.GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>();
+    ASSERT_LT(last, a);
+    last = a;
+  }
+
+  // Scenario: a descending scan of the prefix returns the same tuples in reverse order.
+  IndexScanPlanNode descending_prefix_plan{out_schema,
+                                           nullptr,
+                                           composite_info->index_oid_,
+                                           {ValueFactory::GetIntegerValue(3)},
+                                           {ValueFactory::GetIntegerValue(3)},
+                                           true};
+  std::vector<Tuple> descending_set{};
+  GetExecutionEngine()->Execute(&descending_prefix_plan, &descending_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(descending_set.size(), result_set.size());
+  for (size_t i = 0; i < descending_set.size(); i++) {
+    const Tuple &ascending = result_set[result_set.size() - 1 - i];
+    ASSERT_EQ(descending_set[i].GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>(),
+              ascending.GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>());
+  }
+
+  // SELECT colA, colB FROM test_1 WHERE colA <= 299 ORDER BY colA DESC LIMIT 10
+  // Scenario: a descending scan under a limit returns the largest keys of the range, largest first.
+  IndexScanPlanNode descending_plan{
+      out_schema, nullptr, index_info->index_oid_, {}, {ValueFactory::GetIntegerValue(299)}, true};
+  LimitPlanNode limit_plan{out_schema, &descending_plan, 10};
+  result_set.clear();
+  GetExecutionEngine()->Execute(&limit_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), 10);
+  for (size_t i = 0; i < result_set.size(); i++) {
+    ASSERT_EQ(result_set[i].GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>(), 299 - i);
+  }
+}
+
 // INSERT INTO empty_table2 VALUES (100, 10), (101, 11), (102, 12)
 TEST_F(ExecutorTest, SimpleRawInsertTest) {
   // Create Values to insert
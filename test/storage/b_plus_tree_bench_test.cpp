@@ -0,0 +1,261 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bench_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bench_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Benchmarks are disabled by default, run them with
+//   ./test/b_plus_tree_bench_test --gtest_also_run_disabled_tests
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_builder.h"
+#include "storage/page/header_page.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+using BenchTree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+/** Large enough to hold the whole tree, so that the benchmark measures latching rather than I/O. */
+const size_t bench_pool_size = 4096;
+const int64_t bench_num_keys = 200000;
+const size_t bench_ops_per_thread = 20000;
+
+/**
+ * Every thread runs a mix of lookups, inserts and removes of random keys out of twice the preloaded key range, so
+ * that the tree keeps its size.
+ * @param write_percent share of the operations that insert or remove, half each
+ * @return the number of operations per second over all threads
+ */
+auto RunTreeBench(BenchTree *tree, size_t num_threads, int write_percent) -> double {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([tree, tid, write_percent] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<int64_t> key_dist(0, 2 * bench_num_keys - 1);
+      Transaction transaction(static_cast<txn_id_t>(tid));
+      GenericKey<8> index_key;
+      std::vector<RID> rids;
+      for (size_t i = 0; i < bench_ops_per_thread; i++) {
+        int64_t key = key_dist(rng);
+        index_key.SetFromInteger(key);
+        auto dice = static_cast<int>(rng() % 200);
+        if (dice < write_percent) {
+          tree->Insert(index_key, RID(0, static_cast<uint32_t>(key)), &transaction);
+        } else if (dice < 2 * write_percent) {
+          tree->Remove(index_key, &transaction);
+        } else {
+          rids.clear();
+          tree->GetValue(index_key, &rids);
+        }
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(num_threads * bench_ops_per_thread) / elapsed.count();
+}
+
+/**
+ * Insert the keys of bench_num_keys rows in random order and print how many keys a leaf holds against the slots of
+ * uncompressed pairs, the number of pages and the height of the tree.
+ */
+template <size_t KeySize>
+void RunFanOutBench(const std::string &sql, const std::function<std::vector<Value>(int64_t)> &row) {
+  using Tree = BPlusTree<GenericKey<KeySize>, RID, GenericComparator<KeySize>>;
+  auto key_schema = ParseCreateStatement(sql);
+  GenericComparator<KeySize> comparator(key_schema.get());
+  std::vector<int64_t> keys(bench_num_keys);
+  for (int64_t key = 0; key < bench_num_keys; key++) {
+    keys[key] = key;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+
+  const std::string db_name = "bench.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(bench_pool_size, disk_manager);
+  page_id_t header_page_id;
+  auto *header_page = reinterpret_cast<HeaderPage *>(bpm->NewPage(&header_page_id));
+  ASSERT_NE(nullptr, header_page);
+  Tree tree("bench_pk", bpm, comparator);
+  Transaction transaction(0);
+  GenericKey<KeySize> index_key;
+  for (auto key : keys) {
+    index_key.SetFromKey(Tuple(row(key), key_schema.get()), key_schema.get());
+    tree.Insert(index_key, RID(0, static_cast<uint32_t>(key)), &transaction);
+  }
+
+  page_id_t page_id;
+  ASSERT_TRUE(header_page->GetRootId("bench_pk", &page_id));
+  int height = 1;
+  Page *page = bpm->FetchPage(page_id);
+  while (!reinterpret_cast<BPlusTreePage *>(page->GetData())->IsLeafPage()) {
+    page_id_t child_page_id =
+        reinterpret_cast<BPlusTreeInternalPage<GenericKey<KeySize>, page_id_t, GenericComparator<KeySize>> *>(
+            page->GetData())
+            ->ValueAt(0);
+    bpm->UnpinPage(page_id, false);
+    page_id = child_page_id;
+    page = bpm->FetchPage(page_id);
+    height++;
+  }
+  int num_leaves = 0;
+  while (page != nullptr) {
+    num_leaves++;
+    page_id_t next_page_id =
+        reinterpret_cast<BPlusTreeLeafPage<GenericKey<KeySize>, RID, GenericComparator<KeySize>> *>(page->GetData())
+            ->GetNextPageId();
+    bpm->UnpinPage(page->GetPageId(), false);
+    page = next_page_id == INVALID_PAGE_ID ? nullptr : bpm->FetchPage(next_page_id);
+  }
+  page_id_t last_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&last_page_id));
+  bpm->UnpinPage(last_page_id, false);
+  // a leaf of uncompressed pairs had a 28 byte header
+  std::printf("%32s %10.1f %10zu %8d %8d\n", sql.c_str(), static_cast<double>(bench_num_keys) / num_leaves,
+              (PAGE_SIZE - 28) / sizeof(std::pair<GenericKey<KeySize>, RID>), last_page_id, height);
+
+  bpm->UnpinPage(header_page_id, true);
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("bench.fsm");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBenchTest, DISABLED_ThroughputTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  const std::string db_name = "bench.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(bench_pool_size, disk_manager);
+  page_id_t header_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&header_page_id));
+  BenchTree tree("bench_pk", bpm, comparator);
+
+  // Preload every other key of the range the workloads draw from.
+  Transaction transaction(0);
+  GenericKey<8> index_key;
+  for (int64_t key = 0; key < 2 * bench_num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, RID(0, static_cast<uint32_t>(key)), &transaction));
+  }
+
+  // Lookups only read latch; inserts and removes write latch the leaf alone unless they split or merge it.
+  std::printf("%8s %14s %14s %14s\n", "threads", "read op/s", "10% write op/s", "50% write op/s");
+  for (size_t num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    double read_only = RunTreeBench(&tree, num_threads, 0);
+    double read_mostly = RunTreeBench(&tree, num_threads, 10);
+    double write_heavy = RunTreeBench(&tree, num_threads, 50);
+    std::printf("%8zu %14.0f %14.0f %14.0f\n", num_threads, read_only, read_mostly, write_heavy);
+  }
+
+  bpm->UnpinPage(header_page_id, true);
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("bench.fsm");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBenchTest, DISABLED_BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  std::vector<int64_t> keys(bench_num_keys);
+  for (int64_t key = 0; key < bench_num_keys; key++) {
+    keys[key] = key;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+
+  // A small pool, so that pages are written back while the tree is built.
+  std::printf("%12s %10s %10s %12s\n", "build", "seconds", "pages", "disk writes");
+  for (int mode = 0; mode < 3; mode++) {
+    const std::string db_name = "bench.db";
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+    page_id_t header_page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&header_page_id));
+    BenchTree tree("bench_pk", bpm, comparator);
+    Transaction transaction(0);
+    GenericKey<8> index_key;
+
+    auto start = std::chrono::steady_clock::now();
+    if (mode == 0) {
+      for (auto key : keys) {
+        index_key.SetFromInteger(key);
+        tree.Insert(index_key, RID(0, static_cast<uint32_t>(key)), &transaction);
+      }
+    } else {
+      // mode 2 sorts in runs of a tenth of the keys and merges them
+      BPlusTreeBuilder<GenericKey<8>, RID, GenericComparator<8>> builder(
+          &tree, comparator, BPlusTreeBuilder<GenericKey<8>, RID, GenericComparator<8>>::DEFAULT_FILL_FACTOR,
+          mode == 1 ? keys.size() : keys.size() / 10);
+      for (auto key : keys) {
+        index_key.SetFromInteger(key);
+        builder.Add(index_key, RID(0, static_cast<uint32_t>(key)));
+      }
+      builder.Finish();
+    }
+    bpm->FlushAllPages();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    page_id_t last_page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&last_page_id));
+    bpm->UnpinPage(last_page_id, false);
+    std::printf("%12s %10.3f %10d %12d\n", mode == 0 ? "insert" : (mode == 1 ? "bulk" : "bulk, runs"),
+                elapsed.count(), last_page_id, disk_manager->GetNumWrites());
+
+    bpm->UnpinPage(header_page_id, true);
+    disk_manager->ShutDown();
+    remove(db_name.c_str());
+    remove("bench.fsm");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBenchTest, DISABLED_FanOutTest) {
+  std::printf("%32s %10s %10s %8s %8s\n", "key", "keys/leaf", "fixed", "pages", "height");
+  RunFanOutBench<8>("a bigint", [](int64_t key) -> std::vector<Value> { return {ValueFactory::GetBigIntValue(key)}; });
+  // padding past the encoded key
+  RunFanOutBench<64>("a bigint", [](int64_t key) -> std::vector<Value> { return {ValueFactory::GetBigIntValue(key)}; });
+  // a few tenants, each with a dense range of ids
+  RunFanOutBench<32>("a integer,b bigint,c bigint", [](int64_t key) -> std::vector<Value> {
+    return {ValueFactory::GetIntegerValue(static_cast<int32_t>(key % 4)), ValueFactory::GetBigIntValue(key),
+            ValueFactory::GetBigIntValue(0)};
+  });
+  // a common string prefix
+  RunFanOutBench<64>("a varchar(48)", [](int64_t key) -> std::vector<Value> {
+    return {ValueFactory::GetVarcharValue("https://example.com/events/" + std::to_string(key))};
+  });
+}
+
+}  // namespace bustub
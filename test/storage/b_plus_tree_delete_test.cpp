@@ -12,15 +12,21 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <iterator>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_builder.h"
 #include "test_util.h"  // NOLINT
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
+TEST(BPlusTreeTests, DeleteTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -98,7 +104,7 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
+TEST(BPlusTreeTests, DeleteTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -175,4 +181,157 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, RandomInsertDeleteTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree with small pages, so that splits, merges and redistributions happen at every level
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  auto *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::mt19937 rng(15445);
+  std::set<int64_t> expected;
+  for (int i = 0; i < 20000; i++) {
+    int64_t key = rng() % 1000;
+    index_key.SetFromInteger(key);
+    if (rng() % 2 == 0) {
+      rid.Set(0, key);
+      EXPECT_EQ(expected.insert(key).second, tree.Insert(index_key, rid, transaction));
+    } else {
+      expected.erase(key);
+      tree.Remove(index_key, transaction);
+    }
+  }
+
+  auto expected_key = expected.begin();
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator, ++expected_key) {
+    ASSERT_NE(expected_key, expected.end());
+    EXPECT_EQ((*iterator).second.GetSlotNum(), *expected_key);
+  }
+  EXPECT_EQ(expected_key, expected.end());
+  // Scenario: the prev links survive the splits and merges, a reverse iteration sees the keys in descending order.
+  auto reverse_key = expected.rbegin();
+  for (auto iterator = tree.RBegin(); iterator != tree.End(); ++iterator, ++reverse_key) {
+    ASSERT_NE(reverse_key, expected.rend());
+    EXPECT_EQ((*iterator).second.GetSlotNum(), *reverse_key);
+  }
+  EXPECT_EQ(reverse_key, expected.rend());
+  // Scenario: a reverse iteration from a key starts at the last key not greater than it.
+  for (int64_t key = -1; key <= 1000; key += 77) {
+    index_key.SetFromInteger(key);
+    auto iterator = tree.RBegin(index_key);
+    auto first = expected.upper_bound(key);
+    if (first == expected.begin()) {
+      EXPECT_TRUE(iterator == tree.End());
+      continue;
+    }
+    ASSERT_FALSE(iterator.IsEnd());
+    EXPECT_EQ((*iterator).second.GetSlotNum(), *std::prev(first));
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < 1000; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(expected.count(key) == 1, tree.GetValue(index_key, &rids));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, NonUniqueTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_sk", bpm, comparator, 4, 5, false);
+  GenericKey<8> index_key;
+  RID rid;
+  auto *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // Scenario: a bulk load keeps every value of a key, of which the first keys get thousands.
+  std::mt19937 rng(15445);
+  std::set<std::pair<int64_t, int64_t>> expected;
+  BPlusTreeBuilder<GenericKey<8>, RID, GenericComparator<8>> builder(&tree, comparator, 1.0, 1000);
+  for (int i = 0; i < 10000; i++) {
+    int64_t key = i < 6000 ? i % 3 : rng() % 300;
+    int64_t slot = i < 6000 ? i : rng() % 50;
+    expected.emplace(key, slot);
+    index_key.SetFromInteger(key);
+    rid.Set(key, slot);
+    builder.Add(index_key, rid);
+  }
+  EXPECT_EQ(expected.size(), builder.Finish());
+
+  // Scenario: inserts and removes of single values, and removes of keys with all their values.
+  for (int i = 0; i < 20000; i++) {
+    int64_t key = rng() % 300;
+    int64_t slot = rng() % 50;
+    index_key.SetFromInteger(key);
+    rid.Set(key, slot);
+    int op = rng() % 100;
+    if (op < 50) {
+      EXPECT_EQ(expected.emplace(key, slot).second, tree.Insert(index_key, rid, transaction));
+    } else if (op < 99) {
+      expected.erase({key, slot});
+      tree.Remove(index_key, rid, transaction);
+    } else {
+      expected.erase(expected.lower_bound({key, 0}), expected.lower_bound({key + 1, 0}));
+      tree.Remove(index_key, transaction);
+    }
+  }
+
+  // Scenario: iterations see every value of a key, in order of their RIDs.
+  auto expected_pair = expected.begin();
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator, ++expected_pair) {
+    ASSERT_NE(expected_pair, expected.end());
+    EXPECT_EQ((*iterator).first.ToString(), expected_pair->first);
+    EXPECT_EQ((*iterator).second, RID(expected_pair->first, expected_pair->second));
+  }
+  EXPECT_EQ(expected_pair, expected.end());
+  auto reverse_pair = expected.rbegin();
+  for (auto iterator = tree.RBegin(); iterator != tree.End(); ++iterator, ++reverse_pair) {
+    ASSERT_NE(reverse_pair, expected.rend());
+    EXPECT_EQ((*iterator).second, RID(reverse_pair->first, reverse_pair->second));
+  }
+  EXPECT_EQ(reverse_pair, expected.rend());
+  // Scenario: a lookup returns all values of the key.
+  for (int64_t key = 0; key < 300; key++) {
+    index_key.SetFromInteger(key);
+    std::vector<RID> rids;
+    std::vector<RID> expected_rids;
+    for (auto it = expected.lower_bound({key, 0}); it != expected.lower_bound({key + 1, 0}); ++it) {
+      expected_rids.emplace_back(key, it->second);
+    }
+    EXPECT_EQ(!expected_rids.empty(), tree.GetValue(index_key, &rids));
+    EXPECT_EQ(expected_rids, rids);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
@@ -12,15 +12,21 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_builder.h"
 #include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_InsertTest1) {
+TEST(BPlusTreeTests, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -78,7 +84,7 @@ TEST(BPlusTreeTests, DISABLED_InsertTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DISABLED_InsertTest2) {
+TEST(BPlusTreeTests, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -145,4 +151,153 @@ TEST(BPlusTreeTests, DISABLED_InsertTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  // Scenario: sorted in memory or in spilled runs, with full or partly filled pages, pairs in any order with duplicate
+  // keys load into a tree that stays valid under later inserts and removes.
+  for (size_t run_size : {100000, 1000}) {
+    for (double fill_factor : {1.0, 0.6}) {
+      auto *disk_manager = new DiskManager("test.db");
+      BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+      BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5);
+      GenericKey<8> index_key;
+      RID rid;
+      auto *transaction = new Transaction(0);
+      page_id_t page_id;
+      auto header_page = bpm->NewPage(&page_id);
+      (void)header_page;
+
+      std::mt19937 rng(15445);
+      std::set<int64_t> expected;
+      BPlusTreeBuilder<GenericKey<8>, RID, GenericComparator<8>> builder(&tree, comparator, fill_factor, run_size);
+      for (int i = 0; i < 10000; i++) {
+        int64_t key = rng() % 8000;
+        expected.insert(key);
+        index_key.SetFromInteger(key);
+        rid.Set(0, key);
+        builder.Add(index_key, rid);
+      }
+      EXPECT_EQ(run_size < 10000, builder.NumRuns() > 0);
+      EXPECT_EQ(expected.size(), builder.Finish());
+
+      for (int i = 0; i < 10000; i++) {
+        int64_t key = rng() % 10000;
+        index_key.SetFromInteger(key);
+        if (rng() % 2 == 0) {
+          rid.Set(0, key);
+          EXPECT_EQ(expected.insert(key).second, tree.Insert(index_key, rid, transaction));
+        } else {
+          expected.erase(key);
+          tree.Remove(index_key, transaction);
+        }
+      }
+
+      auto expected_key = expected.begin();
+      for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator, ++expected_key) {
+        ASSERT_NE(expected_key, expected.end());
+        EXPECT_EQ((*iterator).second.GetSlotNum(), *expected_key);
+      }
+      EXPECT_EQ(expected_key, expected.end());
+      auto reverse_key = expected.rbegin();
+      for (auto iterator = tree.RBegin(); iterator != tree.End(); ++iterator, ++reverse_key) {
+        ASSERT_NE(reverse_key, expected.rend());
+        EXPECT_EQ((*iterator).second.GetSlotNum(), *reverse_key);
+      }
+      EXPECT_EQ(reverse_key, expected.rend());
+      std::vector<RID> rids;
+      for (int64_t key = 0; key < 10000; key++) {
+        index_key.SetFromInteger(key);
+        EXPECT_EQ(expected.count(key) == 1, tree.GetValue(index_key, &rids));
+      }
+
+      bpm->UnpinPage(HEADER_PAGE_ID, true);
+      delete transaction;
+      delete disk_manager;
+      delete bpm;
+      remove("test.db");
+      remove("test.log");
+    }
+  }
+}
+
+TEST(BPlusTreeTests, CompressionTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a integer,b bigint,c bigint");
+  GenericComparator<64> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", bpm, comparator);
+  GenericKey<64> index_key;
+  RID rid;
+  auto *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  auto set_key = [&](int64_t key) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(static_cast<int32_t>(key % 4)),
+                              ValueFactory::GetBigIntValue(key), ValueFactory::GetBigIntValue(0)};
+    index_key.SetFromKey(Tuple(values, key_schema.get()), key_schema.get());
+  };
+
+  // Scenario: wide composite keys that share their leading columns within a leaf pack leaves fuller than the slots of
+  // uncompressed keys can, and stay in order through splits, merges and redistributions.
+  std::mt19937 rng(15445);
+  std::vector<int64_t> keys(20000);
+  for (int64_t i = 0; i < static_cast<int64_t>(keys.size()); i++) {
+    keys[i] = i;
+  }
+  std::shuffle(keys.begin(), keys.end(), rng);
+  for (int64_t key : keys) {
+    set_key(key);
+    rid.Set(0, key);
+    EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+  }
+
+  Page *page = tree.FindLeafPage(index_key, true);
+  int num_leaves = 0;
+  while (page != nullptr) {
+    num_leaves++;
+    page_id_t next_page_id = reinterpret_cast<BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>> *>(
+                                 page->GetData())
+                                 ->GetNextPageId();
+    bpm->UnpinPage(page->GetPageId(), false);
+    page = next_page_id == INVALID_PAGE_ID ? nullptr : bpm->FetchPage(next_page_id);
+  }
+  EXPECT_LT((PAGE_SIZE - 28) / sizeof(std::pair<GenericKey<64>, RID>), keys.size() / num_leaves);
+
+  // in the order of the key columns
+  std::set<std::pair<int64_t, int64_t>> expected;
+  for (int64_t key : keys) {
+    expected.emplace(key % 4, key);
+  }
+  for (int i = 0; i < 15000; i++) {
+    int64_t key = keys[rng() % keys.size()];
+    set_key(key);
+    expected.erase({key % 4, key});
+    tree.Remove(index_key, transaction);
+  }
+  auto expected_key = expected.begin();
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator, ++expected_key) {
+    ASSERT_NE(expected_key, expected.end());
+    EXPECT_EQ((*iterator).second.GetSlotNum(), expected_key->second);
+  }
+  EXPECT_EQ(expected_key, expected.end());
+  std::vector<RID> rids;
+  for (int64_t key : keys) {
+    set_key(key);
+    EXPECT_EQ(expected.count({key % 4, key}) == 1, tree.GetValue(index_key, &rids));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
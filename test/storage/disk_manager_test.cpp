@@ -10,11 +10,20 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <climits>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <future>  // NOLINT
+#include <memory>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
 
 namespace bustub {
 
@@ -24,21 +33,29 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.pmap");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.pmap");
   };
 };
 
+/** Page I/O tests run both with buffered I/O and with O_DIRECT. */
+class DiskManagerIOModeTest : public DiskManagerTest, public ::testing::WithParamInterface<bool> {};
+
+INSTANTIATE_TEST_SUITE_P(IOModes, DiskManagerIOModeTest, ::testing::Values(false, true),
+                         [](const ::testing::TestParamInfo<bool> &info) { return info.param ? "Direct" : "Buffered"; });
+
 // NOLINTNEXTLINE
-TEST_F(DiskManagerTest, ReadWritePageTest) {
+TEST_P(DiskManagerIOModeTest, ReadWritePageTest) {
   char buf[PAGE_SIZE] = {0};
   char data[PAGE_SIZE] = {0};
   std::string db_file("test.db");
-  auto dm = DiskManager(db_file);
+  auto dm = DiskManager(db_file, GetParam());
   std::strncpy(data, "A test string.", sizeof(data));
 
   dm.ReadPage(0, buf);  // tolerate empty read
@@ -52,7 +69,23 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ReadPage(5, buf);
   EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
 
+  // Scenario: aligned buffers, as handed out by the buffer pool, are read and written in place.
+  alignas(DiskManager::DIRECT_IO_ALIGNMENT) char aligned_buf[PAGE_SIZE] = {0};
+  alignas(DiskManager::DIRECT_IO_ALIGNMENT) char aligned_data[PAGE_SIZE] = {0};
+  std::strncpy(aligned_data, "An aligned test string.", sizeof(aligned_data));
+  dm.WritePage(2, aligned_data);
+  dm.ReadPage(2, aligned_buf);
+  EXPECT_EQ(std::memcmp(aligned_buf, aligned_data, sizeof(aligned_buf)), 0);
+  dm.ReadPage(5, aligned_buf);
+  EXPECT_EQ(std::memcmp(aligned_buf, data, sizeof(aligned_buf)), 0);
+  EXPECT_TRUE(dm.Sync());
+
+  // Scenario: the pages are in the file, whichever way they got there.
   dm.ShutDown();
+  auto reopened = DiskManager(db_file);
+  reopened.ReadPage(2, buf);
+  EXPECT_EQ(std::memcmp(buf, aligned_data, sizeof(buf)), 0);
+  reopened.ShutDown();
 }
 
 // NOLINTNEXTLINE
@@ -73,6 +106,205 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
+TEST_P(DiskManagerIOModeTest, AsyncReadWritePageTest) {
+  const int num_pages = 32;
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<std::vector<char>> buf(num_pages, std::vector<char>(PAGE_SIZE));
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file, GetParam());
+
+  // Scenario: reading past the end of the file yields a zeroed page.
+  buf[0][0] = 'x';
+  EXPECT_TRUE(dm.ReadPageAsync(3, buf[0].data()).get());
+  EXPECT_EQ(0, buf[0][0]);
+
+  // Scenario: many writes in flight at once all land on disk.
+  std::vector<std::future<bool>> writes;
+  for (int i = 0; i < num_pages; i++) {
+    snprintf(data[i].data(), PAGE_SIZE, "page %d", i);
+    writes.emplace_back(dm.WritePageAsync(i, data[i].data()));
+  }
+  for (auto &write : writes) {
+    EXPECT_TRUE(write.get());
+  }
+  EXPECT_EQ(num_pages, dm.GetNumWrites());
+
+  std::vector<std::future<bool>> reads;
+  for (int i = 0; i < num_pages; i++) {
+    reads.emplace_back(dm.ReadPageAsync(i, buf[i].data()));
+  }
+  for (int i = 0; i < num_pages; i++) {
+    EXPECT_TRUE(reads[i].get());
+    EXPECT_EQ(0, std::memcmp(buf[i].data(), data[i].data(), PAGE_SIZE));
+  }
+
+  // Scenario: the synchronous interface sees the asynchronous writes.
+  char page[PAGE_SIZE] = {0};
+  dm.ReadPage(num_pages - 1, page);
+  EXPECT_EQ(0, std::memcmp(page, data[num_pages - 1].data(), PAGE_SIZE));
+
+  // Scenario: aligned buffers go through the scheduler.
+  alignas(DiskManager::DIRECT_IO_ALIGNMENT) char aligned[PAGE_SIZE] = {0};
+  EXPECT_TRUE(dm.ReadPageAsync(1, aligned).get());
+  EXPECT_EQ(0, std::memcmp(aligned, data[1].data(), PAGE_SIZE));
+  aligned[0] = 'y';
+  EXPECT_TRUE(dm.WritePageAsync(num_pages, aligned).get());
+  dm.ReadPage(num_pages, page);
+  EXPECT_EQ(0, std::memcmp(page, aligned, PAGE_SIZE));
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_P(DiskManagerIOModeTest, WritePagesTest) {
+  // more pages than a single pwritev takes
+  const size_t num_pages = IOV_MAX + 10;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file, GetParam());
+  auto *data = static_cast<char *>(aligned_alloc(DiskManager::DIRECT_IO_ALIGNMENT, (num_pages + 1) * PAGE_SIZE));
+  std::vector<const char *> pages;
+  for (size_t i = 0; i < num_pages; i++) {
+    // every tenth page is misaligned on purpose
+    char *page = data + i * PAGE_SIZE + (i % 10 == 9 ? 1 : 0);
+    snprintf(page, PAGE_SIZE, "page %zu", i);
+    pages.push_back(page);
+  }
+
+  // Scenario: a run of consecutive pages lands where WritePage would have put each page.
+  EXPECT_TRUE(dm.WritePages(3, pages.data(), num_pages));
+  EXPECT_EQ(num_pages, dm.GetNumWrites());
+  char buf[PAGE_SIZE];
+  for (size_t i = 0; i < num_pages; i++) {
+    dm.ReadPage(static_cast<page_id_t>(i + 3), buf);
+    EXPECT_EQ(0, std::memcmp(buf, pages[i], PAGE_SIZE));
+  }
+
+  free(data);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressedPagesTest) {
+  const int num_pages = 64;
+  std::string db_file("test.db");
+  auto *dm = new DiskManager(db_file, false, true);
+  EXPECT_TRUE(dm->IsCompressed());
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE, 0));
+  std::mt19937 rng(42);
+  for (int i = 0; i < num_pages; i++) {
+    // a mix of table-like pages with a few distinct values, and pages of random bytes that do not compress
+    for (int j = 0; j < PAGE_SIZE; j++) {
+      data[i][j] = static_cast<char>(i % 4 == 3 ? rng() : (j % 16 < 4 ? j / 16 % 8 + i : 'a' + j % 7));
+    }
+  }
+  char buf[PAGE_SIZE];
+
+  // Scenario: pages read back as written, in a file smaller than the pages, and pages never written read as zeros.
+  for (int i = 0; i < num_pages; i++) {
+    dm->WritePage(i, data[i].data());
+  }
+  for (int i = num_pages - 1; i >= 0; i--) {
+    dm->ReadPage(i, buf);
+    EXPECT_EQ(0, std::memcmp(buf, data[i].data(), PAGE_SIZE));
+  }
+  dm->ReadPage(num_pages + 5, buf);
+  EXPECT_EQ(0, buf[0]);
+  EXPECT_LT(dm->GetStats().bytes_written_, num_pages * PAGE_SIZE / 2);
+
+  // Scenario: a page that no longer compresses moves, and the asynchronous interface sees it.
+  std::vector<char> random(PAGE_SIZE);
+  for (auto &c : random) {
+    c = static_cast<char>(rng());
+  }
+  EXPECT_TRUE(dm->WritePageAsync(0, random.data()).get());
+  EXPECT_TRUE(dm->ReadPageAsync(0, buf).get());
+  EXPECT_EQ(0, std::memcmp(buf, random.data(), PAGE_SIZE));
+  dm->ReadPage(1, buf);
+  EXPECT_EQ(0, std::memcmp(buf, data[1].data(), PAGE_SIZE));
+  data[0] = random;
+
+  // Scenario: a run of pages written at once goes through the page map too.
+  std::vector<const char *> run;
+  for (int i = 0; i < 8; i++) {
+    run.push_back(data[i].data());
+  }
+  EXPECT_TRUE(dm->WritePages(num_pages, run.data(), run.size()));
+  for (int i = 0; i < 8; i++) {
+    dm->ReadPage(num_pages + i, buf);
+    EXPECT_EQ(0, std::memcmp(buf, data[i].data(), PAGE_SIZE));
+  }
+
+  // Scenario: the slots of a deallocated page are reused once the page map is saved.
+  dm->DeallocatePage(3);
+  EXPECT_TRUE(dm->Sync());
+  auto file_size = std::ifstream(db_file, std::ios::binary | std::ios::ate).tellg();
+  dm->WritePage(3, data[3].data());
+  EXPECT_EQ(file_size, std::ifstream(db_file, std::ios::binary | std::ios::ate).tellg());
+
+  // Scenario: syncs while pages keep moving between runs save maps that only point at written images, and never hand
+  // out a run that a saved map or another page still uses.
+  std::thread mover([dm, &data, &random] {
+    for (int round = 0; round < 20; round++) {
+      for (int i = 0; i < num_pages; i += 4) {
+        dm->WritePage(i, round % 2 == 0 ? random.data() : data[i].data());
+      }
+    }
+  });
+  for (int i = 0; i < 20; i++) {
+    EXPECT_TRUE(dm->Sync());
+  }
+  mover.join();
+
+  // Scenario: the page map is saved on shut down, so a reopened database finds every page.
+  dm->ShutDown();
+  delete dm;
+  dm = new DiskManager(db_file, false, true);
+  for (int i = 0; i < num_pages; i++) {
+    dm->ReadPage(i, buf);
+    EXPECT_EQ(0, std::memcmp(buf, data[i].data(), PAGE_SIZE));
+  }
+  dm->ShutDown();
+  delete dm;
+  remove("test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ThreadPoolSchedulerTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  // Scenario: the fallback backend behaves like io_uring.
+  auto scheduler = DiskScheduler::Create(&dm, false);
+  EXPECT_FALSE(scheduler->IsIoUring());
+
+  auto write = std::make_unique<DiskRequest>();
+  write->is_write_ = true;
+  write->data_ = data;
+  write->page_id_ = 7;
+  auto written = write->callback_.get_future();
+  scheduler->Schedule(std::move(write));
+  EXPECT_TRUE(written.get());
+
+  auto read = std::make_unique<DiskRequest>();
+  read->is_write_ = false;
+  read->data_ = buf;
+  read->page_id_ = 7;
+  auto done = read->callback_.get_future();
+  scheduler->Schedule(std::move(read));
+  EXPECT_TRUE(done.get());
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  scheduler.reset();
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ThrowBadFileTest) {
+  EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception);
+  EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db", true), Exception);
+}
 
 }  // namespace bustub
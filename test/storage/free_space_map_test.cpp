@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_test.cpp
+//
+// Identification: test/storage/free_space_map_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/free_space_map.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, FreeClaimTest) {
+  FreeSpaceMap map;
+  EXPECT_EQ(INVALID_PAGE_ID, map.FindFree(0, 1000));
+  EXPECT_FALSE(map.Claim(3));
+
+  // Scenario: freed pages come out lowest first, across extents, and only inside the range.
+  map.Free(200);
+  map.Free(3);
+  map.Free(70);
+  map.Free(3);
+  EXPECT_EQ(3, map.NumFree());
+  EXPECT_EQ(3, map.FindFree(0, 1000));
+  EXPECT_EQ(70, map.FindFree(4, 1000));
+  EXPECT_EQ(200, map.FindFree(71, 1000));
+  EXPECT_EQ(INVALID_PAGE_ID, map.FindFree(71, 200));
+  EXPECT_EQ(INVALID_PAGE_ID, map.FindFree(201, 1000));
+
+  // Scenario: a claimed page is no longer free and cannot be claimed twice.
+  EXPECT_TRUE(map.Claim(70));
+  EXPECT_FALSE(map.Claim(70));
+  EXPECT_FALSE(map.IsFree(70));
+  EXPECT_TRUE(map.IsFree(200));
+  EXPECT_EQ(200, map.FindFree(4, 1000));
+  EXPECT_EQ(2, map.NumFree());
+}
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, PersistenceTest) {
+  const std::string fsm_name = "test.fsm";
+  remove(fsm_name.c_str());
+
+  // Scenario: a saved map loads back, and an empty one removes the file.
+  FreeSpaceMap map;
+  EXPECT_FALSE(map.Load(fsm_name));
+  map.Free(5);
+  map.Free(130);
+  EXPECT_TRUE(map.Save(fsm_name));
+  FreeSpaceMap loaded;
+  EXPECT_TRUE(loaded.Load(fsm_name));
+  EXPECT_EQ(2, loaded.NumFree());
+  EXPECT_EQ(5, loaded.FindFree(0, 1000));
+  EXPECT_EQ(130, loaded.FindFree(6, 1000));
+  EXPECT_TRUE(loaded.Claim(5));
+  EXPECT_TRUE(loaded.Claim(130));
+  EXPECT_TRUE(loaded.Save(fsm_name));
+  EXPECT_FALSE(std::ifstream(fsm_name).good());
+
+  // Scenario: a malformed file is ignored.
+  std::ofstream(fsm_name) << "garbage";
+  EXPECT_FALSE(map.Load(fsm_name));
+  EXPECT_EQ(2, map.NumFree());
+  remove(fsm_name.c_str());
+
+  // Scenario: the disk manager saves its map on shut down and loads it when the database is opened again.
+  auto *disk_manager = new DiskManager("test.db");
+  disk_manager->DeallocatePage(42);
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager("test.db");
+  EXPECT_TRUE(disk_manager->GetFreeSpaceMap()->IsFree(42));
+  EXPECT_EQ(1, disk_manager->GetFreeSpaceMap()->NumFree());
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  remove("test.db");
+  remove("test.log");
+  remove(fsm_name.c_str());
+}
+
+}  // namespace bustub
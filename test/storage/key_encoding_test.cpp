@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_encoding_test.cpp
+//
+// Identification: test/storage/key_encoding_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+auto Encode(const std::vector<Value> &values, Schema *schema) -> GenericKey<32> {
+  GenericKey<32> key;
+  key.SetFromKey(Tuple(values, schema), schema);
+  return key;
+}
+
+/** Check that the keys of the ascending values compare in ascending order and decode to the values. */
+void CheckOrder(const std::vector<Value> &ascending, Schema *schema) {
+  GenericComparator<32> comparator(schema);
+  for (size_t i = 0; i < ascending.size(); i++) {
+    GenericKey<32> key = Encode({ascending[i]}, schema);
+    EXPECT_EQ(CmpBool::CmpTrue, key.ToValue(schema, 0).CompareEquals(ascending[i])) << ascending[i].ToString();
+    EXPECT_EQ(0, comparator(key, key));
+    for (size_t j = i + 1; j < ascending.size(); j++) {
+      GenericKey<32> greater = Encode({ascending[j]}, schema);
+      EXPECT_GT(0, comparator(key, greater)) << ascending[i].ToString() << " < " << ascending[j].ToString();
+      EXPECT_LT(0, comparator(greater, key)) << ascending[j].ToString() << " > " << ascending[i].ToString();
+    }
+  }
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(KeyEncodingTest, OrderTest) {
+  // Scenario: signed integers of every width order across zero.
+  auto schema = ParseCreateStatement("a tinyint");
+  CheckOrder({ValueFactory::GetTinyIntValue(-127), ValueFactory::GetTinyIntValue(-1), ValueFactory::GetTinyIntValue(0),
+              ValueFactory::GetTinyIntValue(1), ValueFactory::GetTinyIntValue(127)},
+             schema.get());
+  schema = ParseCreateStatement("a smallint");
+  CheckOrder({ValueFactory::GetSmallIntValue(-300), ValueFactory::GetSmallIntValue(-2),
+              ValueFactory::GetSmallIntValue(255), ValueFactory::GetSmallIntValue(256)},
+             schema.get());
+  schema = ParseCreateStatement("a integer");
+  CheckOrder({ValueFactory::GetIntegerValue(-70000), ValueFactory::GetIntegerValue(-1),
+              ValueFactory::GetIntegerValue(0), ValueFactory::GetIntegerValue(65536)},
+             schema.get());
+  schema = ParseCreateStatement("a bigint");
+  CheckOrder({ValueFactory::GetBigIntValue(std::numeric_limits<int64_t>::min() + 1),
+              ValueFactory::GetBigIntValue(-(int64_t{1} << 40)), ValueFactory::GetBigIntValue(-1),
+              ValueFactory::GetBigIntValue(0), ValueFactory::GetBigIntValue(int64_t{1} << 40)},
+             schema.get());
+
+  // Scenario: decimals order across zero, fractions and magnitudes.
+  schema = ParseCreateStatement("a double");
+  CheckOrder({ValueFactory::GetDecimalValue(-1e300), ValueFactory::GetDecimalValue(-2.5),
+              ValueFactory::GetDecimalValue(-0.25), ValueFactory::GetDecimalValue(0.0),
+              ValueFactory::GetDecimalValue(1e-300), ValueFactory::GetDecimalValue(0.25),
+              ValueFactory::GetDecimalValue(3.0), ValueFactory::GetDecimalValue(1e300)},
+             schema.get());
+  GenericComparator<32> decimal_comparator(schema.get());
+  EXPECT_EQ(0, decimal_comparator(Encode({ValueFactory::GetDecimalValue(-0.0)}, schema.get()),
+                                  Encode({ValueFactory::GetDecimalValue(0.0)}, schema.get())));
+
+  // Scenario: varchars order by bytes, shorter prefixes first, including embedded zero bytes and high bytes.
+  schema = ParseCreateStatement("a varchar(16)");
+  CheckOrder({ValueFactory::GetVarcharValue(""), ValueFactory::GetVarcharValue(std::string(1, '\0')),
+              ValueFactory::GetVarcharValue(std::string("\0\0", 2)), ValueFactory::GetVarcharValue("\x01"),
+              ValueFactory::GetVarcharValue("a"), ValueFactory::GetVarcharValue(std::string("a\0", 2)),
+              ValueFactory::GetVarcharValue("ab"), ValueFactory::GetVarcharValue("b"),
+              ValueFactory::GetVarcharValue("\xff")},
+             schema.get());
+}
+
+// NOLINTNEXTLINE
+TEST(KeyEncodingTest, CompositeKeyTest) {
+  // Scenario: later columns only break ties of earlier ones, a varchar does not bleed into the next column.
+  auto schema = ParseCreateStatement("a varchar(8),b integer,c double");
+  GenericComparator<32> comparator(schema.get());
+  EXPECT_EQ(32, comparator.CompareSize());
+  auto key = [&schema](const std::string &a, int32_t b, double c) {
+    return Encode(
+        {ValueFactory::GetVarcharValue(a), ValueFactory::GetIntegerValue(b), ValueFactory::GetDecimalValue(c)},
+        schema.get());
+  };
+  EXPECT_GT(0, comparator(key("a", 5, 1.0), key("ab", -5, 1.0)));
+  EXPECT_GT(0, comparator(key("ab", -5, 9.0), key("ab", 0, -9.0)));
+  EXPECT_GT(0, comparator(key("ab", 0, -9.0), key("ab", 0, 0.5)));
+  EXPECT_EQ(0, comparator(key("ab", 0, 0.5), key("ab", 0, 0.5)));
+
+  GenericKey<32> decoded = key("xyz", -42, 2.5);
+  EXPECT_EQ("xyz", decoded.ToValue(schema.get(), 0).ToString());
+  EXPECT_EQ(-42, decoded.ToValue(schema.get(), 1).GetAs<int32_t>());
+  EXPECT_EQ(2.5, decoded.ToValue(schema.get(), 2).GetAs<double>());
+
+  // Scenario: fixed width keys only compare their encoded bytes.
+  schema = ParseCreateStatement("a integer,b smallint");
+  EXPECT_EQ(6, GenericComparator<32>(schema.get()).CompareSize());
+
+  // Scenario: a key longer than the buffer is truncated, columns cut off decode as NULL.
+  schema = ParseCreateStatement("a varchar(64),b bigint");
+  GenericKey<32> truncated =
+      Encode({ValueFactory::GetVarcharValue(std::string(40, 'k')), ValueFactory::GetBigIntValue(7)}, schema.get());
+  EXPECT_TRUE(truncated.ToValue(schema.get(), 0).IsNull());
+  EXPECT_TRUE(truncated.ToValue(schema.get(), 1).IsNull());
+}
+
+// NOLINTNEXTLINE
+TEST(KeyEncodingTest, PrefixTest) {
+  // Scenario: the encoding of leading columns starts the encoding of every key with them, and has their length.
+  auto schema = ParseCreateStatement("a varchar(8),b integer");
+  GenericKey<32> key = Encode({ValueFactory::GetVarcharValue("ab"), ValueFactory::GetIntegerValue(-7)}, schema.get());
+  GenericKey<32> prefix;
+  EXPECT_EQ(4, prefix.SetFromPrefix({ValueFactory::GetVarcharValue("ab")}));
+  EXPECT_EQ(0, memcmp(key.data_, prefix.data_, 4));
+  GenericComparator<32> comparator(schema.get());
+  EXPECT_GT(0, comparator(prefix, key));
+  EXPECT_EQ(8, prefix.SetFromPrefix({ValueFactory::GetVarcharValue("ab"), ValueFactory::GetIntegerValue(-7)}));
+  EXPECT_EQ(0, comparator(prefix, key));
+  EXPECT_EQ(0, prefix.SetFromPrefix({}));
+
+  // Scenario: a prefix longer than the buffer is truncated, its length is not.
+  GenericKey<4> truncated;
+  EXPECT_EQ(8, truncated.SetFromPrefix({ValueFactory::GetVarcharValue("abcdef")}));
+}
+
+// NOLINTNEXTLINE
+TEST(KeyEncodingTest, IntegerKeyTest) {
+  // Scenario: keys built from integers for tests are BIGINT keys.
+  auto schema = ParseCreateStatement("a bigint");
+  GenericComparator<32> comparator(schema.get());
+  GenericKey<32> minus_one;
+  GenericKey<32> one;
+  minus_one.SetFromInteger(-1);
+  one.SetFromInteger(1);
+  EXPECT_GT(0, comparator(minus_one, one));
+  EXPECT_EQ(-1, minus_one.ToString());
+  EXPECT_EQ(1, one.ToValue(schema.get(), 0).GetAs<int64_t>());
+  EXPECT_EQ(0, comparator(one, Encode({ValueFactory::GetBigIntValue(1)}, schema.get())));
+}
+
+}  // namespace bustub
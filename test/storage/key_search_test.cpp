@@ -0,0 +1,189 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_search_test.cpp
+//
+// Identification: test/storage/key_search_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/rid.h"
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "storage/index/key_search.h"
+#include "storage/page/page.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+using KeyPair = std::pair<GenericKey<32>, RID>;
+
+/** Sorted keys built from the given column values, by the comparator that goes through Value. */
+auto MakeKeys(const std::vector<std::vector<Value>> &rows, Schema *schema) -> std::vector<GenericKey<32>> {
+  std::vector<GenericKey<32>> keys;
+  for (const auto &row : rows) {
+    GenericKey<32> key;
+    key.SetFromKey(Tuple(row, schema), schema);
+    keys.push_back(key);
+  }
+  std::sort(keys.begin(), keys.end(), [schema](const GenericKey<32> &a, const GenericKey<32> &b) {
+    for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+      Value lhs = a.ToValue(schema, i);
+      Value rhs = b.ToValue(schema, i);
+      if (lhs.CompareNotEquals(rhs) == CmpBool::CmpTrue) {
+        return lhs.CompareLessThan(rhs) == CmpBool::CmpTrue;
+      }
+    }
+    return false;
+  });
+  return keys;
+}
+
+/**
+ * Lay the keys out in slots like a B+ tree page, without the prefix_size bytes they share and followed by value_size
+ * bytes, and check the kernels against std::lower_bound and std::upper_bound for every key and every prefix of them.
+ */
+void CheckBounds(const std::vector<GenericKey<32>> &keys, const GenericComparator<32> &comparator, size_t prefix_size,
+                 size_t value_size) {
+  size_t key_width = comparator.CompareSize() - prefix_size;
+  size_t slot_width = key_width + value_size;
+  std::vector<char> slots(keys.size() * slot_width, '\x5A');
+  for (size_t i = 0; i < keys.size(); i++) {
+    ASSERT_EQ(0, memcmp(keys[i].data_, keys[0].data_, prefix_size));
+    memcpy(slots.data() + i * slot_width, keys[i].data_ + prefix_size, key_width);
+  }
+  auto less = [&comparator](const GenericKey<32> &a, const GenericKey<32> &b) { return comparator(a, b) < 0; };
+  for (int size = 0; size <= static_cast<int>(keys.size()); size++) {
+    for (const auto &probe : keys) {
+      auto lower = std::lower_bound(keys.begin(), keys.begin() + size, probe, less) - keys.begin();
+      auto upper = std::upper_bound(keys.begin(), keys.begin() + size, probe, less) - keys.begin();
+      const char *suffix = probe.data_ + prefix_size;
+      ASSERT_EQ(lower, KeySearch::LowerBound(slots.data(), slot_width, size, suffix, key_width));
+      ASSERT_EQ(upper, KeySearch::UpperBound(slots.data(), slot_width, size, suffix, key_width));
+    }
+  }
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(KeySearchTest, IntegerKeyTest) {
+  std::mt19937 rng(15445);
+  // Scenario: each integer width, with negative keys and duplicates, searches like the comparator orders, in leaf
+  // slots followed by a RID and in internal slots followed by a page id.
+  for (const auto &[type, sql] : std::vector<std::pair<TypeId, std::string>>{
+           {TypeId::TINYINT, "a tinyint"},
+           {TypeId::SMALLINT, "a smallint"},
+           {TypeId::INTEGER, "a integer"},
+           {TypeId::BIGINT, "a bigint"}}) {
+    auto schema = ParseCreateStatement(sql);
+    GenericComparator<32> comparator(schema.get());
+    ASSERT_GE(sizeof(uint64_t), comparator.CompareSize());
+    std::vector<std::vector<Value>> rows;
+    for (int i = 0; i < 60; i++) {
+      auto value = static_cast<int64_t>(rng() % 200) - 100;
+      rows.push_back({ValueFactory::GetBigIntValue(value).CastAs(type)});
+    }
+    CheckBounds(MakeKeys(rows, schema.get()), comparator, 0, sizeof(RID));
+    CheckBounds(MakeKeys(rows, schema.get()), comparator, 0, sizeof(page_id_t));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(KeySearchTest, CompositeKeyTest) {
+  std::mt19937 rng(15445);
+  // Scenario: keys longer than 8 bytes that lead with an integer break ties on the following columns.
+  auto schema = ParseCreateStatement("a integer,b varchar(4)");
+  GenericComparator<32> comparator(schema.get());
+  ASSERT_LT(sizeof(uint64_t), comparator.CompareSize());
+  std::vector<std::vector<Value>> rows;
+  for (int i = 0; i < 60; i++) {
+    rows.push_back({ValueFactory::GetIntegerValue(static_cast<int32_t>(rng() % 10) - 5),
+                    ValueFactory::GetVarcharValue(std::string(1, static_cast<char>('a' + rng() % 5)))});
+  }
+  CheckBounds(MakeKeys(rows, schema.get()), comparator, 0, sizeof(RID));
+
+  // Scenario: keys that lead with a varchar are ordered by its bytes first.
+  schema = ParseCreateStatement("a varchar(4),b integer");
+  GenericComparator<32> varchar_comparator(schema.get());
+  std::vector<std::vector<Value>> swapped_rows;
+  for (const auto &row : rows) {
+    swapped_rows.push_back({row[1], row[0]});
+  }
+  CheckBounds(MakeKeys(swapped_rows, schema.get()), varchar_comparator, 0, sizeof(RID));
+
+  // Scenario: keys that share their first column are searched by the rest, short enough for one integer or not.
+  schema = ParseCreateStatement("a integer,b integer");
+  GenericComparator<32> integer_comparator(schema.get());
+  std::vector<std::vector<Value>> prefixed_rows;
+  for (int i = 0; i < 60; i++) {
+    prefixed_rows.push_back(
+        {ValueFactory::GetIntegerValue(7), ValueFactory::GetIntegerValue(static_cast<int32_t>(rng() % 200))});
+  }
+  CheckBounds(MakeKeys(prefixed_rows, schema.get()), integer_comparator, sizeof(int32_t), sizeof(RID));
+  CheckBounds(MakeKeys(prefixed_rows, schema.get()), integer_comparator, sizeof(int32_t) + 2, sizeof(page_id_t));
+  schema = ParseCreateStatement("a integer,b varchar(4)");
+  for (auto &row : rows) {
+    row[0] = ValueFactory::GetIntegerValue(7);
+  }
+  CheckBounds(MakeKeys(rows, schema.get()), comparator, sizeof(int32_t), sizeof(RID));
+}
+
+// NOLINTNEXTLINE
+TEST(KeySearchTest, DISABLED_BenchmarkTest) {
+  auto schema = ParseCreateStatement("a bigint");
+  GenericComparator<32> comparator(schema.get());
+  // About a full leaf of uncompressed pairs, and the slots of a leaf that holds the same keys.
+  const int size = static_cast<int>(PAGE_SIZE / sizeof(KeyPair));
+  const size_t slot_width = comparator.CompareSize() + sizeof(RID);
+  std::vector<KeyPair> keys(size);
+  std::vector<char> slots(size * slot_width);
+  for (int i = 0; i < size; i++) {
+    keys[i].first.SetFromInteger(2 * i);
+    memcpy(slots.data() + i * slot_width, keys[i].first.data_, comparator.CompareSize());
+  }
+  std::mt19937 rng(15445);
+  std::vector<GenericKey<32>> probes(1 << 20);
+  for (auto &probe : probes) {
+    probe.SetFromInteger(rng() % (2 * size));
+  }
+
+  // A branchy std::lower_bound over the comparator, as before the kernels.
+  auto less = [&comparator](const KeyPair &item, const GenericKey<32> &key) {
+    return comparator(item.first, key) < 0;
+  };
+  int64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &probe : probes) {
+    checksum += std::lower_bound(keys.begin(), keys.end(), probe, less) - keys.begin();
+  }
+  std::chrono::duration<double> std_elapsed = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (const auto &probe : probes) {
+    checksum -= KeySearch::LowerBound(slots.data(), slot_width, size, probe.data_, comparator.CompareSize());
+  }
+  std::chrono::duration<double> kernel_elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(0, checksum);
+
+  std::printf("%16s %12s\n", "search", "ns/lookup");
+  std::printf("%16s %12.1f\n", "std::lower_bound", std_elapsed.count() * 1e9 / probes.size());
+  std::printf("%16s %12.1f\n", "prefix kernel", kernel_elapsed.count() * 1e9 / probes.size());
+}
+
+}  // namespace bustub
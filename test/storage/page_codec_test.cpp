@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_codec_test.cpp
+//
+// Identification: test/storage/page_codec_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "gtest/gtest.h"
+#include "storage/disk/page_codec.h"
+
+namespace bustub {
+
+namespace {
+
+/** Compress a page into a page sized buffer and back. @return the compressed size */
+auto RoundTrip(const std::vector<char> &page) -> size_t {
+  std::vector<char> compressed(PAGE_SIZE);
+  size_t size = PageCodec::Compress(page.data(), page.size(), compressed.data(), compressed.size());
+  if (size != 0) {
+    std::vector<char> out(page.size(), 'z');
+    EXPECT_TRUE(PageCodec::Decompress(compressed.data(), size, out.data(), out.size()));
+    EXPECT_EQ(page, out);
+  }
+  return size;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(PageCodecTest, RoundTripTest) {
+  std::mt19937 rng(7);
+
+  // Scenario: an empty page shrinks to little more than the length of its one match.
+  std::vector<char> page(PAGE_SIZE, 0);
+  EXPECT_GT(PAGE_SIZE / 128, RoundTrip(page));
+
+  // Scenario: a page of short records with repeating fields compresses well.
+  std::string records;
+  for (int i = 0; records.size() < PAGE_SIZE; i++) {
+    records += "id=" + std::to_string(i) + ";name=customer#" + std::to_string(i % 37) + ";status=ACTIVE;";
+  }
+  page.assign(records.begin(), records.begin() + PAGE_SIZE);
+  EXPECT_GT(PAGE_SIZE / 2, RoundTrip(page));
+
+  // Scenario: long literal runs and long matches need extra length bytes.
+  for (int i = 0; i < PAGE_SIZE; i++) {
+    page[i] = static_cast<char>(i < PAGE_SIZE / 4 ? rng() : (i < PAGE_SIZE / 2 ? 'q' : rng() % 4));
+  }
+  EXPECT_NE(0, RoundTrip(page));
+
+  // Scenario: random bytes do not fit into less than a page.
+  for (auto &c : page) {
+    c = static_cast<char>(rng());
+  }
+  EXPECT_EQ(0, RoundTrip(page));
+
+  // Scenario: blocks of any size round trip, including ones shorter than a match.
+  for (size_t size : {0, 1, 3, 4, 5, 17, 100}) {
+    std::vector<char> block(size, 'b');
+    std::vector<char> compressed(2 * size + 16);
+    size_t compressed_size = PageCodec::Compress(block.data(), size, compressed.data(), compressed.size());
+    std::vector<char> out(size);
+    EXPECT_TRUE(PageCodec::Decompress(compressed.data(), compressed_size, out.data(), size));
+    EXPECT_EQ(block, out);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PageCodecTest, MalformedInputTest) {
+  std::vector<char> page(PAGE_SIZE, 'x');
+  std::vector<char> compressed(PAGE_SIZE);
+  size_t size = PageCodec::Compress(page.data(), page.size(), compressed.data(), compressed.size());
+  ASSERT_NE(0, size);
+  std::vector<char> out(PAGE_SIZE);
+
+  // Scenario: truncated blocks, wrong sizes and offsets before the start are rejected, not read out of bounds.
+  for (size_t cut = 0; cut < size; cut++) {
+    EXPECT_FALSE(PageCodec::Decompress(compressed.data(), cut, out.data(), out.size()));
+  }
+  EXPECT_FALSE(PageCodec::Decompress(compressed.data(), size, out.data(), out.size() - 1));
+  const char bad_offset[] = {0x10, 'x', 0x10, 0x00};
+  EXPECT_FALSE(PageCodec::Decompress(bad_offset, sizeof(bad_offset), out.data(), out.size()));
+}
+
+}  // namespace bustub
@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posting_list_store_test.cpp
+//
+// Identification: test/storage/posting_list_store_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/posting_list_store.h"
+
+namespace bustub {
+
+namespace {
+
+auto Less(const RID &a, const RID &b) -> bool { return a.Get() < b.Get(); }
+
+using RidSet = std::set<RID, decltype(&Less)>;
+
+void CheckList(BufferPoolManager *bpm, const RID &value, const RidSet &expected) {
+  std::vector<RID> rids;
+  PostingListStore::Read(bpm, value, &rids);
+  EXPECT_EQ(expected.size() > 1, PostingListStore::IsPostingList(value));
+  ASSERT_EQ(expected.size(), rids.size());
+  auto expected_rid = expected.begin();
+  for (const RID &rid : rids) {
+    EXPECT_EQ(*expected_rid++, rid);
+  }
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(PostingListStoreTest, CodecTest) {
+  // Scenario: RIDs round trip through the encoding, across pages and with slot numbers of every varint length.
+  std::vector<RID> rids{RID(0, 0), RID(0, 1), RID(0, 200), RID(3, 0), RID(3, 70000), RID(1000000, 5)};
+  std::vector<char> data;
+  PostingListStore::Encode(rids.begin(), rids.end(), &data);
+  std::vector<RID> decoded;
+  PostingListStore::Decode(data.data(), data.size(), &decoded);
+  EXPECT_EQ(rids, decoded);
+
+  // Scenario: consecutive slots on one page, as a growing table hands them out, take two bytes each.
+  rids.clear();
+  for (uint32_t slot = 0; slot < 100; slot++) {
+    rids.emplace_back(7, slot);
+  }
+  data.clear();
+  PostingListStore::Encode(rids.begin(), rids.end(), &data);
+  EXPECT_EQ(2 * rids.size(), data.size());
+}
+
+// NOLINTNEXTLINE
+TEST(PostingListStoreTest, AddRemoveTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  PostingListStore store(bpm);
+
+  // Scenario: the lists of several keys grow from a single RID through shared posting pages into overflow chains of
+  // many pages, and shrink back to a single RID, reading back the same RIDs all along.
+  const int num_keys = 8;
+  std::vector<RID> values;
+  std::vector<RidSet> expected;
+  for (int key = 0; key < num_keys; key++) {
+    values.emplace_back(key, 0);
+    expected.emplace_back(&Less);
+    expected.back().insert(values.back());
+  }
+  std::mt19937 rng(15445);
+  for (int i = 0; i < 40000; i++) {
+    int key = rng() % num_keys;
+    // the first key only grows at its end, the others everywhere
+    RID rid = key == 0 ? RID(i / 100, i % 100 + 1) : RID(rng() % 300, rng() % 100);
+    EXPECT_EQ(expected[key].insert(rid).second, store.Add(&values[key], rid));
+  }
+  for (int key = 0; key < num_keys; key++) {
+    CheckList(bpm, values[key], expected[key]);
+  }
+
+  std::vector<std::vector<RID>> removals(num_keys);
+  for (int key = 0; key < num_keys; key++) {
+    removals[key].assign(expected[key].begin(), expected[key].end());
+    std::shuffle(removals[key].begin(), removals[key].end(), rng);
+    removals[key].pop_back();
+  }
+  for (int round = 0; round < 40000; round++) {
+    int key = rng() % num_keys;
+    if (removals[key].empty()) {
+      continue;
+    }
+    RID rid = removals[key].back();
+    removals[key].pop_back();
+    EXPECT_TRUE(store.Remove(&values[key], rid));
+    expected[key].erase(rid);
+    if (round % 1000 == 0) {
+      CheckList(bpm, values[key], expected[key]);
+    }
+    if (PostingListStore::IsPostingList(values[key])) {
+      EXPECT_FALSE(store.Remove(&values[key], rid));
+    }
+  }
+  for (int key = 0; key < num_keys; key++) {
+    // the RIDs left over take the lists apart one by one
+    while (!removals[key].empty()) {
+      EXPECT_TRUE(store.Remove(&values[key], removals[key].back()));
+      expected[key].erase(removals[key].back());
+      removals[key].pop_back();
+    }
+    CheckList(bpm, values[key], expected[key]);
+    EXPECT_EQ(*expected[key].begin(), values[key]);
+  }
+
+  // Scenario: a list created at once is sorted and free of duplicates.
+  std::vector<RID> rids{RID(2, 1), RID(1, 1), RID(2, 1), RID(1, 0)};
+  RID value = store.Create(&rids);
+  RidSet created(rids.begin(), rids.end(), &Less);
+  EXPECT_EQ(3U, created.size());
+  CheckList(bpm, value, created);
+  store.Free(value);
+
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub